@@ -0,0 +1,156 @@
+// c2pack.cpp
+//
+// Packs .c2 slots into one compact corpus file (sim/c2corpus.h), lists
+// and searches its index, and extracts slots back to .c2 files.
+//
+// Build:
+//   make c2pack
+//
+// Usage:
+//   ./c2pack [-c CODEC] CORPUS FILE.c2...     pack
+//   ./c2pack -l [FILTER] CORPUS               list the index
+//   ./c2pack -x [FILTER] [-o DIR] CORPUS      extract to DIR/NAME.c2
+//                                             (NAME_INDEX.c2 for repeats)
+//
+//   -c   float (lossless), bfp16 (default, 2x) or bfp8 (4x)
+//   -b   filter: band in meters, e.g. 20
+//   -f   filter: dial frequency range in MHz, FROM:TO
+//   -t   filter: slot time range, YYMMDD_HHMM:YYMMDD_HHMM (end exclusive)
+//   -o   directory for extracted files (default .)
+//
+// Packing prints the size against the .c2 originals and the largest
+// sample error seen, as a fraction of its block's peak, next to the
+// codec's bound. Slot times come from wsprd style YYMMDD_HHMM names in
+// the header or the file name.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "sim/c2corpus.h"
+#include "sim/c2file.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-c CODEC] CORPUS FILE.c2...\n"
+                         "       %s -l|-x [-b BAND] [-f FROM:TO] [-t FROM:TO] [-o DIR] CORPUS\n",
+                 prog, prog);
+}
+
+static std::string format_time(int64_t t) {
+    if (t < 0) return "-";
+    time_t tt = (time_t)t;
+    struct tm tm;
+    gmtime_r(&tt, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    C2Codec codec = C2_CODEC_BFP16;
+    bool list = false, extract = false;
+    int band = 0;
+    double min_mhz = 0.0, max_mhz = 0.0;
+    int64_t from = -1, to = -1;
+    const char* dir = ".";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:lxb:f:t:o:")) != -1) {
+        switch (opt) {
+        case 'c':
+            if (!parse_c2_codec(optarg, codec)) {
+                std::fprintf(stderr, "Error: Unknown codec '%s' (float, bfp16, bfp8)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'l': list = true; break;
+        case 'x': extract = true; break;
+        case 'b': band = std::atoi(optarg); break;
+        case 'f':
+            if (std::sscanf(optarg, "%lf:%lf", &min_mhz, &max_mhz) != 2) {
+                std::fprintf(stderr, "Error: -f expects FROM:TO in MHz, got '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 't': {
+            const char* colon = std::strchr(optarg, ':');
+            from = c2_slot_time(optarg);
+            to = colon ? c2_slot_time(colon + 1) : -1;
+            if (from < 0 || to < 0) {
+                std::fprintf(stderr, "Error: -t expects YYMMDD_HHMM:YYMMDD_HHMM, got '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'o': dir = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (list || extract) {
+        if (argc - optind != 1 || (list && extract)) {
+            usage(argv[0]);
+            return 1;
+        }
+        C2CorpusReader corpus;
+        if (!corpus.open(argv[optind])) return 2;
+        std::vector<size_t> hits = corpus.find(from, to, band, min_mhz, max_mhz);
+        if (list) {
+            std::printf("# %zu of %zu slots\n", hits.size(), corpus.size());
+            std::printf("# %-14s %-16s %10s %4s %4s %-5s %6s %10s\n", "name", "utc", "dial_mhz", "band",
+                        "type", "codec", "frames", "bytes");
+            for (size_t h = 0; h < hits.size(); h++) {
+                const C2SlotInfo& s = corpus.slot(hits[h]);
+                std::printf("  %-14s %-16s %10.6f %4d %4d %-5s %6u %10llu\n", s.name.c_str(),
+                            format_time(s.time).c_str(), s.dial_mhz, s.band, s.type, c2_codec_name(s.codec),
+                            s.frames, (unsigned long long)s.bytes);
+            }
+            return 0;
+        }
+        std::vector<float> i, q;
+        std::set<std::string> used;
+        for (size_t h = 0; h < hits.size(); h++) {
+            const C2SlotInfo& s = corpus.slot(hits[h]);
+            corpus.read_slot(hits[h], i, q);
+            std::string name = s.name.empty() ? "slot" : s.name;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".c2") == 0) name.resize(name.size() - 3);
+            // Slots sharing a name get their index appended
+            if (!used.insert(name).second) name += "_" + std::to_string(hits[h]);
+            name += ".c2";
+            std::string path = std::string(dir) + "/" + name;
+            C2MapWriter out;
+            if (!out.open(path.c_str(), s.type, s.dial_mhz, s.name.c_str())) return 2;
+            out.write(0, i.data(), q.data(), i.size());
+            if (!out.close()) return 2;
+            std::printf("→ %s\n", path.c_str());
+        }
+        return 0;
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    C2CorpusWriter corpus;
+    if (!corpus.open(argv[optind], codec)) return 2;
+    int failed = 0;
+    for (int a = optind + 1; a < argc; a++) {
+        if (!corpus.add_file(argv[a])) failed++;
+    }
+    double max_error = corpus.max_error();
+    size_t slots = corpus.slots().size();
+    if (!corpus.close()) return 2;
+
+    struct stat st;
+    long long size = stat(argv[optind], &st) == 0 ? (long long)st.st_size : 0;
+    double original = (double)slots * C2_FILE_SIZE;
+    std::printf("%zu slots, %s: %lld bytes, %.2fx smaller than .c2\n", slots, c2_codec_name(codec), size,
+                size > 0 ? original / size : 0.0);
+    std::printf("max error %.3g of block peak (bound %.3g)\n", max_error, c2_codec_error_bound(codec));
+    return failed ? 2 : 0;
+}
@@ -260,9 +260,9 @@ build_project() {
     fi
     cd ..
     
-    # Build WSPR signal generator
+    # Build WSPR signal generator and simulation tools
     print_status "Building WSPR signal generator..."
-    if g++ -O2 -Wall -std=c++11 wsprsim.cpp -Isrc -L. -ljtencode -o wsprsim; then
+    if make; then
         print_success "WSPR signal generator built successfully"
     else
         print_error "Failed to build WSPR signal generator"
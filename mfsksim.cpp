@@ -0,0 +1,166 @@
+// mfsksim.cpp
+//
+// Render any JTEncode mode (JT65, JT9, JT4, WSPR, FT8, FSQ) as a WAV file.
+//
+// Build:
+//   make mfsksim
+//
+// Usage:
+//   ./mfsksim [-r RATE] [-f BASE_HZ] [-d DELAY_S] MODE OUTPUT.wav MESSAGE...
+//   ./mfsksim [-r RATE] [-f BASE_HZ] [-d DELAY_S] -l MESSAGES.txt FT8 OUTPUT.wav
+//
+// Examples:
+//   ./mfsksim JT65 jt65.wav "N0CALL AA00"
+//   ./mfsksim -r 12000 JT9 jt9.wav "N0CALL AA00"
+//   ./mfsksim WSPR wspr.wav K1ABC FN42 37
+//   ./mfsksim FSQ4.5 fsq.wav N0CALL hello world
+//
+// MESSAGE words are joined with spaces. WSPR takes CALL GRID DBM, FSQ
+// takes FROMCALL followed by the message text.
+//
+// FT8 is rendered as GFSK in 15 second frames with the signal starting
+// 0.5 s in. With -l, every line of MESSAGES.txt becomes one frame of the
+// output, back to back, for building FT8 test corpora.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "sim/ft8_synth.h"
+#include "sim/mfsk.h"
+#include "sim/wav.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-r RATE] [-f BASE_HZ] [-d DELAY_S] MODE OUTPUT.wav MESSAGE...\n", prog);
+    std::fprintf(stderr, "       %s [-r RATE] [-f BASE_HZ] [-d DELAY_S] -l MESSAGES.txt FT8 OUTPUT.wav\n", prog);
+    std::fprintf(stderr, "\nModes: %s\n", mfsk_mode_names());
+    std::fprintf(stderr, "\nExamples:\n");
+    std::fprintf(stderr, "  %s JT65 jt65.wav \"N0CALL AA00\"\n", prog);
+    std::fprintf(stderr, "  %s -r 12000 WSPR wspr.wav K1ABC FN42 37\n", prog);
+    std::fprintf(stderr, "  %s FSQ4.5 fsq.wav N0CALL hello world\n", prog);
+}
+
+// Render FT8 frames as GFSK, one per message
+static int render_ft8(const std::vector<std::string>& messages, const char* out,
+                      int rate, double base, double start) {
+    const MfskMode& mode = *find_mfsk_mode("FT8");
+    Ft8Synth synth(rate);
+    std::vector<float> frame(synth.frame_samples());
+
+    WavWriter wav;
+    if (!wav.open(out, rate)) return 5;
+
+    for (size_t i = 0; i < messages.size(); i++) {
+        uint8_t symbols[MFSK_MAX_SYMBOLS];
+        if (encode_mfsk_message(mode, messages[i].c_str(), symbols) <= 0) {
+            std::fprintf(stderr, "Error: Cannot encode '%s' as FT8\n", messages[i].c_str());
+            return 3;
+        }
+        synth.render_frame(symbols, base, start, 0.5f, frame.data());
+        wav.write(frame.data(), frame.size());
+    }
+    if (!wav.close()) return 5;
+
+    std::printf("FT8: %zu frame(s), %.1f-%.1f Hz, %.2f s at %d Hz → %s\n",
+                messages.size(), base, base + 7 * FT8_TONE_SPACING,
+                (double)wav.samples() / rate, rate, out);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int rate = 48000;
+    double base = -1.0;
+    double delay = -1.0;
+    const char* list = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:d:l:")) != -1) {
+        switch (opt) {
+        case 'r': rate = std::atoi(optarg); break;
+        case 'f': base = std::atof(optarg); break;
+        case 'd': delay = std::atof(optarg); break;
+        case 'l': list = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind < (list ? 2 : 3) || rate < 1000) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const MfskMode* mode = find_mfsk_mode(argv[optind]);
+    if (!mode) {
+        std::fprintf(stderr, "Error: Unknown mode '%s'\n", argv[optind]);
+        std::fprintf(stderr, "Modes: %s\n", mfsk_mode_names());
+        return 2;
+    }
+    const char* out = argv[optind + 1];
+
+    if (list) {
+        if (mode->id != MFSK_FT8) {
+            std::fprintf(stderr, "Error: -l is only supported for FT8\n");
+            return 1;
+        }
+        FILE* f = std::fopen(list, "r");
+        if (!f) {
+            std::fprintf(stderr, "Error: Cannot open %s\n", list);
+            return 1;
+        }
+        std::vector<std::string> messages;
+        char line[256];
+        while (std::fgets(line, sizeof(line), f)) {
+            std::string msg(line);
+            while (!msg.empty() && (msg.back() == '\n' || msg.back() == '\r')) msg.pop_back();
+            if (!msg.empty()) messages.push_back(msg);
+        }
+        std::fclose(f);
+        if (base < 0) base = mode->default_base;
+        return render_ft8(messages, out, rate, base, delay < 0 ? FT8_START_TIME : delay);
+    }
+
+    std::string text;
+    for (int i = optind + 2; i < argc; i++) {
+        if (!text.empty()) text += ' ';
+        text += argv[i];
+    }
+
+    uint8_t symbols[MFSK_MAX_SYMBOLS];
+    int count = encode_mfsk_message(*mode, text.c_str(), symbols);
+    if (count <= 0) {
+        std::fprintf(stderr, "Error: Cannot encode '%s' as %s\n", text.c_str(), mode->name);
+        return 3;
+    }
+
+    if (base < 0) base = mode->default_base;
+    double top = base + (mode->tone_count - 1) * mode->tone_spacing;
+    if (top >= rate / 2.0) {
+        std::fprintf(stderr, "Error: Tones up to %.1f Hz do not fit a %d Hz sample rate\n", top, rate);
+        return 4;
+    }
+
+    if (mode->id == MFSK_FT8) {
+        return render_ft8(std::vector<std::string>(1, text), out, rate, base,
+                          delay < 0 ? FT8_START_TIME : delay);
+    }
+    if (delay < 0) delay = 1.0;
+
+    MfskSynth synth(*mode, symbols, count, rate, base, 0.5f);
+    synth.set_delay((size_t)(delay * rate));
+    synth.set_tail((size_t)(delay * rate));
+
+    WavWriter wav;
+    if (!wav.open(out, rate)) return 5;
+
+    // Stream the whole transmission plus the same trailing silence
+    std::vector<float> block(8192);
+    size_t n;
+    while ((n = synth.render(block.data(), block.size())) > 0) {
+        wav.write(block.data(), n);
+    }
+    if (!wav.close()) return 5;
+
+    std::printf("%s: %d symbols, %.1f-%.1f Hz, %.2f s at %d Hz → %s\n",
+                mode->name, count, base, top, (double)wav.samples() / rate, rate, out);
+    return 0;
+}
@@ -0,0 +1,154 @@
+// rfsched.cpp
+//
+// Builds binary transmit schedules (sim/rfsched.h) for every message of
+// a sympack symbol file, and prints schedules back as text.
+//
+// Build:
+//   make rfsched
+//
+// Usage:
+//   ./rfsched [-f DIAL_MHZ] [-b BASE_HZ] [-u UNITS] IN.sym OUT.rfs
+//   ./rfsched -t [-i INDEX] FILE.rfs
+//
+//   -f   dial frequency in MHz (default 14.0956)
+//   -b   audio frequency of tone 0 (default: the mode's, 1497.8 Hz for
+//        WSPR, matching wsprsim's .rf files)
+//   -u   millihz (default) for integer millihertz, or word:REF_HZ[:BITS]
+//        for DDS tuning words, e.g. word:125000000 for an AD9850
+//   -t   print a schedule, one symbol per line: message, symbol,
+//        frequency in Hz (or tuning word and the frequency it gives)
+//   -i   with -t, only this message
+//
+// Examples:
+//   ./sympack calls.sym calls.txt && ./rfsched calls.sym calls.rfs
+//   ./rfsched -u word:125000000 -f 7.0386 calls.sym calls.rfs
+//   ./rfsched -t -i 0 calls.rfs | head
+//
+// Text is formatted without stdio conversions, so a schedule of a
+// million WSPR messages prints at disk speed.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "sim/mfsk.h"
+#include "sim/rfsched.h"
+#include "sim/symfile.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-f DIAL_MHZ] [-b BASE_HZ] [-u millihz|word:REF_HZ[:BITS]] IN.sym OUT.rfs\n"
+                         "       %s -t [-i INDEX] FILE.rfs\n",
+                 prog, prog);
+}
+
+static int print_schedule(const char* path, long index) {
+    RfScheduleInfo info;
+    std::vector<uint64_t> values;
+    if (!read_rf_schedule(path, info, values)) return 2;
+    bool words = info.format.units == RF_UNITS_TUNING_WORD;
+    uint64_t first = 0, last = info.count;
+    if (index >= 0) {
+        if ((uint64_t)index >= info.count) {
+            std::fprintf(stderr, "Error: %s holds %llu messages\n", path, (unsigned long long)info.count);
+            return 1;
+        }
+        first = (uint64_t)index;
+        last = first + 1;
+    }
+
+    std::string text = "# " + info.mode + ", " + std::to_string(info.count) + " messages of " +
+                       std::to_string(info.symbols) + " symbols, " + std::to_string(info.symbol_ns) +
+                       " ns each, dial ";
+    char field[32];
+    text.append(field, format_scaled(info.dial_millihertz, 3, field));
+    text += " Hz\n";
+    if (words) {
+        text += "# tuning words of " + std::to_string(info.format.word_bits) + " bits, reference ";
+        text.append(field, format_fixed(info.format.ref_clock_hz, 3, field));
+        text += " Hz\n# message symbol word hz\n";
+    } else {
+        text += "# message symbol hz\n";
+    }
+
+    // Whole lines into one buffer, written in large pieces
+    double hz_per_word = words ? info.format.ref_clock_hz / std::ldexp(1.0, info.format.word_bits) : 0.0;
+    for (uint64_t m = first; m < last; m++) {
+        std::string head = std::to_string(m) + ' ';
+        for (uint32_t k = 0; k < info.symbols; k++) {
+            uint64_t v = values[m * info.symbols + k];
+            text += head;
+            text.append(field, format_scaled(k, 0, field));
+            text += ' ';
+            if (words) {
+                text.append(field, format_scaled((int64_t)v, 0, field));
+                text += ' ';
+                text.append(field, format_fixed(v * hz_per_word, 3, field));
+            } else {
+                text.append(field, format_scaled((int64_t)v, 3, field));
+            }
+            text += '\n';
+        }
+        if (text.size() > (1 << 20)) {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            text.clear();
+        }
+    }
+    std::fwrite(text.data(), 1, text.size(), stdout);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    double dial_mhz = 14.0956;
+    double base = -1.0;
+    const char* units = "millihz";
+    bool text = false;
+    long index = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:b:u:ti:")) != -1) {
+        switch (opt) {
+        case 'f': dial_mhz = std::atof(optarg); break;
+        case 'b': base = std::atof(optarg); break;
+        case 'u': units = optarg; break;
+        case 't': text = true; break;
+        case 'i': index = std::atol(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (text) {
+        if (argc - optind != 1) {
+            usage(argv[0]);
+            return 1;
+        }
+        return print_schedule(argv[optind], index);
+    }
+    RfScheduleFormat format;
+    if (argc - optind != 2 || !parse_rf_units(units, format) || dial_mhz < 0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SymbolFileReader in;
+    if (!in.open(argv[optind])) return 2;
+    const MfskMode* mode = find_mfsk_mode(in.mode().c_str());
+    if (!mode) {
+        std::fprintf(stderr, "Error: Unknown mode '%s' in %s\n", in.mode().c_str(), argv[optind]);
+        return 2;
+    }
+    if (base < 0) base = mode->default_base;
+
+    RfScheduleWriter out;
+    if (!out.open(argv[optind + 1], *mode, dial_mhz, format)) return 2;
+    uint8_t symbols[MFSK_MAX_SYMBOLS];
+    for (size_t m = 0; m < in.size(); m++) {
+        in.symbols(m, symbols);
+        if (!out.add(symbols, base)) break;
+    }
+    uint64_t count = out.count();
+    if (!out.close() || count != in.size()) return 2;
+    std::printf("%s: %llu messages at %.6f MHz → %s\n", mode->name, (unsigned long long)count, dial_mhz,
+                argv[optind + 1]);
+    return 0;
+}
@@ -0,0 +1,268 @@
+// artifact.cpp
+//
+// Content-addressed cache of generated files.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "artifact.h"
+
+ArtifactKey::ArtifactKey(const char* tool_version) {
+    add("version", std::string(tool_version));
+}
+
+void ArtifactKey::add(const char* name, const std::string& value) {
+    text_ += name;
+    text_ += '=';
+    text_ += value;
+    text_ += '\n';
+}
+
+void ArtifactKey::add(const char* name, long long value) {
+    add(name, std::to_string(value));
+}
+
+void ArtifactKey::add(const char* name, double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", value);
+    add(name, std::string(buf));
+}
+
+void ArtifactKey::add(const char* name, const uint8_t* data, size_t n) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string hex(2 * n, '0');
+    for (size_t i = 0; i < n; i++) {
+        hex[2 * i] = HEX[data[i] >> 4];
+        hex[2 * i + 1] = HEX[data[i] & 15];
+    }
+    add(name, hex);
+}
+
+uint64_t ArtifactKey::hash() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < text_.size(); i++) {
+        hash ^= (unsigned char)text_[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool parse_cache_spec(const char* text, std::string& dir, uint64_t& max_bytes) {
+    dir = text;
+    max_bytes = 1024ULL << 20;
+    size_t colon = dir.rfind(':');
+    if (colon != std::string::npos) {
+        char* end;
+        double mb = std::strtod(dir.c_str() + colon + 1, &end);
+        if (*end != '\0' || mb <= 0.0) return false;
+        max_bytes = (uint64_t)(mb * (1 << 20));
+        dir.resize(colon);
+    }
+    return !dir.empty();
+}
+
+std::string executable_hash() {
+    static const std::string hex = []() {
+        FILE* f = std::fopen("/proc/self/exe", "rb");
+        if (!f) return std::string();
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        unsigned char buf[65536];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                hash ^= buf[i];
+                hash *= 0x100000001b3ULL;
+            }
+        }
+        bool ok = !std::ferror(f);
+        std::fclose(f);
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+        return ok ? std::string(text) : std::string();
+    }();
+    return hex;
+}
+
+// Every byte of in to out, in the kernel
+static bool copy_fd(int in, int out) {
+    for (;;) {
+        ssize_t n = sendfile(out, in, NULL, 1 << 30);
+        if (n == 0) return true;
+        if (n < 0 && errno != EINTR) return false;
+    }
+}
+
+// Make dst, a new file, the same content as src: a clone (reflink) on
+// file systems that share extents, else a copy. Never a hard link, since
+// tools that rewrite their output in place would write into the cache.
+static bool place_file(const char* src, const char* dst) {
+    int in = ::open(src, O_RDONLY);
+    if (in < 0) return false;
+    int out = ::open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = out >= 0 && (ioctl(out, FICLONE, in) == 0 || copy_fd(in, out));
+    if (out >= 0 && ::close(out) != 0) ok = false;
+    ::close(in);
+    if (!ok) unlink(dst);
+    return ok;
+}
+
+static bool read_text(const std::string& path, std::string& text) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char buf[4096];
+    size_t n;
+    text.clear();
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+// Write through a temporary name so readers never see half a file
+static bool write_text(const std::string& path, const std::string& text) {
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    if (std::fclose(f) != 0) ok = false;
+    ok = ok && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) unlink(tmp.c_str());
+    return ok;
+}
+
+static bool make_dirs(const std::string& dir) {
+    for (size_t pos = 1; pos <= dir.size(); pos++) {
+        if (pos < dir.size() && dir[pos] != '/') continue;
+        std::string part = dir.substr(0, pos);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+    struct stat st;
+    return stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+ArtifactCache::ArtifactCache()
+    : max_bytes_(0), hits_(0), misses_(0), store_failures_(0), stored_bytes_(0), entries_(0), total_bytes_(0),
+      evicted_(0) {}
+
+bool ArtifactCache::open(const char* dir, uint64_t max_bytes) {
+    if (!make_dirs(dir)) {
+        std::fprintf(stderr, "Error: Cannot create cache directory %s\n", dir);
+        return false;
+    }
+    dir_ = dir;
+    max_bytes_ = max_bytes;
+    return true;
+}
+
+std::string ArtifactCache::entry_base(const ArtifactKey& key) const {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key.hash());
+    return dir_ + "/" + hex;
+}
+
+// ".wav" for "out/wspr_normal.wav", "" without an extension
+static std::string extension(const char* path) {
+    const char* slash = std::strrchr(path, '/');
+    const char* dot = std::strrchr(slash ? slash : path, '.');
+    return dot ? dot : "";
+}
+
+bool ArtifactCache::fetch(const ArtifactKey& key, const char* dest) {
+    if (!is_open()) return false;
+    std::string base = entry_base(key);
+    std::string entry = base + extension(dest);
+    std::string stored;
+    bool hit = read_text(base + ".key", stored) && stored == key.text() && access(entry.c_str(), R_OK) == 0;
+    if (hit) {
+        hit = (unlink(dest) == 0 || errno == ENOENT) && place_file(entry.c_str(), dest);
+        // The modification time orders entries for eviction
+        if (hit) utimensat(AT_FDCWD, entry.c_str(), NULL, 0);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (hit) hits_++;
+    else misses_++;
+    return hit;
+}
+
+bool ArtifactCache::store(const ArtifactKey& key, const char* src) {
+    if (!is_open()) return false;
+    std::string base = entry_base(key);
+    std::string entry = base + extension(src);
+    std::string tmp = entry + ".tmp" + std::to_string(getpid());
+    unlink(tmp.c_str());
+    struct stat st;
+    bool ok = place_file(src, tmp.c_str()) && chmod(tmp.c_str(), 0444) == 0 && stat(tmp.c_str(), &st) == 0 &&
+              std::rename(tmp.c_str(), entry.c_str()) == 0 && write_text(base + ".key", key.text());
+    if (!ok) {
+        unlink(tmp.c_str());
+        std::fprintf(stderr, "Warning: Could not cache %s in %s\n", src, dir_.c_str());
+        std::lock_guard<std::mutex> lock(mutex_);
+        store_failures_++;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stored_bytes_ += (uint64_t)st.st_size;
+    return true;
+}
+
+void ArtifactCache::trim() {
+    if (!is_open()) return;
+    struct Entry {
+        double mtime;
+        uint64_t bytes;
+        std::string name;
+        bool operator<(const Entry& other) const { return mtime < other.mtime; }
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    DIR* d = opendir(dir_.c_str());
+    if (!d) return;
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        std::string name = e->d_name;
+        size_t dot = name.rfind('.');
+        if (name[0] == '.' || name.find(".tmp") != std::string::npos ||
+            (dot != std::string::npos && name.compare(dot, std::string::npos, ".key") == 0)) {
+            continue;
+        }
+        struct stat st;
+        if (stat((dir_ + "/" + name).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        Entry entry = {st.st_mtim.tv_sec + st.st_mtim.tv_nsec * 1e-9, (uint64_t)st.st_size, name};
+        entries.push_back(entry);
+        total += entry.bytes;
+    }
+    closedir(d);
+
+    std::sort(entries.begin(), entries.end());
+    size_t k = 0;
+    for (; k < entries.size() && total > max_bytes_; k++) {
+        std::string path = dir_ + "/" + entries[k].name;
+        size_t dot = entries[k].name.rfind('.');
+        std::string key_path = dir_ + "/" + entries[k].name.substr(0, dot) + ".key";
+        unlink(path.c_str());
+        unlink(key_path.c_str());
+        total -= entries[k].bytes;
+        evicted_++;
+    }
+    entries_ = entries.size() - k;
+    total_bytes_ = total;
+}
+
+void ArtifactCache::print_stats(FILE* out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::fprintf(out, "cache %s: %zu hit%s, %zu miss%s, %.1f MB added; %zu entries, %.1f of %.1f MB",
+                 dir_.c_str(), hits_, hits_ == 1 ? "" : "s", misses_, misses_ == 1 ? "" : "es",
+                 stored_bytes_ / 1048576.0, entries_, total_bytes_ / 1048576.0, max_bytes_ / 1048576.0);
+    if (evicted_) std::fprintf(out, ", %zu evicted", evicted_);
+    if (store_failures_) std::fprintf(out, ", %zu not stored", store_failures_);
+    std::fprintf(out, "\n");
+}
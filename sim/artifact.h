@@ -0,0 +1,94 @@
+// artifact.h
+//
+// Content-addressed cache of generated files. A generator describes
+// each output by a key, its tool's render version and every parameter
+// that shapes the output, added in a fixed order, and the cache keeps
+// the file under the key's 64-bit FNV-1a hash:
+//
+//   DIR/HASH.EXT   the artifact, read-only
+//   DIR/HASH.key   the key text, compared on lookup so that a hash
+//                  collision is a miss and never the wrong file
+//
+// Hits are cloned (reflink) to the destination where the file system
+// shares extents and copied elsewhere, never hard linked, so the output
+// is an ordinary writable file and rewriting it leaves the cache alone.
+// Their modification time is bumped so trim() evicts the least recently
+// used entries first. fetch() and store() may run on several threads at
+// once.
+
+#ifndef ARTIFACT_H
+#define ARTIFACT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+class ArtifactKey {
+public:
+    explicit ArtifactKey(const char* tool_version);
+
+    // name=value lines; doubles keep every bit (%.17g)
+    void add(const char* name, const std::string& value);
+    void add(const char* name, long long value);
+    void add(const char* name, double value);
+    // Binary data as hex, e.g. a symbol vector
+    void add(const char* name, const uint8_t* data, size_t n);
+
+    const std::string& text() const { return text_; }
+    uint64_t hash() const;
+
+private:
+    std::string text_;
+};
+
+class ArtifactCache {
+public:
+    ArtifactCache();
+
+    // Use directory dir (created if missing) bounded to max_bytes
+    bool open(const char* dir, uint64_t max_bytes);
+    bool is_open() const { return !dir_.empty(); }
+
+    // Place the artifact for key at dest, replacing dest; false on a miss.
+    // The artifact's extension is dest's.
+    bool fetch(const ArtifactKey& key, const char* dest);
+    // Add the file at src as the artifact for key; a failure is warned
+    // about and counted by print_stats()
+    bool store(const ArtifactKey& key, const char* src);
+    // Evict least recently used entries until the cache fits its bound
+    void trim();
+
+    // "cache DIR: 2 hits, 1 miss, ..." with sizes, as of the last trim()
+    void print_stats(FILE* out) const;
+
+private:
+    ArtifactCache(const ArtifactCache&);
+    ArtifactCache& operator=(const ArtifactCache&);
+
+    // DIR/HASH, without the extension
+    std::string entry_base(const ArtifactKey& key) const;
+
+    std::string dir_;
+    uint64_t max_bytes_;
+    mutable std::mutex mutex_;
+    size_t hits_;
+    size_t misses_;
+    size_t store_failures_;
+    uint64_t stored_bytes_;
+    size_t entries_;
+    uint64_t total_bytes_;
+    size_t evicted_;
+};
+
+// Parse DIR[:MAX_MB] (default 1024 MB)
+bool parse_cache_spec(const char* text, std::string& dir, uint64_t& max_bytes);
+
+// 64-bit FNV-1a of the running executable (/proc/self/exe) in hex, read
+// once; "" if it cannot be read. Keys that carry it never match files a
+// tool built from other code rendered, including code it links in from
+// static libraries.
+std::string executable_hash();
+
+#endif
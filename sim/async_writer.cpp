@@ -0,0 +1,70 @@
+// async_writer.cpp
+//
+// Ordered file output on a dedicated I/O thread.
+
+#include <cstring>
+#include "async_writer.h"
+
+AsyncWriter::AsyncWriter(size_t depth) : f_(NULL), depth_(depth > 0 ? depth : 1), stop_(false), ok_(true) {}
+
+AsyncWriter::~AsyncWriter() {
+    finish();
+}
+
+void AsyncWriter::start(FILE* f) {
+    finish();
+    f_ = f;
+    stop_ = false;
+    ok_ = true;
+    thread_ = std::thread(&AsyncWriter::run, this);
+}
+
+bool AsyncWriter::write(const void* data, size_t n) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_.wait(lock, [this]() { return queue_.size() < depth_ || !ok_; });
+    if (!ok_ || !f_) return false;
+    // Reuse a written block's buffer
+    std::vector<char> block;
+    if (!spare_.empty()) {
+        block.swap(spare_.back());
+        spare_.pop_back();
+    }
+    block.assign(static_cast<const char*>(data), static_cast<const char*>(data) + n);
+    queue_.push_back(std::vector<char>());
+    queue_.back().swap(block);
+    ready_.notify_one();
+    return true;
+}
+
+bool AsyncWriter::finish() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        ready_.notify_one();
+        thread_.join();
+    }
+    f_ = NULL;
+    spare_.clear();
+    return ok_;
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        ready_.wait(lock, [this]() { return !queue_.empty() || stop_; });
+        if (queue_.empty()) break;
+        std::vector<char> block;
+        block.swap(queue_.front());
+        // Unlocked while writing, so the producer can queue the next one
+        lock.unlock();
+        bool ok = std::fwrite(block.data(), 1, block.size(), f_) == block.size();
+        lock.lock();
+        queue_.pop_front();
+        if (!ok) ok_ = false;
+        spare_.push_back(std::vector<char>());
+        spare_.back().swap(block);
+        space_.notify_one();
+    }
+}
@@ -0,0 +1,50 @@
+// async_writer.h
+//
+// Ordered file output on a dedicated I/O thread: write() queues a copy
+// of the data and returns, so a producer keeps synthesizing while the
+// previous blocks go to disk. At most depth blocks wait at once, and
+// write() blocks past that, bounding memory.
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AsyncWriter {
+public:
+    explicit AsyncWriter(size_t depth = 8);
+    ~AsyncWriter();
+
+    // Start writing to f, which stays open and owned by the caller
+    void start(FILE* f);
+    // Queue n bytes; false once a write has failed
+    bool write(const void* data, size_t n);
+    // Wait until everything queued is written and stop the thread;
+    // false if any write failed
+    bool finish();
+
+private:
+    AsyncWriter(const AsyncWriter&);
+    AsyncWriter& operator=(const AsyncWriter&);
+
+    void run();
+
+    FILE* f_;
+    size_t depth_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable ready_;     // a block was queued, or stop
+    std::condition_variable space_;     // a block was written
+    std::deque<std::vector<char> > queue_;
+    std::vector<std::vector<char> > spare_;
+    bool stop_;
+    bool ok_;
+};
+
+#endif
@@ -0,0 +1,176 @@
+// band.cpp
+//
+// Many WSPR-2 transmissions mixed into one slot.
+
+#include <algorithm>
+#include <cmath>
+#include "band.h"
+#include "nco.h"
+#include "noise.h"
+#include "parallel.h"
+#include "synth.h"
+
+// Output samples per tile: 16 KB of float stays in L1 while every
+// overlapping signal is added to it
+static const size_t TILE = 4096;
+static const uint32_t QUARTER_CYCLE = 1u << 30;
+
+// Add amplitude * sin of a tone to n samples of out_i or, for complex
+// baseband, amplitude * cos to out_i and amplitude * sin to out_q. LANES
+// phasors, each one sample apart, are rotated together by LANES samples;
+// a segment never spans more than one tile, so float rounding in the
+// rotation stays below 1e-4 before the next tile restarts from the exact
+// phase word.
+static const int LANES = 8;
+
+template <bool COMPLEX>
+static void add_tone(const float* table, uint32_t phase, uint32_t step, float amplitude,
+                     float* out_i, float* out_q, size_t n) {
+    float re[LANES], im[LANES];
+    for (int l = 0; l < LANES; l++) {
+        uint32_t p = phase + step * (uint32_t)l;
+        re[l] = amplitude * nco_lookup(table, p + QUARTER_CYCLE);
+        im[l] = amplitude * nco_lookup(table, p);
+    }
+    uint32_t jump = step * (uint32_t)LANES;
+    float rot_re = nco_lookup(table, jump + QUARTER_CYCLE);
+    float rot_im = nco_lookup(table, jump);
+
+    size_t j = 0;
+    for (; j + LANES <= n; j += LANES) {
+        for (int l = 0; l < LANES; l++) {
+            if (COMPLEX) {
+                out_i[j + l] += re[l];
+                out_q[j + l] += im[l];
+            } else {
+                out_i[j + l] += im[l];
+            }
+            float r = re[l] * rot_re - im[l] * rot_im;
+            im[l] = re[l] * rot_im + im[l] * rot_re;
+            re[l] = r;
+        }
+    }
+    for (int l = 0; j < n; j++, l++) {
+        if (COMPLEX) {
+            out_i[j] += re[l];
+            out_q[j] += im[l];
+        } else {
+            out_i[j] += im[l];
+        }
+    }
+}
+
+BandMixer::BandMixer(const std::vector<BandSignal>& signals, double sample_rate, double noise_sigma)
+    : signals_(signals), sample_rate_(sample_rate), noise_sigma_(noise_sigma) {
+    symbol_length_ = (size_t)llround(sample_rate * 8192.0 / 12000.0);
+    ramp_ = (size_t)llround(0.02 * sample_rate);
+}
+
+size_t BandMixer::slot_samples() const {
+    return (size_t)llround(BAND_SLOT_SECONDS * sample_rate_);
+}
+
+size_t BandMixer::signal_start(size_t index) const {
+    double start = (1.0 + signals_[index].dt) * sample_rate_;
+    return start > 0.0 ? (size_t)llround(start) : 0;
+}
+
+size_t BandMixer::signal_end(size_t index) const {
+    return signal_start(index) + symbol_length_ * WSPR_SYMBOL_COUNT;
+}
+
+void BandMixer::build_tracks(std::vector<Track>& tracks, double center, bool complex) const {
+    Nco nco(sample_rate_);
+    double spacing = sample_rate_ / symbol_length_;
+    double half = WSPR_SYMBOL_COUNT / 2;
+
+    tracks.resize(signals_.size());
+    for (size_t s = 0; s < signals_.size(); s++) {
+        const BandSignal& sig = signals_[s];
+        Track& t = tracks[s];
+        t.start = signal_start(s);
+
+        // Complex baseband carries the full power in one exponential
+        double amplitude = snr_amplitude(noise_sigma_, sig.snr, sample_rate_);
+        t.amplitude = (float)(complex ? amplitude / std::sqrt(2.0) : amplitude);
+
+        nco.set_phase(sig.phase);
+        uint32_t phase = nco.phase_word();
+        for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+            double f = sig.freq - center + sig.drift / 2.0 * (k - half) / half
+                     + (sig.symbols[k] - 1.5) * spacing;
+            t.step[k] = nco.step_for(f);
+            t.phase[k] = phase;
+            phase += t.step[k] * (uint32_t)symbol_length_;
+        }
+    }
+}
+
+void BandMixer::render_tile(const std::vector<Track>& tracks, float* out_i, float* out_q,
+                            size_t begin, size_t end) const {
+    const float* table = nco_sine_table();
+    size_t length = symbol_length_ * WSPR_SYMBOL_COUNT;
+
+    for (size_t s = 0; s < tracks.size(); s++) {
+        const Track& t = tracks[s];
+        size_t a = std::max(begin, t.start);
+        size_t b = std::min(end, t.start + length);
+        if (a >= b) continue;
+
+        // Symbol segments inside the tile; the phase at any sample follows
+        // from the symbol start phase, so tiles are independent
+        for (size_t pos = a; pos < b; ) {
+            size_t rel = pos - t.start;
+            size_t k = rel / symbol_length_;
+            size_t seg_end = std::min(b, t.start + (k + 1) * symbol_length_);
+            uint32_t step = t.step[k];
+            uint32_t phase = t.phase[k] + step * (uint32_t)(rel - k * symbol_length_);
+            size_t off = pos - begin;
+            if (out_q) add_tone<true>(table, phase, step, t.amplitude, out_i + off, out_q + off, seg_end - pos);
+            else add_tone<false>(table, phase, step, t.amplitude, out_i + off, NULL, seg_end - pos);
+            pos = seg_end;
+        }
+
+        // Take the 20 ms raised cosine ramps back out of the edges. The
+        // ramps lie inside the first and last symbols.
+        size_t ramp_ends[2] = {t.start, t.start + length - ramp_};
+        for (int e = 0; e < 2; e++) {
+            size_t ra = std::max(a, ramp_ends[e]);
+            size_t rb = std::min(b, ramp_ends[e] + ramp_);
+            int k = e == 0 ? 0 : WSPR_SYMBOL_COUNT - 1;
+            for (size_t pos = ra; pos < rb; pos++) {
+                size_t rel = pos - t.start;
+                size_t j = pos - ramp_ends[e];
+                double x = e == 0 ? 1.0 - (double)j / ramp_ : (double)j / ramp_;
+                float cut = t.amplitude * (float)(1.0 - raised_cosine(x));
+                uint32_t phase = t.phase[k] + t.step[k] * (uint32_t)(rel - k * symbol_length_);
+                if (out_q) {
+                    out_i[pos - begin] -= cut * nco_lookup(table, phase + QUARTER_CYCLE);
+                    out_q[pos - begin] -= cut * nco_lookup(table, phase);
+                } else {
+                    out_i[pos - begin] -= cut * nco_lookup(table, phase);
+                }
+            }
+        }
+    }
+}
+
+void BandMixer::mix(float* out_i, float* out_q, size_t n, double center, int threads) const {
+    std::vector<Track> tracks;
+    build_tracks(tracks, center, out_q != NULL);
+
+    size_t tiles = (n + TILE - 1) / TILE;
+    parallel_for(tiles, threads, [&](size_t tile) {
+        size_t begin = tile * TILE;
+        size_t end = std::min(n, begin + TILE);
+        render_tile(tracks, out_i + begin, out_q ? out_q + begin : NULL, begin, end);
+    });
+}
+
+void BandMixer::mix_audio(float* out, size_t n, int threads) const {
+    mix(out, NULL, n, 0.0, threads);
+}
+
+void BandMixer::mix_baseband(float* out_i, float* out_q, size_t n, double center, int threads) const {
+    mix(out_i, out_q, n, center, threads);
+}
@@ -0,0 +1,73 @@
+// band.h
+//
+// Many WSPR-2 transmissions mixed into one 2 minute slot, each with its
+// own audio frequency, time offset, SNR and drift.
+//
+// Drift follows WSJT-X wsprsim: the frequency steps once per symbol along
+// a line through the center frequency at the middle of the message, so
+// drift is the total change in Hz over the transmission.
+
+#ifndef BAND_H
+#define BAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "JTEncode.h"
+
+const double BAND_SLOT_SECONDS = 120.0;
+
+struct BandSignal {
+    uint8_t symbols[WSPR_SYMBOL_COUNT];
+    double freq;    // audio center frequency (Hz), between tones 1 and 2
+    double dt;      // start time relative to the nominal 1 s (s)
+    double snr;     // dB in 2500 Hz against the mixer's noise sigma
+    double drift;   // total frequency change over the transmission (Hz)
+    double phase;   // start phase (radians)
+};
+
+// Mixes a list of signals into real audio or complex baseband. Rendering
+// is split into cache-sized tiles of the output shared out between
+// threads; each tile sums the signals overlapping it, so threads never
+// write the same samples.
+class BandMixer {
+public:
+    // sample_rate must give a whole number of samples per symbol (a
+    // multiple of 375/8 Hz). Amplitudes are set so each signal has its
+    // SNR against white noise of noise_sigma per real sample (per I and
+    // Q component for baseband).
+    BandMixer(const std::vector<BandSignal>& signals, double sample_rate, double noise_sigma);
+
+    size_t symbol_length() const { return symbol_length_; }
+    size_t slot_samples() const;
+
+    // First sample of a signal and one past its last
+    size_t signal_start(size_t index) const;
+    size_t signal_end(size_t index) const;
+
+    // Add all signals as real audio to out[0..n), sample 0 at the slot start
+    void mix_audio(float* out, size_t n, int threads) const;
+    // Add all signals as complex baseband, offset by center Hz
+    void mix_baseband(float* out_i, float* out_q, size_t n, double center, int threads) const;
+
+private:
+    struct Track {
+        size_t start;
+        float amplitude;
+        uint32_t step[WSPR_SYMBOL_COUNT];
+        uint32_t phase[WSPR_SYMBOL_COUNT];   // phase word at each symbol start
+    };
+
+    void build_tracks(std::vector<Track>& tracks, double center, bool complex) const;
+    void render_tile(const std::vector<Track>& tracks, float* out_i, float* out_q,
+                     size_t begin, size_t end) const;
+    void mix(float* out_i, float* out_q, size_t n, double center, int threads) const;
+
+    const std::vector<BandSignal>& signals_;
+    double sample_rate_;
+    double noise_sigma_;
+    size_t symbol_length_;
+    size_t ramp_;
+};
+
+#endif
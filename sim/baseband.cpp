@@ -0,0 +1,140 @@
+// baseband.cpp
+//
+// Audio to .c2-rate complex baseband.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "baseband.h"
+#include "c2file.h"
+#include "nco.h"
+#include "wav.h"
+
+bool c2_ratio(int sample_rate, int type, int& up, int& down) {
+    // Both rates in eighths of a Hz, which makes the WSPR-15 rate whole
+    if (sample_rate <= 0 || sample_rate > 0x7fffffff / 8) {
+        std::fprintf(stderr, "Error: Invalid sample rate %d\n", sample_rate);
+        return false;
+    }
+    return resample_ratio(8 * sample_rate, (int)(8 * c2_sample_rate(type)), up, down);
+}
+
+Downconverter::Downconverter(int sample_rate, double center, int up, int down)
+    : sample_rate_(sample_rate), up_(up), down_(down), nco_(sample_rate), rs_i_(up, down),
+      rs_q_(up, down), skip_((uint64_t)rs_i_.delay()), emitted_(0) {
+    nco_.set_freq(-center);
+}
+
+// Drop the filter's delayed outputs from I/Q outputs appended after
+// first, and any past limit outputs in total. Returns the count kept.
+static size_t trim_delay(std::vector<float>& out_i, std::vector<float>& out_q, size_t first,
+                         uint64_t& skip, uint64_t& emitted, uint64_t limit) {
+    size_t drop = (size_t)std::min<uint64_t>(skip, out_i.size() - first);
+    out_i.erase(out_i.begin() + first, out_i.begin() + first + drop);
+    out_q.erase(out_q.begin() + first, out_q.begin() + first + drop);
+    skip -= drop;
+    size_t count = out_i.size() - first;
+    if (emitted + count > limit) {
+        count = (size_t)(limit - emitted);
+        out_i.resize(first + count);
+        out_q.resize(first + count);
+    }
+    emitted += count;
+    return count;
+}
+
+size_t Downconverter::process(const float* audio, size_t n, std::vector<float>& out_i,
+                              std::vector<float>& out_q) {
+    size_t first = out_i.size();
+    const size_t CHUNK = 8192;
+    if (mix_i_.size() < CHUNK) {
+        mix_i_.resize(CHUNK);
+        mix_q_.resize(CHUNK);
+    }
+    for (size_t pos = 0; pos < n; pos += CHUNK) {
+        size_t len = std::min(CHUNK, n - pos);
+        nco_.generate_iq(mix_i_.data(), mix_q_.data(), len, 1.0f);
+        for (size_t k = 0; k < len; k++) {
+            mix_i_[k] *= audio[pos + k];
+            mix_q_[k] *= audio[pos + k];
+        }
+        rs_i_.process(mix_i_.data(), len, out_i);
+        rs_q_.process(mix_q_.data(), len, out_q);
+    }
+    return trim_delay(out_i, out_q, first, skip_, emitted_, ~0ull);
+}
+
+size_t Downconverter::flush(std::vector<float>& out_i, std::vector<float>& out_q) {
+    size_t first = out_i.size();
+    uint64_t limit = rs_i_.expected_outputs();
+    rs_i_.flush(out_i);
+    rs_q_.flush(out_q);
+    return trim_delay(out_i, out_q, first, skip_, emitted_, limit);
+}
+
+Upconverter::Upconverter(double in_rate, double center, int up, int down, float gain)
+    : in_rate_(in_rate), up_(up), down_(down), gain_(gain), nco_(in_rate * up / down),
+      rs_i_(up, down), rs_q_(up, down), skip_((uint64_t)rs_i_.delay()), emitted_(0) {
+    nco_.set_freq(center);
+}
+
+// Mix the interpolated I/Q waiting in bb_i_, bb_q_ up to audio
+size_t Upconverter::mix(std::vector<float>& audio, uint64_t limit) {
+    size_t n = trim_delay(bb_i_, bb_q_, 0, skip_, emitted_, limit);
+    if (osc_i_.size() < n) {
+        osc_i_.resize(n);
+        osc_q_.resize(n);
+    }
+    nco_.generate_iq(osc_i_.data(), osc_q_.data(), n, 2.0f * gain_);
+    size_t first = audio.size();
+    audio.resize(first + n);
+    float* out = &audio[first];
+    for (size_t k = 0; k < n; k++) out[k] = bb_i_[k] * osc_i_[k] - bb_q_[k] * osc_q_[k];
+    bb_i_.clear();
+    bb_q_.clear();
+    return n;
+}
+
+size_t Upconverter::process(const float* in_i, const float* in_q, size_t n, std::vector<float>& audio) {
+    rs_i_.process(in_i, n, bb_i_);
+    rs_q_.process(in_q, n, bb_q_);
+    return mix(audio, ~0ull);
+}
+
+size_t Upconverter::flush(std::vector<float>& audio) {
+    uint64_t limit = rs_i_.expected_outputs();
+    rs_i_.flush(bb_i_);
+    rs_q_.flush(bb_q_);
+    return mix(audio, limit);
+}
+
+bool is_c2_path(const char* path) {
+    size_t len = std::strlen(path);
+    return len > 3 && std::strcmp(path + len - 3, ".c2") == 0;
+}
+
+bool read_baseband(const char* path, double center, std::vector<float>& out_i,
+                   std::vector<float>& out_q, double& rate) {
+    if (is_c2_path(path)) {
+        int type;
+        if (!read_c2_file(path, out_i, out_q, &type)) return false;
+        rate = c2_sample_rate(type);
+        return true;
+    }
+    // WAV block by block, so only the baseband is ever held in memory
+    WavReader in;
+    int up, down;
+    if (!in.open(path) || !c2_ratio(in.sample_rate(), 2, up, down)) return false;
+    Downconverter dc(in.sample_rate(), center, up, down);
+    out_i.clear();
+    out_q.clear();
+    const size_t BLOCK = 65536;
+    std::vector<float> block(BLOCK);
+    size_t n;
+    while ((n = in.read(block.data(), BLOCK)) > 0) dc.process(block.data(), n, out_i, out_q);
+    bool ok = in.ok();
+    in.close();
+    dc.flush(out_i, out_q);
+    rate = c2_sample_rate(2);
+    return ok;
+}
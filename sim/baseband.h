@@ -0,0 +1,84 @@
+// baseband.h
+//
+// Complex baseband at the .c2 rate from audio, and one loader for both
+// .c2 and WAV input, so analysis tools accept either.
+
+#ifndef BASEBAND_H
+#define BASEBAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "nco.h"
+#include "resample.h"
+
+// The rational ratio from sample_rate to the .c2 rate of a WSPR type
+// (375 or 375/8 sps), as L / M for Downconverter; swapped, they take a
+// .c2 file back to sample_rate in Upconverter. Returns false, with a
+// message on stderr, for an unusable rate.
+bool c2_ratio(int sample_rate, int type, int& up, int& down);
+
+// Audio to complex baseband for recordings of any length, read block by
+// block: an NCO mixes center Hz to 0 Hz and a polyphase low-pass (flat to
+// 0.4, stopband from 0.5 of the output rate) decimates by M / L. Output m
+// is aligned with input time m * M / L; the filter delay is absorbed, and
+// flush() emits the last outputs.
+class Downconverter {
+public:
+    Downconverter(int sample_rate, double center, int up, int down);
+
+    // Mix and decimate n audio samples, appending the finished I/Q
+    // outputs. Returns the number appended.
+    size_t process(const float* audio, size_t n, std::vector<float>& out_i, std::vector<float>& out_q);
+    // The outputs still held back: ceil(inputs * L / M) in total
+    size_t flush(std::vector<float>& out_i, std::vector<float>& out_q);
+
+    double out_rate() const { return sample_rate_ * (double)up_ / down_; }
+
+private:
+    int sample_rate_;
+    int up_, down_;
+    Nco nco_;
+    Resampler rs_i_, rs_q_;
+    std::vector<float> mix_i_, mix_q_;
+    uint64_t skip_;        // delayed outputs still to drop
+    uint64_t emitted_;
+};
+
+// The reverse: a polyphase filter interpolates I/Q at in_rate by L / M
+// and an NCO shifts 0 Hz up to center Hz, giving real audio
+// gain * 2 Re{(I + jQ) e^(j 2 pi center t)}, so gain 1 restores the level
+// Downconverter started from. Output is aligned with the input like
+// Downconverter's.
+class Upconverter {
+public:
+    Upconverter(double in_rate, double center, int up, int down, float gain = 1.0f);
+
+    size_t process(const float* in_i, const float* in_q, size_t n, std::vector<float>& audio);
+    size_t flush(std::vector<float>& audio);
+
+    double out_rate() const { return in_rate_ * up_ / down_; }
+
+private:
+    size_t mix(std::vector<float>& audio, uint64_t limit);
+
+    double in_rate_;
+    int up_, down_;
+    float gain_;
+    Nco nco_;
+    Resampler rs_i_, rs_q_;
+    std::vector<float> bb_i_, bb_q_, osc_i_, osc_q_;
+    uint64_t skip_;
+    uint64_t emitted_;
+};
+
+// True for paths read_baseband loads as .c2 files rather than WAV
+bool is_c2_path(const char* path);
+
+// Load a .c2 file as is, or a 16-bit WAV file at any rate streamed through
+// a Downconverter about center Hz to the WSPR-2 .c2 rate of 375 sps. rate
+// receives the baseband rate.
+bool read_baseband(const char* path, double center, std::vector<float>& out_i,
+                   std::vector<float>& out_q, double& rate);
+
+#endif
@@ -0,0 +1,366 @@
+// c2corpus.cpp
+//
+// .c2 corpus container.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "c2corpus.h"
+#include "c2file.h"
+
+static const char HEADER_MAGIC[8] = {'C', '2', 'C', 'O', 'R', 'P', 'U', 'S'};
+static const char TRAILER_MAGIC[8] = {'C', '2', 'C', 'I', 'N', 'D', 'E', 'X'};
+static const size_t HEADER_SIZE = 16;
+static const size_t ENTRY_SIZE = 64;
+static const size_t TRAILER_SIZE = 24;
+
+bool parse_c2_codec(const char* text, C2Codec& codec) {
+    if (std::strcmp(text, "float") == 0) codec = C2_CODEC_FLOAT;
+    else if (std::strcmp(text, "bfp16") == 0) codec = C2_CODEC_BFP16;
+    else if (std::strcmp(text, "bfp8") == 0) codec = C2_CODEC_BFP8;
+    else return false;
+    return true;
+}
+
+const char* c2_codec_name(C2Codec codec) {
+    switch (codec) {
+    case C2_CODEC_FLOAT: return "float";
+    case C2_CODEC_BFP16: return "bfp16";
+    case C2_CODEC_BFP8: return "bfp8";
+    }
+    return "?";
+}
+
+// Largest integer code of a block floating point codec
+static int codec_max(C2Codec codec) {
+    return codec == C2_CODEC_BFP16 ? 32767 : 127;
+}
+
+double c2_codec_error_bound(C2Codec codec) {
+    return codec == C2_CODEC_FLOAT ? 0.0 : 0.5 / codec_max(codec);
+}
+
+// Bytes of a block of n frames
+static size_t block_bytes(C2Codec codec, size_t n) {
+    switch (codec) {
+    case C2_CODEC_FLOAT: return 8 * n;
+    case C2_CODEC_BFP16: return 4 + 4 * n;
+    case C2_CODEC_BFP8: return 4 + 2 * n;
+    }
+    return 0;
+}
+
+static size_t slot_bytes(C2Codec codec, size_t frames, size_t block_frames) {
+    size_t full = frames / block_frames, rest = frames % block_frames;
+    return full * block_bytes(codec, block_frames) + (rest ? block_bytes(codec, rest) : 0);
+}
+
+int64_t c2_slot_time(const char* name) {
+    int d[10];
+    for (int k = 0; k < 10; k++) {
+        char c = name[k < 6 ? k : k + 1];
+        if (c < '0' || c > '9') return -1;
+        d[k] = c - '0';
+    }
+    if (name[6] != '_') return -1;
+    struct tm t;
+    std::memset(&t, 0, sizeof(t));
+    t.tm_year = 100 + d[0] * 10 + d[1];
+    t.tm_mon = d[2] * 10 + d[3] - 1;
+    t.tm_mday = d[4] * 10 + d[5];
+    t.tm_hour = d[6] * 10 + d[7];
+    t.tm_min = d[8] * 10 + d[9];
+    if (t.tm_mon < 0 || t.tm_mon > 11 || t.tm_mday < 1 || t.tm_mday > 31 || t.tm_hour > 23 || t.tm_min > 59) {
+        return -1;
+    }
+    return (int64_t)timegm(&t);
+}
+
+int c2_band_meters(double dial_mhz) {
+    static const struct { double low, high; int meters; } bands[] = {
+        {0.1357, 0.1378, 2200}, {0.472, 0.479, 630}, {1.8, 2.0, 160}, {3.5, 4.0, 80},
+        {5.25, 5.45, 60}, {7.0, 7.3, 40}, {10.1, 10.15, 30}, {14.0, 14.35, 20},
+        {18.068, 18.168, 17}, {21.0, 21.45, 15}, {24.89, 24.99, 12}, {28.0, 29.7, 10},
+        {50.0, 54.0, 6}, {144.0, 148.0, 2}};
+    for (size_t k = 0; k < sizeof(bands) / sizeof(bands[0]); k++) {
+        if (dial_mhz >= bands[k].low && dial_mhz <= bands[k].high) return bands[k].meters;
+    }
+    return 0;
+}
+
+template <typename T> static void put(unsigned char* p, T v) { std::memcpy(p, &v, sizeof(v)); }
+template <typename T> static T get(const unsigned char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Encode n frames (I, Q) into out; returns the largest error / peak
+static double encode_block(C2Codec codec, const float* in_i, const float* in_q, size_t n,
+                           unsigned char* out) {
+    if (codec == C2_CODEC_FLOAT) {
+        for (size_t k = 0; k < n; k++) {
+            float iq[2] = {in_i[k], -in_q[k]};
+            std::memcpy(out + 8 * k, iq, sizeof(iq));
+        }
+        return 0.0;
+    }
+
+    float peak = 0.0f;
+    for (size_t k = 0; k < n; k++) peak = std::max(peak, std::max(std::fabs(in_i[k]), std::fabs(in_q[k])));
+    int top = codec_max(codec);
+    float scale = peak / top, inv = peak > 0.0f ? top / peak : 0.0f;
+    put(out, scale);
+    out += 4;
+    double worst = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        float v[2] = {in_i[k], in_q[k]};
+        for (int c = 0; c < 2; c++) {
+            long q = std::lrint(v[c] * inv);
+            q = std::max(-(long)top, std::min((long)top, q));
+            if (codec == C2_CODEC_BFP16) put(out + 2 * (2 * k + c), (int16_t)q);
+            else out[2 * k + c] = (unsigned char)(int8_t)q;
+            worst = std::max(worst, std::fabs(q * (double)scale - v[c]));
+        }
+    }
+    return peak > 0.0f ? worst / peak : 0.0;
+}
+
+static void decode_block(C2Codec codec, const unsigned char* in, size_t n, float* out_i, float* out_q) {
+    if (codec == C2_CODEC_FLOAT) {
+        for (size_t k = 0; k < n; k++) {
+            float iq[2];
+            std::memcpy(iq, in + 8 * k, sizeof(iq));
+            out_i[k] = iq[0];
+            out_q[k] = -iq[1];
+        }
+        return;
+    }
+    float scale = get<float>(in);
+    in += 4;
+    if (codec == C2_CODEC_BFP16) {
+        int16_t v[2 * C2_CORPUS_BLOCK];
+        for (size_t pos = 0; pos < n; pos += C2_CORPUS_BLOCK) {
+            size_t len = std::min(n - pos, (size_t)C2_CORPUS_BLOCK);
+            std::memcpy(v, in + 4 * pos, 4 * len);
+            for (size_t k = 0; k < len; k++) {
+                out_i[pos + k] = v[2 * k] * scale;
+                out_q[pos + k] = v[2 * k + 1] * scale;
+            }
+        }
+    } else {
+        const int8_t* v = reinterpret_cast<const int8_t*>(in);
+        for (size_t k = 0; k < n; k++) {
+            out_i[k] = v[2 * k] * scale;
+            out_q[k] = v[2 * k + 1] * scale;
+        }
+    }
+}
+
+C2CorpusWriter::C2CorpusWriter()
+    : f_(NULL), codec_(C2_CODEC_BFP16), offset_(0), ok_(false), max_error_(0.0) {}
+
+C2CorpusWriter::~C2CorpusWriter() {
+    if (f_) close();
+}
+
+bool C2CorpusWriter::open(const char* path, C2Codec codec) {
+    if (f_) close();
+    f_ = std::fopen(path, "wb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot create corpus %s\n", path);
+        return false;
+    }
+    path_ = path;
+    codec_ = codec;
+    slots_.clear();
+    max_error_ = 0.0;
+    unsigned char header[HEADER_SIZE];
+    std::memcpy(header, HEADER_MAGIC, 8);
+    put(header + 8, (uint32_t)C2_CORPUS_VERSION);
+    put(header + 12, (uint32_t)C2_CORPUS_BLOCK);
+    ok_ = std::fwrite(header, 1, sizeof(header), f_) == sizeof(header);
+    offset_ = HEADER_SIZE;
+    return ok_;
+}
+
+bool C2CorpusWriter::add(const char* name, int type, double dial_mhz, int64_t time,
+                         const float* in_i, const float* in_q, size_t n) {
+    if (!f_ || !ok_) return false;
+    C2SlotInfo s;
+    s.name.assign(name, strnlen(name, C2_NAME_SIZE));
+    s.time = time >= 0 ? time : c2_slot_time(s.name.c_str());
+    s.dial_mhz = dial_mhz;
+    s.band = c2_band_meters(dial_mhz);
+    s.type = type;
+    s.codec = codec_;
+    s.frames = (uint32_t)n;
+    s.offset = offset_;
+    s.bytes = slot_bytes(codec_, n, C2_CORPUS_BLOCK);
+
+    block_.resize(block_bytes(codec_, C2_CORPUS_BLOCK));
+    for (size_t pos = 0; ok_ && pos < n; pos += C2_CORPUS_BLOCK) {
+        size_t len = std::min(n - pos, (size_t)C2_CORPUS_BLOCK);
+        double err = encode_block(codec_, in_i + pos, in_q + pos, len, block_.data());
+        max_error_ = std::max(max_error_, err);
+        size_t bytes = block_bytes(codec_, len);
+        ok_ = std::fwrite(block_.data(), 1, bytes, f_) == bytes;
+    }
+    offset_ += s.bytes;
+    slots_.push_back(s);
+    return ok_;
+}
+
+bool C2CorpusWriter::add_file(const char* c2_path) {
+    C2Map c2;
+    if (!c2.open(c2_path)) return false;
+    std::vector<float> i(c2.count()), q(c2.count());
+    c2.read(0, c2.count(), i.data(), q.data());
+    std::string name = c2.name();
+    if (c2_slot_time(name.c_str()) < 0) {
+        // Fall back to the file name, as wsprd names its files
+        const char* slash = std::strrchr(c2_path, '/');
+        const char* base = slash ? slash + 1 : c2_path;
+        if (c2_slot_time(base) >= 0) name.assign(base, strnlen(base, C2_NAME_SIZE));
+    }
+    return add(name.c_str(), c2.type(), c2.dial_mhz(), -1, i.data(), q.data(), i.size());
+}
+
+bool C2CorpusWriter::close() {
+    if (!f_) return false;
+    for (size_t k = 0; ok_ && k < slots_.size(); k++) {
+        const C2SlotInfo& s = slots_[k];
+        unsigned char e[ENTRY_SIZE];
+        std::memset(e, 0, sizeof(e));
+        std::memcpy(e, s.name.data(), std::min(s.name.size(), (size_t)C2_NAME_SIZE));
+        put(e + 16, s.time);
+        put(e + 24, s.dial_mhz);
+        put(e + 32, s.offset);
+        put(e + 40, s.bytes);
+        put(e + 48, s.frames);
+        put(e + 52, (int32_t)s.type);
+        put(e + 56, (int32_t)s.band);
+        e[60] = (unsigned char)s.codec;
+        ok_ = std::fwrite(e, 1, sizeof(e), f_) == sizeof(e);
+    }
+    unsigned char trailer[TRAILER_SIZE];
+    put(trailer, offset_);
+    put(trailer + 8, (uint64_t)slots_.size());
+    std::memcpy(trailer + 16, TRAILER_MAGIC, 8);
+    if (ok_) ok_ = std::fwrite(trailer, 1, sizeof(trailer), f_) == sizeof(trailer);
+    if (std::fclose(f_) != 0) ok_ = false;
+    f_ = NULL;
+    if (!ok_) std::fprintf(stderr, "Error: Failed writing corpus %s\n", path_.c_str());
+    return ok_;
+}
+
+C2CorpusReader::C2CorpusReader() : map_(NULL), length_(0), block_frames_(C2_CORPUS_BLOCK) {}
+
+C2CorpusReader::~C2CorpusReader() {
+    close();
+}
+
+bool C2CorpusReader::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "Error: Cannot open corpus %s\n", path);
+        return false;
+    }
+    struct stat st;
+    void* p = MAP_FAILED;
+    size_t length = 0;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= HEADER_SIZE + TRAILER_SIZE) {
+        length = (size_t)st.st_size;
+        p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::fprintf(stderr, "Error: %s is not a .c2 corpus\n", path);
+        return false;
+    }
+    map_ = p;
+    length_ = length;
+
+    const unsigned char* base = static_cast<const unsigned char*>(p);
+    const unsigned char* trailer = base + length - TRAILER_SIZE;
+    uint64_t index = get<uint64_t>(trailer), count = get<uint64_t>(trailer + 8);
+    block_frames_ = (int)get<uint32_t>(base + 12);
+    bool ok = std::memcmp(base, HEADER_MAGIC, 8) == 0 && std::memcmp(trailer + 16, TRAILER_MAGIC, 8) == 0 &&
+              get<uint32_t>(base + 8) == (uint32_t)C2_CORPUS_VERSION && block_frames_ > 0 &&
+              index >= HEADER_SIZE && index <= length - TRAILER_SIZE &&
+              count == (length - TRAILER_SIZE - index) / ENTRY_SIZE &&
+              (length - TRAILER_SIZE - index) % ENTRY_SIZE == 0;
+    for (uint64_t k = 0; ok && k < count; k++) {
+        const unsigned char* e = base + index + k * ENTRY_SIZE;
+        C2SlotInfo s;
+        s.name.assign(reinterpret_cast<const char*>(e), strnlen(reinterpret_cast<const char*>(e), C2_NAME_SIZE));
+        s.time = get<int64_t>(e + 16);
+        s.dial_mhz = get<double>(e + 24);
+        s.offset = get<uint64_t>(e + 32);
+        s.bytes = get<uint64_t>(e + 40);
+        s.frames = get<uint32_t>(e + 48);
+        s.type = get<int32_t>(e + 52);
+        s.band = get<int32_t>(e + 56);
+        s.codec = (C2Codec)e[60];
+        ok = e[60] <= C2_CODEC_BFP8 && s.offset >= HEADER_SIZE && s.offset <= index &&
+             s.bytes <= index - s.offset && s.bytes == slot_bytes(s.codec, s.frames, block_frames_);
+        slots_.push_back(s);
+    }
+    if (!ok) {
+        std::fprintf(stderr, "Error: %s is not a valid .c2 corpus\n", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void C2CorpusReader::close() {
+    if (map_) munmap(map_, length_);
+    map_ = NULL;
+    length_ = 0;
+    slots_.clear();
+}
+
+std::vector<size_t> C2CorpusReader::find(int64_t from, int64_t to, int band, double min_mhz,
+                                         double max_mhz) const {
+    std::vector<size_t> hits;
+    for (size_t k = 0; k < slots_.size(); k++) {
+        const C2SlotInfo& s = slots_[k];
+        if (from >= 0 && s.time < from) continue;
+        if (to >= 0 && s.time >= to) continue;
+        if (band && s.band != band) continue;
+        if (min_mhz > 0.0 && s.dial_mhz < min_mhz) continue;
+        if (max_mhz > 0.0 && s.dial_mhz > max_mhz) continue;
+        hits.push_back(k);
+    }
+    return hits;
+}
+
+size_t C2CorpusReader::blocks(size_t k) const {
+    return (slots_[k].frames + block_frames_ - 1) / block_frames_;
+}
+
+size_t C2CorpusReader::read_block(size_t k, size_t b, float* out_i, float* out_q) const {
+    const C2SlotInfo& s = slots_[k];
+    size_t first = b * block_frames_;
+    if (first >= s.frames) return 0;
+    size_t n = std::min((size_t)s.frames - first, (size_t)block_frames_);
+    const unsigned char* p = static_cast<const unsigned char*>(map_) + s.offset +
+                             b * block_bytes(s.codec, block_frames_);
+    decode_block(s.codec, p, n, out_i, out_q);
+    return n;
+}
+
+void C2CorpusReader::read_slot(size_t k, std::vector<float>& out_i, std::vector<float>& out_q) const {
+    out_i.resize(slots_[k].frames);
+    out_q.resize(slots_[k].frames);
+    for (size_t b = 0; b < blocks(k); b++) {
+        read_block(k, b, &out_i[b * block_frames_], &out_q[b * block_frames_]);
+    }
+}
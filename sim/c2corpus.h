@@ -0,0 +1,133 @@
+// c2corpus.h
+//
+// Many .c2 slots packed into one corpus file, with the samples stored in
+// blocks of C2_CORPUS_BLOCK frames and an index at the end.
+//
+//   header   "C2CORPUS", version, frames per block (16 bytes)
+//   slots    blocks of each slot back to back
+//   index    64 bytes per slot: name, UTC time, dial frequency, band,
+//            type, codec, frame count, offset and length of its blocks
+//   trailer  index offset, slot count, "C2CINDEX" (24 bytes)
+//
+// Codecs, per slot:
+//   float   the frames as stored in the .c2 file, lossless (1x)
+//   bfp16   block floating point: one float scale per block and int16 I
+//           and Q (2x); every value is within peak / 65534 of the
+//           original, peak being the largest |I| or |Q| in its block
+//           (-96 dB)
+//   bfp8    the same with int8 (4x), within peak / 254 (-48 dB). On a
+//           noisy slot that is about 40 dB under the noise floor.
+//
+// Readers map the file and decode single blocks on demand; files are
+// little endian, as .c2 files are.
+
+#ifndef C2CORPUS_H
+#define C2CORPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+const int C2_CORPUS_BLOCK = 1024;
+const int C2_CORPUS_VERSION = 1;
+
+enum C2Codec {
+    C2_CODEC_FLOAT = 0,
+    C2_CODEC_BFP16 = 1,
+    C2_CODEC_BFP8 = 2
+};
+
+// "float", "bfp16" or "bfp8"; false for anything else
+bool parse_c2_codec(const char* text, C2Codec& codec);
+const char* c2_codec_name(C2Codec codec);
+
+// Worst-case error of a codec as a fraction of the block peak
+double c2_codec_error_bound(C2Codec codec);
+
+// UTC time of a wsprd style slot name, YYMMDD_HHMM[...], or -1
+int64_t c2_slot_time(const char* name);
+
+// Amateur band in meters for a dial frequency in MHz (2200 ... 2), or 0
+int c2_band_meters(double dial_mhz);
+
+struct C2SlotInfo {
+    std::string name;     // header name, up to 14 characters
+    int64_t time;         // UTC seconds of the slot start, -1 if unknown
+    double dial_mhz;
+    int band;             // meters, 0 if unknown
+    int type;             // 2 or 15
+    C2Codec codec;
+    uint32_t frames;
+    uint64_t offset;      // of the first block
+    uint64_t bytes;       // of all blocks
+};
+
+class C2CorpusWriter {
+public:
+    C2CorpusWriter();
+    ~C2CorpusWriter();
+
+    bool open(const char* path, C2Codec codec);
+    // Append a slot of n frames; time -1 takes it from the name
+    bool add(const char* name, int type, double dial_mhz, int64_t time,
+             const float* in_i, const float* in_q, size_t n);
+    // Append a .c2 file
+    bool add_file(const char* c2_path);
+    // Write the index and trailer
+    bool close();
+
+    const std::vector<C2SlotInfo>& slots() const { return slots_; }
+    // Largest |error| so far as a fraction of its block's peak
+    double max_error() const { return max_error_; }
+
+private:
+    C2CorpusWriter(const C2CorpusWriter&);
+    C2CorpusWriter& operator=(const C2CorpusWriter&);
+
+    FILE* f_;
+    std::string path_;
+    C2Codec codec_;
+    uint64_t offset_;
+    bool ok_;
+    double max_error_;
+    std::vector<C2SlotInfo> slots_;
+    std::vector<unsigned char> block_;
+};
+
+class C2CorpusReader {
+public:
+    C2CorpusReader();
+    ~C2CorpusReader();
+
+    // Map a corpus and load its index. Returns false, with a message on
+    // stderr, for a file that is not one or is truncated.
+    bool open(const char* path);
+    void close();
+
+    size_t size() const { return slots_.size(); }
+    const C2SlotInfo& slot(size_t k) const { return slots_[k]; }
+
+    // Slots with from <= time < to (-1 for either end open), band (0 for
+    // any) and dial frequency in [min_mhz, max_mhz] (0 for any)
+    std::vector<size_t> find(int64_t from, int64_t to, int band, double min_mhz,
+                             double max_mhz) const;
+
+    size_t blocks(size_t k) const;
+    // Decode block b of slot k into I and Q; returns its frame count
+    size_t read_block(size_t k, size_t b, float* out_i, float* out_q) const;
+    // Decode a whole slot
+    void read_slot(size_t k, std::vector<float>& out_i, std::vector<float>& out_q) const;
+
+private:
+    C2CorpusReader(const C2CorpusReader&);
+    C2CorpusReader& operator=(const C2CorpusReader&);
+
+    void* map_;
+    size_t length_;
+    int block_frames_;
+    std::vector<C2SlotInfo> slots_;
+};
+
+#endif
@@ -0,0 +1,214 @@
+// c2file.cpp
+//
+// wsprd .c2 baseband files.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "c2file.h"
+
+double c2_sample_rate(int type) {
+    return type == 15 ? 375.0 / 8 : 375.0;
+}
+
+bool read_c2_file(const char* path, std::vector<float>& out_i, std::vector<float>& out_q,
+                  int* type, double* dial_mhz) {
+    C2Map c2;
+    if (!c2.open(path)) return false;
+    if (type) *type = c2.type();
+    if (dial_mhz) *dial_mhz = c2.dial_mhz();
+    out_i.resize(c2.count());
+    out_q.resize(c2.count());
+    c2.read(0, c2.count(), out_i.data(), out_q.data());
+    return true;
+}
+
+// The 26 header bytes
+static void c2_header(char* header, const char* path, int type, double dial_mhz, const char* name) {
+    if (!name) {
+        const char* slash = std::strrchr(path, '/');
+        name = slash ? slash + 1 : path;
+    }
+    memset(header, 0, C2_HEADER_SIZE);
+    strncpy(header, name, C2_NAME_SIZE);
+    int32_t t = type;
+    memcpy(header + C2_NAME_SIZE, &t, sizeof(t));
+    memcpy(header + C2_NAME_SIZE + sizeof(t), &dial_mhz, sizeof(dial_mhz));
+}
+
+void C2Samples::read(float* out_i, float* out_q) const {
+    const char* p = data_;
+    for (size_t k = 0; k < size_; k++, p += 2 * sizeof(float)) {
+        float iq[2];
+        memcpy(iq, p, sizeof(iq));
+        out_i[k] = iq[0];
+        out_q[k] = -iq[1];
+    }
+}
+
+C2Map::C2Map() : map_(NULL), header_(NULL), frames_(NULL) {}
+
+C2Map::~C2Map() {
+    close();
+}
+
+bool C2Map::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "Error: Cannot open .c2 file %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != C2_FILE_SIZE) {
+        ::close(fd);
+        std::fprintf(stderr, "Error: %s is not a %zu byte .c2 file\n", path, C2_FILE_SIZE);
+        return false;
+    }
+    void* p = mmap(NULL, C2_FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::fprintf(stderr, "Error: Cannot map .c2 file %s\n", path);
+        return false;
+    }
+    map_ = p;
+    header_ = static_cast<const char*>(p);
+    frames_ = header_ + C2_HEADER_SIZE;
+    if (!c2_valid_type(type())) {
+        std::fprintf(stderr, "Error: %s has WSPR type %d, not 2 or 15\n", path, type());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void C2Map::close() {
+    if (map_) munmap(map_, C2_FILE_SIZE);
+    map_ = NULL;
+    header_ = NULL;
+    frames_ = NULL;
+}
+
+std::string C2Map::name() const {
+    return header_ ? std::string(header_, strnlen(header_, C2_NAME_SIZE)) : std::string();
+}
+
+int C2Map::type() const {
+    int32_t t = 0;
+    if (header_) memcpy(&t, header_ + C2_NAME_SIZE, sizeof(t));
+    return t;
+}
+
+double C2Map::dial_mhz() const {
+    double mhz = 0.0;
+    if (header_) memcpy(&mhz, header_ + C2_NAME_SIZE + sizeof(int32_t), sizeof(mhz));
+    return mhz;
+}
+
+C2MapWriter::C2MapWriter() : map_(NULL), frames_(NULL) {}
+
+C2MapWriter::~C2MapWriter() {
+    if (map_) close();
+}
+
+bool C2MapWriter::open(const char* path, int type, double dial_mhz, const char* name) {
+    if (map_) close();
+    path_ = path;
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        std::fprintf(stderr, "Error: Cannot create .c2 file %s\n", path);
+        return false;
+    }
+    // Reserve the blocks; a sparse file could fault on a full disk
+    int err = posix_fallocate(fd, 0, (off_t)C2_FILE_SIZE);
+    void* p = MAP_FAILED;
+    if (err == 0) p = mmap(NULL, C2_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::fprintf(stderr, "Error: Cannot allocate .c2 file %s\n", path);
+        return false;
+    }
+    map_ = p;
+    char* header = static_cast<char*>(p);
+    c2_header(header, path, type, dial_mhz, name);
+    frames_ = header + C2_HEADER_SIZE;
+    return true;
+}
+
+void C2MapWriter::write(size_t first, const float* in_i, const float* in_q, size_t n) {
+    if (!map_ || first >= C2_FRAMES) return;
+    if (n > C2_FRAMES - first) n = C2_FRAMES - first;
+    char* p = frames_ + first * 2 * sizeof(float);
+    for (size_t k = 0; k < n; k++, p += 2 * sizeof(float)) {
+        float iq[2] = {in_i[k], -in_q[k]};
+        memcpy(p, iq, sizeof(iq));
+    }
+}
+
+bool C2MapWriter::close() {
+    if (!map_) return false;
+    // Write errors on the mapped pages (EIO, or ENOSPC where the file
+    // system could not honour the reservation) only surface here
+    bool ok = msync(map_, C2_FILE_SIZE, MS_SYNC) == 0;
+    if (munmap(map_, C2_FILE_SIZE) != 0) ok = false;
+    map_ = NULL;
+    frames_ = NULL;
+    if (!ok) std::fprintf(stderr, "Error: Failed writing .c2 file %s\n", path_.c_str());
+    return ok;
+}
+
+C2Writer::C2Writer() : f_(NULL), count_(0), ok_(false) {}
+
+C2Writer::~C2Writer() {
+    if (f_) close();
+}
+
+bool C2Writer::open(const char* path, int type, double dial_mhz, const char* name) {
+    if (f_) close();
+    f_ = std::fopen(path, "wb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot create .c2 file %s\n", path);
+        return false;
+    }
+    path_ = path;
+    count_ = 0;
+
+    char header[C2_HEADER_SIZE];
+    c2_header(header, path, type, dial_mhz, name);
+    ok_ = std::fwrite(header, 1, sizeof(header), f_) == sizeof(header);
+    return ok_;
+}
+
+bool C2Writer::write(const float* in_i, const float* in_q, size_t n) {
+    if (count_ + n > C2_FRAMES) n = C2_FRAMES - count_;
+
+    // Interleave I and -Q a chunk at a time
+    const size_t CHUNK = 4096;
+    float buf[2 * CHUNK];
+    for (size_t pos = 0; ok_ && pos < n; pos += CHUNK) {
+        size_t len = n - pos < CHUNK ? n - pos : CHUNK;
+        for (size_t k = 0; k < len; k++) {
+            buf[2 * k] = in_i[pos + k];
+            buf[2 * k + 1] = -in_q[pos + k];
+        }
+        ok_ = std::fwrite(buf, 2 * sizeof(float), len, f_) == len;
+        count_ += len;
+    }
+    return ok_;
+}
+
+bool C2Writer::close() {
+    if (!f_) return false;
+    if (ok_ && count_ < C2_FRAMES) {
+        std::vector<float> zeros(2 * (C2_FRAMES - count_), 0.0f);
+        ok_ = std::fwrite(zeros.data(), sizeof(float), zeros.size(), f_) == zeros.size();
+    }
+    if (std::fclose(f_) != 0) ok_ = false;
+    f_ = NULL;
+    if (!ok_) std::fprintf(stderr, "Error: Failed writing .c2 file %s\n", path_.c_str());
+    return ok_;
+}
@@ -0,0 +1,149 @@
+// c2file.h
+//
+// wsprd .c2 baseband files (see wspr-cui/README.md):
+//   14 bytes  file name
+//    4 bytes  WSPR type (int32, 2 or 15)
+//    8 bytes  dial frequency in MHz (double)
+//   45000 frames of interleaved float I, -Q
+
+#ifndef C2FILE_H
+#define C2FILE_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const int    C2_HEADER_SIZE = 26;
+const int    C2_NAME_SIZE   = 14;
+const size_t C2_FRAMES      = 45000;
+const size_t C2_FILE_SIZE   = C2_HEADER_SIZE + C2_FRAMES * 2 * sizeof(float);  // 360026
+
+// Frame rate for a WSPR type: 375 sps for WSPR-2, 375/8 sps for WSPR-15 so
+// the 45000 frames cover a 16 minute WSPR-15 period
+double c2_sample_rate(int type);
+
+// wsprd reads only these two types
+inline bool c2_valid_type(int type) { return type == 2 || type == 15; }
+
+// Read a whole .c2 file into I and Q (the stored -Q negated back). type
+// and dial_mhz receive the header fields when not NULL. Returns false,
+// with a message on stderr, for a file C2Map rejects.
+bool read_c2_file(const char* path, std::vector<float>& out_i, std::vector<float>& out_q,
+                  int* type = NULL, double* dial_mhz = NULL);
+
+// Zero-copy view of stored frames as complex samples I + jQ: element k
+// is read from the mapping with the -Q sign undone. The floats sit at a
+// 26 byte offset, so they are loaded with memcpy rather than aliased.
+class C2Samples {
+public:
+    C2Samples() : data_(NULL), size_(0) {}
+    C2Samples(const char* data, size_t size) : data_(data), size_(size) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::complex<float> operator[](size_t k) const {
+        float iq[2];
+        memcpy(iq, data_ + k * sizeof(iq), sizeof(iq));
+        return std::complex<float>(iq[0], -iq[1]);
+    }
+    // Frames [first, first + n), clamped to the view
+    C2Samples subspan(size_t first, size_t n) const {
+        if (first > size_) first = size_;
+        if (n > size_ - first) n = size_ - first;
+        return C2Samples(data_ + first * 2 * sizeof(float), n);
+    }
+    // Copy out as separate I and Q
+    void read(float* out_i, float* out_q) const;
+    // The stored bytes
+    const char* data() const { return data_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+// Read-only memory mapping of a .c2 file. Opening costs a page table
+// setup; frames are paged in as they are touched.
+class C2Map {
+public:
+    C2Map();
+    ~C2Map();
+
+    // Returns false, with a message on stderr, unless the file is exactly
+    // C2_FILE_SIZE bytes with a type of 2 or 15
+    bool open(const char* path);
+    void close();
+
+    C2Samples samples() const { return C2Samples(frames_, count()); }
+    // Frames [first, first + n) as I and Q
+    void read(size_t first, size_t n, float* out_i, float* out_q) const {
+        samples().subspan(first, n).read(out_i, out_q);
+    }
+
+    size_t count() const { return frames_ ? C2_FRAMES : 0; }
+    std::string name() const;
+    int type() const;
+    double dial_mhz() const;
+
+private:
+    C2Map(const C2Map&);
+    C2Map& operator=(const C2Map&);
+
+    void* map_;
+    const char* header_;
+    const char* frames_;
+};
+
+// Writer into a pre-sized mapped file: open() creates the full length,
+// zero filled, with its header; frames can then be stored at any index.
+// Disk space is reserved up front, so a full disk fails open() rather
+// than a later store.
+class C2MapWriter {
+public:
+    C2MapWriter();
+    ~C2MapWriter();
+
+    // name defaults to the base name of path, truncated to 14 characters
+    bool open(const char* path, int type, double dial_mhz, const char* name = NULL);
+    // Store frames [first, first + n); anything past 45000 frames is dropped
+    void write(size_t first, const float* in_i, const float* in_q, size_t n);
+    // Flush the pages to disk (msync) and unmap; false if any write failed
+    bool close();
+
+private:
+    C2MapWriter(const C2MapWriter&);
+    C2MapWriter& operator=(const C2MapWriter&);
+
+    void* map_;
+    char* frames_;
+    std::string path_;
+};
+
+// Streaming .c2 writer. Samples beyond 45000 frames are dropped, and
+// close() pads short files with zeros to the fixed length.
+class C2Writer {
+public:
+    C2Writer();
+    ~C2Writer();
+
+    // name defaults to the base name of path, truncated to 14 characters
+    bool open(const char* path, int type, double dial_mhz, const char* name = NULL);
+    bool write(const float* in_i, const float* in_q, size_t n);
+    bool close();
+
+    size_t frames() const { return count_; }
+
+private:
+    C2Writer(const C2Writer&);
+    C2Writer& operator=(const C2Writer&);
+
+    FILE* f_;
+    std::string path_;
+    size_t count_;
+    bool ok_;
+};
+
+#endif
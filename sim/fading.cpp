@@ -0,0 +1,301 @@
+// fading.cpp
+//
+// Watterson HF channel.
+//
+// Each path's gain is white complex Gaussian noise at a low point rate
+// shaped by a Gaussian FIR. A Gaussian Doppler spectrum with standard
+// deviation s (half the quoted spread) needs |H(f)|^2 proportional to
+// exp(-f^2 / 2s^2), which is a Gaussian impulse response with standard
+// deviation 1 / (2 pi sqrt(2) s) in time. Point j of the process is a
+// pure function of (seed, path, j), so the fading does not depend on how
+// the input is split into calls.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "fading.h"
+#include "nco.h"
+#include "noise.h"
+
+static const FadingProfile PROFILES[] = {
+    // CCIR Rec. 520
+    {"good", 0.5, 0.1},
+    {"moderate", 1.0, 0.5},
+    {"poor", 2.0, 1.0},
+    {"flutter", 0.5, 10.0},
+    // ITU-R F.1487
+    {"low-quiet", 0.5, 0.5},
+    {"low-moderate", 2.0, 1.5},
+    {"low-disturbed", 6.0, 10.0},
+    {"mid-quiet", 0.5, 0.1},
+    {"mid-moderate", 1.0, 0.5},
+    {"mid-disturbed", 2.0, 1.0},
+    {"high-quiet", 1.0, 0.5},
+    {"high-moderate", 3.0, 10.0},
+    {"high-disturbed", 7.0, 30.0},
+};
+static const size_t PROFILE_COUNT = sizeof(PROFILES) / sizeof(PROFILES[0]);
+
+// Gain points per Hz of spread: the shaped spectrum is negligible well
+// below the point rate's Nyquist frequency, so linear interpolation
+// between points is the only approximation
+static const double POINTS_PER_HZ = 16.0;
+// Kernel half length in standard deviations
+static const double KERNEL_SIGMAS = 4.0;
+// Samples per processing chunk
+static const size_t CHUNK = 4096;
+// Generator streams 2p and 2p + 1 past this base drive path p, clear of
+// the NoiseStage streams so one seed can serve both stages
+static const uint64_t STREAM_BASE = 256;
+
+const FadingProfile* find_fading_profile(const char* name) {
+    for (size_t i = 0; i < PROFILE_COUNT; i++)
+        if (std::strcmp(PROFILES[i].name, name) == 0) return &PROFILES[i];
+    return NULL;
+}
+
+const char* fading_profile_names() {
+    static std::string names;
+    if (names.empty()) {
+        for (size_t i = 0; i < PROFILE_COUNT; i++) {
+            if (i) names += ", ";
+            names += PROFILES[i].name;
+        }
+    }
+    return names.c_str();
+}
+
+bool parse_fading_taps(const char* text, std::vector<FadingTap>& taps) {
+    double delay_ms, spread;
+    const FadingProfile* profile = find_fading_profile(text);
+    if (profile) {
+        delay_ms = profile->delay_ms;
+        spread = profile->spread_hz;
+    } else {
+        char tail;
+        if (std::sscanf(text, "%lf:%lf%c", &delay_ms, &spread, &tail) != 2) return false;
+        if (delay_ms < 0.0 || spread < 0.0) return false;
+    }
+
+    taps.clear();
+    FadingTap tap = {0.0, spread, 0.0, 0.0};
+    taps.push_back(tap);
+    tap.delay = delay_ms / 1000.0;
+    taps.push_back(tap);
+    return true;
+}
+
+FadingChannel::FadingChannel(const std::vector<FadingTap>& taps, double sample_rate, uint64_t seed)
+    : sample_rate_(sample_rate), seed_(seed), max_delay_(0) {
+    Nco nco(sample_rate);
+
+    double total = 0.0;
+    for (size_t i = 0; i < taps.size(); i++) total += std::pow(10.0, taps[i].gain_db / 10.0);
+
+    paths_.resize(taps.size());
+    for (size_t i = 0; i < taps.size(); i++) {
+        const FadingTap& tap = taps[i];
+        Path& p = paths_[i];
+        p.delay = tap.delay * sample_rate;
+        p.amplitude = (float)std::sqrt(std::pow(10.0, tap.gain_db / 10.0) / total);
+        p.shift_step = nco.step_for(tap.shift);
+        p.shift_phase = 0;
+        max_delay_ = std::max(max_delay_, (size_t)std::ceil(p.delay) + 1);
+
+        if (tap.spread > 0.0) {
+            p.gain_step = std::max<size_t>(1, (size_t)llround(sample_rate / (POINTS_PER_HZ * tap.spread)));
+            double point_rate = sample_rate / p.gain_step;
+            double sigma = point_rate / (2.0 * M_PI * std::sqrt(2.0) * (tap.spread / 2.0));
+            int half = (int)std::ceil(KERNEL_SIGMAS * sigma);
+            p.kernel.resize(2 * half + 1);
+            double energy = 0.0;
+            for (int k = -half; k <= half; k++) {
+                double h = std::exp(-0.5 * k * k / (sigma * sigma));
+                p.kernel[k + half] = (float)h;
+                energy += h * h;
+            }
+            // Unit mean power: the white input has variance 1/2 per component
+            for (size_t k = 0; k < p.kernel.size(); k++)
+                p.kernel[k] = (float)(p.kernel[k] / std::sqrt(energy));
+
+            p.point = 0;
+            p.g_re = gain_point(p, i, 0, p.g_im);
+            p.t_re = p.g_re;
+            p.t_im = p.g_im;
+            p.left = 0;
+            next_point(p, i);
+        } else {
+            // Fixed path
+            p.gain_step = 0;
+            p.point = 0;
+            p.g_re = p.t_re = 1.0f;
+            p.g_im = p.t_im = 0.0f;
+            p.d_re = p.d_im = 0.0f;
+            p.left = (size_t)-1;
+        }
+    }
+
+    // Hilbert transformer half length: about 2.6 ms, so its passband
+    // edge scales with the sample rate
+    hilbert_half_ = std::max<size_t>(15, (size_t)llround(sample_rate / 375.0));
+    if ((hilbert_half_ & 1) == 0) hilbert_half_--;
+    for (size_t k = 1; k <= hilbert_half_; k += 2) {
+        double x = (double)k / (hilbert_half_ + 1);
+        double window = 0.42 + 0.5 * std::cos(M_PI * x) + 0.08 * std::cos(2.0 * M_PI * x);
+        hilbert_.push_back((float)(2.0 / (M_PI * k) * window));
+    }
+    input_.assign(2 * hilbert_half_, 0.0f);
+    hist_i_.assign(max_delay_, 0.0f);
+    hist_q_.assign(max_delay_, 0.0f);
+}
+
+float FadingChannel::gain_point(Path& p, size_t path, uint64_t point, float& im) const {
+    // Points only move forward; refill the white input a block ahead
+    size_t length = p.kernel.size();
+    if (p.white_i.empty() || point < p.white_start || point + length > p.white_start + p.white_i.size()) {
+        p.white_start = point;
+        p.white_i.resize(length + NOISE_BLOCK);
+        p.white_q.resize(length + NOISE_BLOCK);
+        GaussianNoise(seed_, STREAM_BASE + 2 * path).fill_at(point, &p.white_i[0], p.white_i.size(), (float)M_SQRT1_2);
+        GaussianNoise(seed_, STREAM_BASE + 2 * path + 1).fill_at(point, &p.white_q[0], p.white_q.size(), (float)M_SQRT1_2);
+    }
+    const float* wi = &p.white_i[point - p.white_start];
+    const float* wq = &p.white_q[point - p.white_start];
+
+    float re = 0.0f;
+    im = 0.0f;
+    for (size_t k = 0; k < length; k++) {
+        re += p.kernel[k] * wi[k];
+        im += p.kernel[k] * wq[k];
+    }
+    return re;
+}
+
+void FadingChannel::next_point(Path& p, size_t path) {
+    // Land exactly on the previous target so rounding cannot accumulate
+    p.g_re = p.t_re;
+    p.g_im = p.t_im;
+    p.point++;
+    p.t_re = gain_point(p, path, p.point, p.t_im);
+    float scale = 1.0f / p.gain_step;
+    p.d_re = (p.t_re - p.g_re) * scale;
+    p.d_im = (p.t_im - p.g_im) * scale;
+    p.left = p.gain_step;
+}
+
+// Quadrature output of the Hilbert FIR centred on x[0..n). LANES outputs
+// are accumulated together so the inner loop is a fixed-width vector op.
+static const int LANES = 8;
+
+void FadingChannel::hilbert(const float* x, float* out, size_t n) const {
+    size_t taps = hilbert_.size();
+    const float* h = &hilbert_[0];
+    size_t u = 0;
+    for (; u + LANES <= n; u += LANES) {
+        float acc[LANES] = {0.0f};
+        for (size_t j = 0; j < taps; j++) {
+            size_t k = 2 * j + 1;
+            const float* before = x + u - k;
+            const float* after = x + u + k;
+            for (int l = 0; l < LANES; l++) acc[l] += h[j] * (before[l] - after[l]);
+        }
+        for (int l = 0; l < LANES; l++) out[u + l] = acc[l];
+    }
+    for (; u < n; u++) {
+        float acc = 0.0f;
+        for (size_t j = 0; j < taps; j++) acc += h[j] * (x[u - 2 * j - 1] - x[u + 2 * j + 1]);
+        out[u] = acc;
+    }
+}
+
+// hist_i_/hist_q_ hold max_delay_ samples of history followed by the n
+// analytic input samples
+void FadingChannel::render(float* out_re, float* out_im, size_t n) {
+    const float* table = nco_sine_table();
+    const uint32_t quarter = 1u << 30;
+    std::fill(out_re, out_re + n, 0.0f);
+    if (out_im) std::fill(out_im, out_im + n, 0.0f);
+
+    for (size_t i = 0; i < paths_.size(); i++) {
+        Path& p = paths_[i];
+        size_t whole = (size_t)p.delay;
+        float frac = (float)(p.delay - whole);
+        const float* xi = &hist_i_[max_delay_ - whole];
+        const float* xq = &hist_q_[max_delay_ - whole];
+
+        for (size_t t = 0; t < n; ) {
+            if (p.left == 0) next_point(p, i);
+            size_t run = std::min(n - t, p.left);
+            float g_re = p.g_re, g_im = p.g_im;
+            float a = p.amplitude;
+            for (size_t u = t; u < t + run; u++) {
+                // Fractional delay by linear interpolation
+                float x_re = xi[u] + frac * (xi[u - 1] - xi[u]);
+                float x_im = xq[u] + frac * (xq[u - 1] - xq[u]);
+                float c_re = a * g_re, c_im = a * g_im;
+                if (p.shift_step) {
+                    float s_re = nco_lookup(table, p.shift_phase + quarter);
+                    float s_im = nco_lookup(table, p.shift_phase);
+                    p.shift_phase += p.shift_step;
+                    float r = c_re * s_re - c_im * s_im;
+                    c_im = c_re * s_im + c_im * s_re;
+                    c_re = r;
+                }
+                out_re[u] += c_re * x_re - c_im * x_im;
+                if (out_im) out_im[u] += c_re * x_im + c_im * x_re;
+                g_re += p.d_re;
+                g_im += p.d_im;
+            }
+            p.g_re = g_re;
+            p.g_im = g_im;
+            if (p.left != (size_t)-1) p.left -= run;
+            t += run;
+        }
+    }
+}
+
+void FadingChannel::process(float* samples, size_t n) {
+    size_t m = hilbert_half_;
+    while (n > 0) {
+        size_t count = std::min(n, CHUNK);
+
+        // input_ keeps 2m samples of history; output u is centred on input_[u + m]
+        input_.resize(2 * m + count);
+        std::memcpy(&input_[2 * m], samples, count * sizeof(float));
+        hist_i_.resize(max_delay_ + count);
+        hist_q_.resize(max_delay_ + count);
+        float* an_i = &hist_i_[max_delay_];
+        float* an_q = &hist_q_[max_delay_];
+        const float* x = &input_[m];
+        std::memcpy(an_i, x, count * sizeof(float));
+        hilbert(x, an_q, count);
+
+        render(samples, NULL, count);
+
+        std::memmove(&input_[0], &input_[count], 2 * m * sizeof(float));
+        std::memmove(&hist_i_[0], &hist_i_[count], max_delay_ * sizeof(float));
+        std::memmove(&hist_q_[0], &hist_q_[count], max_delay_ * sizeof(float));
+        samples += count;
+        n -= count;
+    }
+}
+
+void FadingChannel::process_iq(float* in_i, float* in_q, size_t n) {
+    while (n > 0) {
+        size_t count = std::min(n, CHUNK);
+        hist_i_.resize(max_delay_ + count);
+        hist_q_.resize(max_delay_ + count);
+        std::memcpy(&hist_i_[max_delay_], in_i, count * sizeof(float));
+        std::memcpy(&hist_q_[max_delay_], in_q, count * sizeof(float));
+
+        render(in_i, in_q, count);
+
+        std::memmove(&hist_i_[0], &hist_i_[count], max_delay_ * sizeof(float));
+        std::memmove(&hist_q_[0], &hist_q_[count], max_delay_ * sizeof(float));
+        in_i += count;
+        in_q += count;
+        n -= count;
+    }
+}
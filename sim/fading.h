@@ -0,0 +1,93 @@
+// fading.h
+//
+// Watterson HF channel model (ITU-R F.1487 / CCIR 520): the signal
+// arrives over two or more delayed paths, each scaled by an independent
+// complex Gaussian gain process whose Doppler spectrum is Gaussian.
+//
+// Tap gains are generated at a low rate (16 points per Hz of spread) by
+// filtering white Gaussian noise with a Gaussian kernel, then linearly
+// interpolated to the sample rate. Real audio is made analytic with a
+// Hilbert FIR first (accurate to 0.1% above 500 Hz), which delays the
+// output by latency() samples, 2.6 ms; complex baseband is processed
+// directly with no latency.
+
+#ifndef FADING_H
+#define FADING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One propagation path
+struct FadingTap {
+    double delay;    // seconds
+    double spread;   // Doppler spread in Hz (two sigma of the Gaussian spectrum), 0 = fixed gain
+    double shift;    // Doppler shift in Hz
+    double gain_db;  // relative power
+};
+
+// Named channel preset: two equal paths
+struct FadingProfile {
+    const char* name;
+    double delay_ms;
+    double spread_hz;
+};
+
+// Look up a preset ("good", "moderate", "poor", "flutter", "mid-quiet", ...),
+// NULL if unknown
+const FadingProfile* find_fading_profile(const char* name);
+
+// Comma separated list of the preset names, for usage text
+const char* fading_profile_names();
+
+// Taps for a preset, or for "DELAY_MS:SPREAD_HZ"; false if the text is neither
+bool parse_fading_taps(const char* text, std::vector<FadingTap>& taps);
+
+// Streaming channel. Calls continue where the previous one stopped, and a
+// given seed always produces the same fading.
+class FadingChannel {
+public:
+    FadingChannel(const std::vector<FadingTap>& taps, double sample_rate, uint64_t seed);
+
+    // Real audio in place
+    void process(float* samples, size_t n);
+    // Complex baseband in place
+    void process_iq(float* in_i, float* in_q, size_t n);
+
+    // Delay of process() output behind its input, in samples
+    size_t latency() const { return hilbert_half_; }
+
+private:
+    struct Path {
+        double delay;          // samples
+        float amplitude;
+        uint32_t shift_step;   // Doppler shift NCO
+        uint32_t shift_phase;
+        size_t gain_step;      // samples per low-rate gain point
+        std::vector<float> kernel;  // Gaussian Doppler shaping filter
+        std::vector<float> white_i, white_q;  // white input from point white_start
+        uint64_t white_start;
+        uint64_t point;        // index of the low-rate point being approached
+        float g_re, g_im;      // interpolated gain
+        float t_re, t_im;      // gain at the next point
+        float d_re, d_im;      // per-sample increment towards it
+        size_t left;           // samples left before reaching it
+    };
+
+    float gain_point(Path& p, size_t path, uint64_t point, float& im) const;
+    void next_point(Path& p, size_t path);
+    void hilbert(const float* x, float* out, size_t n) const;
+    void render(float* out_re, float* out_im, size_t n);
+
+    double sample_rate_;
+    uint64_t seed_;
+    std::vector<Path> paths_;
+    size_t max_delay_;
+    size_t hilbert_half_;
+    std::vector<float> hilbert_; // odd taps 1, 3, ... of the Hilbert FIR
+    std::vector<float> input_;   // real input history for the Hilbert FIR
+    std::vector<float> hist_i_;  // analytic history for the path delays
+    std::vector<float> hist_q_;
+};
+
+#endif
@@ -0,0 +1,206 @@
+// fano.cpp
+//
+// Fano sequential decoding of the K=32 rate 1/2 code, after Phil Karn's
+// fano.c as used by wsprd.
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "fano.h"
+#include "parallel.h"
+
+typedef std::chrono::steady_clock fano_clock;
+
+const FanoConfig DEFAULT_FANO_CONFIG = {
+    3.0,     // ebn0_db
+    0.45,    // bias
+    60,      // delta
+    10000,   // max_cycles
+    0.0      // time_budget
+};
+
+// Metric table units per bit of likelihood
+static const double METRIC_SCALE = 10.0;
+// Soft symbol rms of the wsprdemod format
+static const double SOFT_RMS = 50.0;
+// Cycles between wall clock checks
+static const long CLOCK_INTERVAL = 4096;
+
+static inline int parity(uint32_t x) {
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return (int)(x & 1);
+}
+
+// The two code bits for a register state, first polynomial in bit 1
+static inline int encode_pair(uint32_t state) {
+    return parity(state & CONV_POLY_0) << 1 | parity(state & CONV_POLY_1);
+}
+
+void conv_encode(const uint8_t* data, int nbits, uint8_t* code) {
+    uint32_t reg = 0;
+    for (int i = 0; i < nbits + CONV_TAIL_BITS; i++) {
+        int bit = i < nbits ? (data[i / 8] >> (7 - i % 8)) & 1 : 0;
+        reg = reg << 1 | (uint32_t)bit;
+        int pair = encode_pair(reg);
+        code[2 * i] = (uint8_t)(pair >> 1);
+        code[2 * i + 1] = (uint8_t)(pair & 1);
+    }
+}
+
+FanoDecoder::FanoDecoder(const FanoConfig& config) : config_(config) {
+    // Antipodal code bits in Gaussian noise, scaled like the soft symbols:
+    // rms^2 = a^2 + sigma^2 with a / sigma = sqrt(2 Es/N0)
+    double esn0 = std::pow(10.0, config.ebn0_db / 10.0) * 0.5;
+    double sigma = SOFT_RMS / std::sqrt(1.0 + 2.0 * esn0);
+    double a = sigma * std::sqrt(2.0 * esn0);
+    for (int s = 0; s < 256; s++) {
+        // Log-likelihood ratio of a 1, and the Fano metric
+        // log2(2 p(x|b) / (p(x|0) + p(x|1))) - bias for each bit
+        double llr = 2.0 * a * (s - 128) / (sigma * sigma);
+        double m1 = 1.0 - (llr > 0 ? std::log1p(std::exp(-llr)) : std::log1p(std::exp(llr)) - llr) / M_LN2;
+        double m0 = 1.0 - (llr < 0 ? std::log1p(std::exp(llr)) : std::log1p(std::exp(-llr)) + llr) / M_LN2;
+        metric_[1][s] = (int)std::lround(METRIC_SCALE * (m1 - config.bias));
+        metric_[0][s] = (int)std::lround(METRIC_SCALE * (m0 - config.bias));
+    }
+}
+
+namespace {
+struct FanoNode {
+    uint32_t state;    // encoder register with this node's bit in bit 0
+    int gamma;         // path metric up to this node
+    int branch[2];     // better and worse branch metrics
+    int tried;         // index into branch of the branch being followed
+};
+}
+
+FanoResult FanoDecoder::decode(const uint8_t* soft, int nbits) const {
+    FanoResult result;
+    std::memset(&result, 0, sizeof(result));
+    int nodes_count = nbits + CONV_TAIL_BITS;
+    if (nbits < 1 || nbits > FANO_MAX_DATA_BITS) {
+        result.status = FANO_CYCLE_LIMIT;
+        return result;
+    }
+
+    // Branch metrics for the four code bit pairs at every node
+    std::vector<int> pair_metric(4 * nodes_count);
+    for (int i = 0; i < nodes_count; i++) {
+        const int* a0 = metric_[0];
+        const int* a1 = metric_[1];
+        int s0 = soft[2 * i], s1 = soft[2 * i + 1];
+        pair_metric[4 * i + 0] = a0[s0] + a0[s1];
+        pair_metric[4 * i + 1] = a0[s0] + a1[s1];
+        pair_metric[4 * i + 2] = a1[s0] + a0[s1];
+        pair_metric[4 * i + 3] = a1[s0] + a1[s1];
+    }
+
+    std::vector<FanoNode> nodes(nodes_count + 1);
+    FanoNode* first = &nodes[0];
+    FanoNode* tail = first + nbits;          // only 0 bits from here on
+    FanoNode* last = first + nodes_count;
+
+    // Order the two branches out of np; both polynomials tap bit 0, so
+    // the 1 branch's code bits are the 0 branch's complemented
+    auto expand = [&](FanoNode* np) {
+        const int* m = &pair_metric[4 * (np - first)];
+        int pair = encode_pair(np->state);
+        if (np >= tail) {
+            np->branch[0] = m[pair];
+        } else {
+            int m0 = m[pair], m1 = m[3 ^ pair];
+            if (m0 >= m1) {
+                np->branch[0] = m0;
+                np->branch[1] = m1;
+            } else {
+                np->branch[0] = m1;
+                np->branch[1] = m0;
+                np->state++;
+            }
+        }
+        np->tried = 0;
+    };
+
+    first->state = 0;
+    first->gamma = 0;
+    expand(first);
+
+    const int delta = config_.delta;
+    const long max_cycles = config_.max_cycles * nbits;
+    const bool timed = config_.time_budget > 0.0;
+    fano_clock::time_point deadline;
+    if (timed) {
+        deadline = fano_clock::now() +
+                   std::chrono::duration_cast<fano_clock::duration>(
+                       std::chrono::duration<double>(config_.time_budget));
+    }
+
+    FanoNode* np = first;
+    int threshold = 0;
+    long cycles;
+    result.status = FANO_CYCLE_LIMIT;
+    for (cycles = 1; cycles <= max_cycles; cycles++) {
+        if (timed && cycles % CLOCK_INTERVAL == 0 && fano_clock::now() > deadline) {
+            result.status = FANO_TIMEOUT;
+            break;
+        }
+
+        // Look forward
+        int ngamma = np->gamma + np->branch[np->tried];
+        if (ngamma >= threshold) {
+            // First visit to this node: tighten the threshold
+            if (np->gamma < threshold + delta) {
+                while (ngamma >= threshold + delta) threshold += delta;
+            }
+            np[1].gamma = ngamma;
+            np[1].state = np->state << 1;
+            if (++np == last) {
+                result.status = FANO_OK;
+                break;
+            }
+            expand(np);
+            continue;
+        }
+
+        // Threshold violated: look back for a node that allows it
+        for (;;) {
+            if (np == first || np[-1].gamma < threshold) {
+                // Can't back up; loosen the threshold and start over
+                // from the best branch of this node
+                threshold -= delta;
+                if (np->tried != 0) {
+                    np->tried = 0;
+                    np->state ^= 1;
+                }
+                break;
+            }
+            --np;
+            if (np < tail && np->tried != 1) {
+                // Try the worse branch of the earlier node
+                np->tried++;
+                np->state ^= 1;
+                break;
+            }
+        }
+    }
+
+    result.cycles = cycles < max_cycles ? cycles : max_cycles;
+    result.metric = np->gamma;
+    if (result.status == FANO_OK) {
+        for (int i = 0; i < nbits; i++) {
+            if (nodes[i].state & 1) result.data[i / 8] |= (uint8_t)(0x80 >> (i % 8));
+        }
+    }
+    return result;
+}
+
+std::vector<FanoResult> FanoDecoder::decode_batch(const uint8_t* soft, size_t frames, int nbits,
+                                                  int threads) const {
+    std::vector<FanoResult> results(frames);
+    size_t stride = (size_t)conv_code_bits(nbits);
+    parallel_for(frames, threads, [&](size_t f) { results[f] = decode(soft + f * stride, nbits); });
+    return results;
+}
@@ -0,0 +1,76 @@
+// fano.h
+//
+// Soft-decision Fano sequential decoder for the K=32 rate 1/2
+// convolutional code of JTEncode::convolve (polynomials 0xf2d05351 and
+// 0xe4613c47), used by WSPR (50 data bits) and JT9 (72 data bits), each
+// followed by 31 zero tail bits.
+//
+// Soft symbols are bytes in the wsprdemod format: 128 carries no
+// information, larger values favour a 1, and the rms is about 50. The
+// branch metrics come from a table built for a Gaussian channel at a
+// design Eb/N0. The search is bounded by a cycle limit per data bit and
+// optionally by wall time, so a hopeless frame costs a known maximum.
+
+#ifndef FANO_H
+#define FANO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint32_t CONV_POLY_0 = 0xf2d05351;
+const uint32_t CONV_POLY_1 = 0xe4613c47;
+const int CONV_TAIL_BITS = 31;
+const int FANO_MAX_DATA_BITS = 128;
+
+// Code bits produced for nbits data bits plus the tail
+inline int conv_code_bits(int nbits) { return 2 * (nbits + CONV_TAIL_BITS); }
+
+// Encode nbits data bits (MSB first in data) plus the zero tail into
+// conv_code_bits(nbits) code bits; the same output as JTEncode::convolve
+void conv_encode(const uint8_t* data, int nbits, uint8_t* code);
+
+enum FanoStatus {
+    FANO_OK,            // reached the end of the tail
+    FANO_CYCLE_LIMIT,   // gave up after max_cycles per data bit
+    FANO_TIMEOUT        // gave up after time_budget seconds
+};
+
+struct FanoConfig {
+    double ebn0_db;       // design Eb/N0 of the metric table
+    double bias;          // per-bit metric bias (the code rate in theory)
+    int delta;            // threshold step
+    long max_cycles;      // per data bit
+    double time_budget;   // seconds per frame, 0 for none
+};
+
+// wsprd's settings: delta 60, bias 0.45, 10000 cycles per bit
+extern const FanoConfig DEFAULT_FANO_CONFIG;
+
+struct FanoResult {
+    FanoStatus status;
+    long cycles;                               // forward and backward moves
+    int metric;                                // path metric at the end
+    uint8_t data[FANO_MAX_DATA_BITS / 8];      // MSB first, valid when FANO_OK
+};
+
+class FanoDecoder {
+public:
+    explicit FanoDecoder(const FanoConfig& config = DEFAULT_FANO_CONFIG);
+
+    // Decode conv_code_bits(nbits) soft symbols in code order
+    FanoResult decode(const uint8_t* soft, int nbits) const;
+
+    // Decode frames of conv_code_bits(nbits) soft symbols stored back to
+    // back, on up to threads threads
+    std::vector<FanoResult> decode_batch(const uint8_t* soft, size_t frames, int nbits,
+                                         int threads) const;
+
+    const FanoConfig& config() const { return config_; }
+
+private:
+    FanoConfig config_;
+    int metric_[2][256];   // metric of soft value s given code bit b
+};
+
+#endif
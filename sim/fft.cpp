@@ -0,0 +1,46 @@
+// fft.cpp
+//
+// Radix-2 decimation-in-time FFT.
+
+#include <cmath>
+#include "fft.h"
+
+Fft::Fft(size_t n) : n_(n), reverse_(n), cos_(n / 2), sin_(n / 2) {
+    int bits = 0;
+    while (((size_t)1 << bits) < n) bits++;
+    for (size_t k = 0; k < n; k++) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; b++) r |= (uint32_t)((k >> b) & 1) << (bits - 1 - b);
+        reverse_[k] = r;
+    }
+    for (size_t k = 0; k < n / 2; k++) {
+        cos_[k] = (float)std::cos(2.0 * M_PI * k / n);
+        sin_[k] = (float)-std::sin(2.0 * M_PI * k / n);
+    }
+}
+
+void Fft::forward(float* re, float* im) const {
+    for (size_t k = 0; k < n_; k++) {
+        size_t r = reverse_[k];
+        if (r > k) {
+            float t = re[k]; re[k] = re[r]; re[r] = t;
+            t = im[k]; im[k] = im[r]; im[r] = t;
+        }
+    }
+    // Butterflies of span len, twiddle stride n / len
+    for (size_t len = 2; len <= n_; len <<= 1) {
+        size_t half = len / 2, stride = n_ / len;
+        for (size_t start = 0; start < n_; start += len) {
+            for (size_t j = 0; j < half; j++) {
+                float wr = cos_[j * stride], wi = sin_[j * stride];
+                size_t a = start + j, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+// fft.h
+//
+// In-place radix-2 complex FFT on split real/imaginary arrays, with the
+// twiddle factors and bit-reversal permutation computed once per size.
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Fft {
+public:
+    // n must be a power of two
+    explicit Fft(size_t n);
+
+    size_t size() const { return n_; }
+
+    // X[k] = sum x[t] exp(-2 pi i k t / n), unscaled
+    void forward(float* re, float* im) const;
+
+private:
+    size_t n_;
+    std::vector<uint32_t> reverse_;
+    std::vector<float> cos_;
+    std::vector<float> sin_;
+};
+
+#endif
@@ -0,0 +1,84 @@
+// fracdelay.cpp
+//
+// Polyphase fractional delay.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "fracdelay.h"
+
+static const size_t HISTORY = FRAC_DELAY_TAPS - 1;
+static const int LANES = 8;
+
+const size_t FractionalDelay::CHUNK;
+
+const float* frac_delay_bank() {
+    static const std::vector<float> bank = [] {
+        std::vector<float> b((FRAC_DELAY_PHASES + 1) * FRAC_DELAY_TAPS);
+        for (int p = 0; p <= FRAC_DELAY_PHASES; p++) {
+            float* h = &b[p * FRAC_DELAY_TAPS];
+            double delay = FRAC_DELAY_LATENCY + (double)p / FRAC_DELAY_PHASES;
+            double sum = 0.0;
+            for (int k = 0; k < FRAC_DELAY_TAPS; k++) {
+                double x = k - delay;
+                double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+                double w = 2.0 * M_PI * x / FRAC_DELAY_TAPS;
+                double window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+                h[k] = (float)(sinc * window);
+                sum += h[k];
+            }
+            // Unit gain at DC
+            for (int k = 0; k < FRAC_DELAY_TAPS; k++) h[k] = (float)(h[k] / sum);
+        }
+        return b;
+    }();
+    return bank.data();
+}
+
+FractionalDelay::FractionalDelay(double fraction) {
+    double pos = std::min(std::max(fraction, 0.0), 1.0) * FRAC_DELAY_PHASES;
+    int p = std::min((int)pos, FRAC_DELAY_PHASES - 1);
+    float frac = (float)(pos - p);
+    exact_ = pos == 0.0;
+
+    const float* bank = frac_delay_bank();
+    const float* a = bank + p * FRAC_DELAY_TAPS;
+    const float* b = a + FRAC_DELAY_TAPS;
+    for (int k = 0; k < FRAC_DELAY_TAPS; k++) taps_[k] = a[k] + frac * (b[k] - a[k]);
+    std::fill(history_, history_ + HISTORY, 0.0f);
+}
+
+void FractionalDelay::process(float* samples, size_t n) {
+    while (n > 0) {
+        size_t count = std::min(n, CHUNK);
+        float* x = history_ + HISTORY;
+        std::memcpy(x, samples, count * sizeof(float));
+
+        if (exact_) {
+            // Integer delay: copy out of the history
+            std::memcpy(samples, x - FRAC_DELAY_LATENCY, count * sizeof(float));
+        } else {
+            // y[t] = sum h[k] x[t - k]; LANES outputs at a time keep the
+            // inner loop a fixed-width vector op
+            size_t t = 0;
+            for (; t + LANES <= count; t += LANES) {
+                float acc[LANES] = {0.0f};
+                for (int k = 0; k < FRAC_DELAY_TAPS; k++) {
+                    const float* src = x + t - k;
+                    for (int l = 0; l < LANES; l++) acc[l] += taps_[k] * src[l];
+                }
+                for (int l = 0; l < LANES; l++) samples[t + l] = acc[l];
+            }
+            for (; t < count; t++) {
+                float acc = 0.0f;
+                for (int k = 0; k < FRAC_DELAY_TAPS; k++) acc += taps_[k] * x[t - k];
+                samples[t] = acc;
+            }
+        }
+
+        std::memmove(history_, history_ + count, HISTORY * sizeof(float));
+        samples += count;
+        n -= count;
+    }
+}
@@ -0,0 +1,39 @@
+// fracdelay.h
+//
+// Sub-sample delays from a shared polyphase bank of windowed-sinc
+// filters. The bank holds FRAC_DELAY_PHASES + 1 phases of a 32 tap
+// Blackman-windowed sinc; a delay between two phases interpolates their
+// coefficients once, so any number of delays (a whole DT grid) costs one
+// bank build.
+
+#ifndef FRACDELAY_H
+#define FRACDELAY_H
+
+#include <cstddef>
+
+const int FRAC_DELAY_TAPS = 32;
+const int FRAC_DELAY_PHASES = 256;
+// Whole samples of delay the filter adds on top of the fraction
+const size_t FRAC_DELAY_LATENCY = FRAC_DELAY_TAPS / 2 - 1;
+
+// Shared bank: phase p (0..FRAC_DELAY_PHASES) at p * FRAC_DELAY_TAPS,
+// delaying by FRAC_DELAY_LATENCY + p / FRAC_DELAY_PHASES samples
+const float* frac_delay_bank();
+
+// Streaming delay by FRAC_DELAY_LATENCY + fraction samples, fraction in
+// [0, 1). A zero fraction is an exact integer delay.
+class FractionalDelay {
+public:
+    explicit FractionalDelay(double fraction);
+
+    void process(float* samples, size_t n);
+
+private:
+    static const size_t CHUNK = 4096;
+
+    bool exact_;
+    float taps_[FRAC_DELAY_TAPS];
+    float history_[FRAC_DELAY_TAPS - 1 + CHUNK];
+};
+
+#endif
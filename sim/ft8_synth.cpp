@@ -0,0 +1,86 @@
+// ft8_synth.cpp
+//
+// FT8 GFSK waveform generation (BT = 2, as in WSJT-X gen_ft8wave).
+
+#include <cmath>
+#include <cstring>
+#include "JTEncode.h"
+#include "ft8_synth.h"
+#include "nco.h"
+
+// Frequency pulse of a unit-length symbol through a Gaussian filter
+static double gfsk_pulse(double bt, double t) {
+    double c = M_PI * sqrt(2.0 / log(2.0));
+    return 0.5 * (erf(c * bt * (t + 0.5)) - erf(c * bt * (t - 0.5)));
+}
+
+Ft8Synth::Ft8Synth(int sample_rate)
+    : sample_rate_(sample_rate),
+      nsps_((size_t)llround(FT8_SYMBOL_PERIOD * sample_rate)),
+      pulse_(3 * nsps_), ramp_(nsps_ / 8) {
+    const double bt = 2.0;
+    const double tone_step = FT8_TONE_SPACING / sample_rate * 4294967296.0;
+    for (size_t i = 0; i < pulse_.size(); i++) {
+        double t = ((double)i - 1.5 * nsps_) / nsps_;
+        pulse_[i] = (uint32_t)llround(gfsk_pulse(bt, t) * tone_step);
+    }
+    for (size_t i = 0; i < ramp_.size(); i++) {
+        ramp_[i] = (1.0 - cos(M_PI * i / ramp_.size())) / 2.0;
+    }
+}
+
+size_t Ft8Synth::signal_samples() const {
+    return FT8_SYMBOL_COUNT * nsps_;
+}
+
+size_t Ft8Synth::frame_samples() const {
+    return (size_t)llround(FT8_FRAME_PERIOD * sample_rate_);
+}
+
+void Ft8Synth::render_signal(const uint8_t* tones, double f0, float amplitude, float* out) const {
+    const size_t nsps = nsps_;
+    const uint32_t* p0 = &pulse_[0];         // pulse of the next symbol
+    const uint32_t* p1 = &pulse_[nsps];      // pulse centred on this symbol
+    const uint32_t* p2 = &pulse_[2 * nsps];  // tail of the previous symbol
+    const uint32_t base = Nco(sample_rate_).step_for(f0);
+    const float* table = nco_sine_table();
+
+    uint32_t phase = 0;
+    for (int m = 0; m < FT8_SYMBOL_COUNT; m++, out += nsps) {
+        // The first and last tones are extended by one dummy symbol
+        uint32_t next = tones[m + 1 < FT8_SYMBOL_COUNT ? m + 1 : m];
+        uint32_t cur = tones[m];
+        uint32_t prev = tones[m > 0 ? m - 1 : m];
+        for (size_t r = 0; r < nsps; r++) {
+            out[r] = amplitude * nco_lookup(table, phase);
+            phase += base + next * p0[r] + cur * p1[r] + prev * p2[r];
+        }
+    }
+    out -= signal_samples();
+
+    const size_t nramp = ramp_.size();
+    float* tail = out + signal_samples() - nramp;
+    for (size_t i = 0; i < nramp; i++) {
+        out[i] *= ramp_[i];
+        tail[i] *= ramp_[nramp - 1 - i];
+    }
+}
+
+void Ft8Synth::render_frame(const uint8_t* tones, double f0, double start, float amplitude, float* out) const {
+    const size_t frame = frame_samples();
+    const size_t sig = signal_samples();
+    size_t lead = start > 0 ? (size_t)llround(start * sample_rate_) : 0;
+    if (lead + sig > frame) lead = frame - sig;
+
+    memset(out, 0, lead * sizeof(float));
+    render_signal(tones, f0, amplitude, out + lead);
+    memset(out + lead + sig, 0, (frame - lead - sig) * sizeof(float));
+}
+
+void Ft8Synth::render_batch(const uint8_t* tones, const double* f0, int count, double start,
+                            float amplitude, float* out) const {
+    const size_t frame = frame_samples();
+    for (int i = 0; i < count; i++) {
+        render_frame(tones + (size_t)i * FT8_SYMBOL_COUNT, f0[i], start, amplitude, out + i * frame);
+    }
+}
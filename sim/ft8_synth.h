@@ -0,0 +1,50 @@
+// ft8_synth.h
+//
+// FT8 GFSK waveform generation (BT = 2, as in WSJT-X gen_ft8wave).
+
+#ifndef FT8_SYNTH_H
+#define FT8_SYNTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const double FT8_SYMBOL_PERIOD = 0.16;   // seconds
+const double FT8_TONE_SPACING  = 6.25;   // Hz
+const double FT8_FRAME_PERIOD  = 15.0;   // seconds per T/R cycle
+const double FT8_START_TIME    = 0.5;    // signal start within the frame (DT = 0)
+
+// The Gaussian frequency pulse spans three symbols. Its shape is tabulated
+// once per sample rate in fixed point (phase step per tone index, in
+// 2^-32 cycles), so the instantaneous frequency of every sample is an
+// integer overlap-add of three table entries, and the phase is integrated
+// in a wrapping 32-bit accumulator.
+class Ft8Synth {
+public:
+    explicit Ft8Synth(int sample_rate);
+
+    int sample_rate() const { return sample_rate_; }
+    size_t symbol_samples() const { return nsps_; }
+    size_t signal_samples() const;   // 79 symbols
+    size_t frame_samples() const;    // one 15 s frame
+
+    // 79 tones with tone 0 at f0 Hz: writes signal_samples() samples,
+    // with the WSJT-X nsps/8 ramps at both ends
+    void render_signal(const uint8_t* tones, double f0, float amplitude, float* out) const;
+
+    // One frame with the signal starting start seconds in; frame_samples() samples
+    void render_frame(const uint8_t* tones, double f0, double start, float amplitude, float* out) const;
+
+    // count frames back to back (count * frame_samples() samples); tones
+    // holds FT8_SYMBOL_COUNT symbols per frame, f0 one frequency per frame
+    void render_batch(const uint8_t* tones, const double* f0, int count, double start,
+                      float amplitude, float* out) const;
+
+private:
+    int sample_rate_;
+    size_t nsps_;
+    std::vector<uint32_t> pulse_;  // 3 * nsps entries
+    std::vector<float> ramp_;      // nsps / 8 rising ramp
+};
+
+#endif
@@ -0,0 +1,359 @@
+// ldpc.cpp
+//
+// FT8 (174,91) LDPC encoding and layered min-sum decoding.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "Arduino.h"
+#include "crc14.h"
+#include "generator.h"
+#include "ldpc.h"
+#include "parallel.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+const LdpcConfig DEFAULT_LDPC_CONFIG = {
+    30,      // max_iterations
+    0.75f    // scale
+};
+
+const int Ft8Ldpc::LANES;
+
+// Packed codeword: bit i in word i / 64
+static const int WORDS = (FT8_LDPC_N + 63) / 64;
+// Dual codewords up to this weight are collected for the sparse checks
+static const int MAX_CHECK_WEIGHT = 7;
+// Information sets tried before settling for what was found
+static const int MAX_ROUNDS = 20000;
+
+namespace {
+struct PackedRow {
+    uint64_t w[WORDS];
+    bool get(int i) const { return (w[i / 64] >> (i % 64)) & 1; }
+    void flip(int i) { w[i / 64] ^= (uint64_t)1 << (i % 64); }
+    int weight() const {
+        int n = 0;
+        for (int k = 0; k < WORDS; k++) n += __builtin_popcountll(w[k]);
+        return n;
+    }
+    void add(const PackedRow& o) {
+        for (int k = 0; k < WORDS; k++) w[k] ^= o.w[k];
+    }
+    bool operator==(const PackedRow& o) const { return std::memcmp(w, o.w, sizeof(w)) == 0; }
+};
+
+struct SparseChecks {
+    std::vector<int> start;       // FT8_LDPC_M + 1 offsets into bits
+    std::vector<int> bits;
+    std::vector<PackedRow> rows;  // the same checks as bit masks
+    int max_degree;
+};
+}
+
+static bool generator_bit(int row, int col) {
+    return (pgm_read_byte(&generator_bits[row][col / 8]) >> (7 - col % 8)) & 1;
+}
+
+static uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Reduce v by an echelon basis (pivot = lowest set bit); true if v was
+// independent of it, in which case it joins the basis
+static bool add_independent(std::vector<PackedRow>& basis, std::vector<int>& pivots, PackedRow v) {
+    for (size_t b = 0; b < basis.size(); b++) {
+        if (v.get(pivots[b])) v.add(basis[b]);
+    }
+    for (int i = 0; i < FT8_LDPC_N; i++) {
+        if (v.get(i)) {
+            // Keep the basis reduced at the new pivot
+            for (size_t b = 0; b < basis.size(); b++) {
+                if (basis[b].get(i)) basis[b].add(v);
+            }
+            basis.push_back(v);
+            pivots.push_back(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static SparseChecks build_sparse_checks() {
+    // Systematic checks: parity bit 91 + i is the sum of generator row i
+    // over the message bits
+    std::vector<PackedRow> systematic(FT8_LDPC_M);
+    for (int i = 0; i < FT8_LDPC_M; i++) {
+        std::memset(systematic[i].w, 0, sizeof(systematic[i].w));
+        for (int j = 0; j < FT8_LDPC_K; j++) {
+            if (generator_bit(i, j)) systematic[i].flip(j);
+        }
+        systematic[i].flip(FT8_LDPC_K + i);
+    }
+
+    // Row-reducing the checks with pivots in a random column order gives
+    // rows with one pivot each; a low-weight dual codeword shows up as
+    // one of them whenever few of its bits land in pivot columns
+    std::vector<PackedRow> found, basis;
+    std::vector<int> pivots;
+    std::vector<int> perm(FT8_LDPC_N);
+    for (int i = 0; i < FT8_LDPC_N; i++) perm[i] = i;
+    uint64_t rng = 0x5eed;
+    for (int round = 0; round < MAX_ROUNDS && (int)basis.size() < FT8_LDPC_M; round++) {
+        for (int i = FT8_LDPC_N - 1; i > 0; i--) {
+            std::swap(perm[i], perm[splitmix64(rng) % (uint64_t)(i + 1)]);
+        }
+        std::vector<PackedRow> rows = systematic;
+        int r = 0;
+        for (int c = 0; c < FT8_LDPC_N && r < FT8_LDPC_M; c++) {
+            int col = perm[c];
+            int k = r;
+            while (k < FT8_LDPC_M && !rows[k].get(col)) k++;
+            if (k == FT8_LDPC_M) continue;
+            std::swap(rows[r], rows[k]);
+            for (int o = 0; o < FT8_LDPC_M; o++) {
+                if (o != r && rows[o].get(col)) rows[o].add(rows[r]);
+            }
+            r++;
+        }
+        for (int i = 0; i < FT8_LDPC_M; i++) {
+            if (rows[i].weight() > MAX_CHECK_WEIGHT) continue;
+            if (std::find(found.begin(), found.end(), rows[i]) != found.end()) continue;
+            found.push_back(rows[i]);
+            add_independent(basis, pivots, rows[i]);
+        }
+    }
+
+    // Keep an independent set of the low-weight checks, in the order found;
+    // if the search fell short, the systematic checks fill the rank
+    std::vector<PackedRow> checks, echelon;
+    pivots.clear();
+    for (size_t i = 0; i < found.size() && (int)checks.size() < FT8_LDPC_M; i++) {
+        if (add_independent(echelon, pivots, found[i])) checks.push_back(found[i]);
+    }
+    for (int i = 0; i < FT8_LDPC_M && (int)checks.size() < FT8_LDPC_M; i++) {
+        if (add_independent(echelon, pivots, systematic[i])) checks.push_back(systematic[i]);
+    }
+
+    SparseChecks h;
+    h.max_degree = 0;
+    h.rows = checks;
+    h.start.push_back(0);
+    for (size_t c = 0; c < checks.size(); c++) {
+        int degree = 0;
+        for (int i = 0; i < FT8_LDPC_N; i++) {
+            if (checks[c].get(i)) {
+                h.bits.push_back(i);
+                degree++;
+            }
+        }
+        h.max_degree = std::max(h.max_degree, degree);
+        h.start.push_back((int)h.bits.size());
+    }
+    return h;
+}
+
+static const SparseChecks& sparse_checks() {
+    static const SparseChecks h = build_sparse_checks();
+    return h;
+}
+
+uint16_t ft8_crc14(const uint8_t* message) {
+    // 77 bits and three zeros in ten bytes, then two zero bytes
+    uint8_t bytes[12];
+    std::memset(bytes, 0, sizeof(bytes));
+    for (int i = 0; i < FT8_MESSAGE_BITS; i++) bytes[i / 8] |= (uint8_t)((message[i] & 1) << (7 - i % 8));
+    crc_cfg_t cfg;
+    cfg.reflect_in = 0;
+    cfg.xor_in = 0;
+    cfg.reflect_out = 0;
+    cfg.xor_out = 0;
+    crc_t crc = crc_init(&cfg);
+    return (uint16_t)crc_update(&cfg, crc, bytes, sizeof(bytes));
+}
+
+void ft8_ldpc_encode(const uint8_t* message, uint8_t* codeword) {
+    for (int i = 0; i < FT8_MESSAGE_BITS; i++) codeword[i] = message[i] & 1;
+    uint16_t crc = ft8_crc14(message);
+    for (int i = 0; i < 14; i++) codeword[FT8_MESSAGE_BITS + i] = (crc >> (13 - i)) & 1;
+    for (int i = 0; i < FT8_LDPC_M; i++) {
+        int sum = 0;
+        for (int j = 0; j < FT8_LDPC_K; j++) sum ^= codeword[j] & (int)generator_bit(i, j);
+        codeword[FT8_LDPC_K + i] = (uint8_t)sum;
+    }
+}
+
+Ft8Ldpc::Ft8Ldpc(const LdpcConfig& config) : config_(config) {
+    sparse_checks();
+}
+
+const std::vector<int>& Ft8Ldpc::check_start() const {
+    return sparse_checks().start;
+}
+
+const std::vector<int>& Ft8Ldpc::check_bits() const {
+    return sparse_checks().bits;
+}
+
+// Fill in a result from the hard decisions of one lane
+static void finish_lane(const PackedRow& hard, const float* llr, bool ok, int iterations,
+                        LdpcResult& out) {
+    out.ok = ok;
+    out.iterations = iterations;
+    out.hard_errors = 0;
+    for (int i = 0; i < FT8_LDPC_N; i++) out.hard_errors += (llr[i] > 0.0f) != hard.get(i);
+    std::memset(out.bits, 0, sizeof(out.bits));
+    for (int i = 0; i < FT8_LDPC_K; i++) {
+        if (hard.get(i)) out.bits[i / 8] |= (uint8_t)(0x80 >> (i % 8));
+    }
+}
+
+static bool crc_matches(const PackedRow& hard) {
+    uint8_t message[FT8_MESSAGE_BITS];
+    for (int i = 0; i < FT8_MESSAGE_BITS; i++) message[i] = hard.get(i);
+    uint16_t crc = ft8_crc14(message);
+    for (int i = 0; i < 14; i++) {
+        if (((crc >> (13 - i)) & 1) != (int)hard.get(FT8_MESSAGE_BITS + i)) return false;
+    }
+    return true;
+}
+
+// One layer of min-sum: update check messages c2v (LANES per edge) from
+// the posteriors of the check's bits, and the posteriors from them
+#if defined(__SSE2__)
+static void update_check(float* post, float* c2v, const int* bits, int degree, float scale, float* t) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (int h = 0; h < Ft8Ldpc::LANES; h += 4) {
+        __m128 min1 = _mm_set1_ps(1e30f), min2 = min1, sign = _mm_setzero_ps();
+        // Bit-to-check messages with this check's old message removed
+        for (int k = 0; k < degree; k++) {
+            __m128 v = _mm_sub_ps(_mm_loadu_ps(post + bits[k] * Ft8Ldpc::LANES + h),
+                                  _mm_loadu_ps(c2v + k * Ft8Ldpc::LANES + h));
+            __m128 a = _mm_andnot_ps(sign_mask, v);
+            _mm_storeu_ps(t + k * 4, v);
+            min2 = _mm_min_ps(min2, _mm_max_ps(min1, a));
+            min1 = _mm_min_ps(min1, a);
+            sign = _mm_xor_ps(sign, _mm_and_ps(v, sign_mask));
+        }
+        // New messages: the smallest other magnitude, scaled
+        for (int k = 0; k < degree; k++) {
+            __m128 v = _mm_loadu_ps(t + k * 4);
+            __m128 a = _mm_andnot_ps(sign_mask, v);
+            __m128 eq = _mm_cmpeq_ps(a, min1);
+            __m128 mag = _mm_or_ps(_mm_and_ps(eq, min2), _mm_andnot_ps(eq, min1));
+            __m128 m = _mm_xor_ps(_mm_mul_ps(vscale, mag), _mm_xor_ps(sign, _mm_and_ps(v, sign_mask)));
+            _mm_storeu_ps(c2v + k * Ft8Ldpc::LANES + h, m);
+            _mm_storeu_ps(post + bits[k] * Ft8Ldpc::LANES + h, _mm_add_ps(v, m));
+        }
+    }
+}
+#else
+static void update_check(float* post, float* c2v, const int* bits, int degree, float scale, float* t) {
+    const int L = Ft8Ldpc::LANES;
+    float min1[L], min2[L];
+    bool negative[L];
+    for (int l = 0; l < L; l++) {
+        min1[l] = min2[l] = 1e30f;
+        negative[l] = false;
+    }
+    for (int k = 0; k < degree; k++) {
+        for (int l = 0; l < L; l++) {
+            float v = post[bits[k] * L + l] - c2v[k * L + l];
+            float a = std::fabs(v);
+            t[k * L + l] = v;
+            min2[l] = std::min(min2[l], std::max(min1[l], a));
+            min1[l] = std::min(min1[l], a);
+            negative[l] ^= std::signbit(v);
+        }
+    }
+    for (int k = 0; k < degree; k++) {
+        for (int l = 0; l < L; l++) {
+            float v = t[k * L + l];
+            float a = std::fabs(v);
+            float mag = scale * (a == min1[l] ? min2[l] : min1[l]);
+            float m = negative[l] != std::signbit(v) ? -mag : mag;
+            c2v[k * L + l] = m;
+            post[bits[k] * L + l] = v + m;
+        }
+    }
+}
+#endif
+
+void Ft8Ldpc::decode_lanes(const float* llr, int count, LdpcResult* out) const {
+    const SparseChecks& h = sparse_checks();
+    const int L = LANES;
+    const size_t edges = h.bits.size();
+
+    // Posterior LLRs and check-to-bit messages, frames interleaved. They
+    // are kept as log(P(0) / P(1)), so a check's sign is the plain
+    // product of the others'.
+    std::vector<float> post(FT8_LDPC_N * L, 0.0f), c2v(edges * L, 0.0f);
+    for (int l = 0; l < count; l++) {
+        for (int i = 0; i < FT8_LDPC_N; i++) post[i * L + l] = -llr[l * FT8_LDPC_N + i];
+    }
+    std::vector<float> t(h.max_degree * L);
+    bool done[LANES];
+    int remaining = count;
+    for (int l = 0; l < L; l++) done[l] = l >= count;
+
+    int it;
+    for (it = 1; it <= config_.max_iterations && remaining > 0; it++) {
+        for (int c = 0; c < FT8_LDPC_M; c++) {
+            int first = h.start[c];
+            update_check(post.data(), &c2v[first * L], &h.bits[first], h.start[c + 1] - first,
+                         config_.scale, t.data());
+        }
+
+        for (int l = 0; l < L; l++) {
+            if (done[l]) continue;
+            PackedRow hard;
+            std::memset(hard.w, 0, sizeof(hard.w));
+            for (int i = 0; i < FT8_LDPC_N; i++) {
+                if (post[i * L + l] < 0.0f) hard.flip(i);
+            }
+            bool syndrome = false;
+            for (int c = 0; c < FT8_LDPC_M && !syndrome; c++) {
+                int parity = 0;
+                for (int k = 0; k < WORDS; k++) parity ^= __builtin_parityll(hard.w[k] & h.rows[c].w[k]);
+                syndrome = parity != 0;
+            }
+            if (syndrome || !crc_matches(hard)) continue;
+            finish_lane(hard, &llr[l * FT8_LDPC_N], true, it, out[l]);
+            done[l] = true;
+            remaining--;
+        }
+    }
+
+    for (int l = 0; l < count; l++) {
+        if (done[l]) continue;
+        PackedRow hard;
+        std::memset(hard.w, 0, sizeof(hard.w));
+        for (int i = 0; i < FT8_LDPC_N; i++) {
+            if (post[i * L + l] < 0.0f) hard.flip(i);
+        }
+        finish_lane(hard, &llr[l * FT8_LDPC_N], false, config_.max_iterations, out[l]);
+    }
+}
+
+LdpcResult Ft8Ldpc::decode(const float* llr) const {
+    LdpcResult result;
+    decode_lanes(llr, 1, &result);
+    return result;
+}
+
+std::vector<LdpcResult> Ft8Ldpc::decode_batch(const float* llr, size_t frames, int threads) const {
+    std::vector<LdpcResult> results(frames);
+    size_t groups = (frames + LANES - 1) / LANES;
+    parallel_for(groups, threads, [&](size_t g) {
+        size_t first = g * LANES;
+        int count = (int)std::min<size_t>(LANES, frames - first);
+        decode_lanes(llr + first * FT8_LDPC_N, count, &results[first]);
+    });
+    return results;
+}
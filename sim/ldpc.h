@@ -0,0 +1,76 @@
+// ldpc.h
+//
+// Decoder for the FT8 (174,91) LDPC code of JTEncode::ft8_encode: 77
+// message bits, a 14-bit CRC, then 83 parity bits from generator_bits.
+//
+// The systematic parity checks that follow from generator_bits are
+// dense, so the sparse parity-check matrix belief propagation needs
+// (83 checks of weight 6 or 7, every bit in 3 checks) is recovered from
+// them once, by information set search for low-weight dual codewords.
+//
+// Decoding is layered normalized min-sum. Eight frames are decoded
+// together with their messages interleaved, so the per-check arithmetic
+// is a fixed-width vector op over frames; hard decisions are bit-packed
+// for the syndrome check, and a frame stops as soon as its parity checks
+// and CRC are satisfied.
+//
+// LLRs are log(P(1) / P(0)): positive favours a 1, as in the soft
+// symbols of the other decoders.
+
+#ifndef LDPC_H
+#define LDPC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const int FT8_LDPC_N = 174;        // codeword bits
+const int FT8_LDPC_K = 91;         // message + CRC bits
+const int FT8_LDPC_M = 83;         // parity checks
+const int FT8_MESSAGE_BITS = 77;
+
+// CRC-14 of 77 message bits (one per byte), as ft8_encode computes it
+uint16_t ft8_crc14(const uint8_t* message);
+
+// Codeword (174 bits, one per byte) for 77 message bits; the same bits
+// ft8_encode maps onto its 58 data symbols
+void ft8_ldpc_encode(const uint8_t* message, uint8_t* codeword);
+
+struct LdpcConfig {
+    int max_iterations;
+    float scale;          // min-sum normalization
+};
+
+extern const LdpcConfig DEFAULT_LDPC_CONFIG;
+
+struct LdpcResult {
+    bool ok;              // parity checks and CRC satisfied
+    int iterations;
+    int hard_errors;      // channel hard decisions that were corrected
+    uint8_t bits[12];     // 91 message + CRC bits, MSB first
+};
+
+class Ft8Ldpc {
+public:
+    explicit Ft8Ldpc(const LdpcConfig& config = DEFAULT_LDPC_CONFIG);
+
+    // One frame of 174 LLRs
+    LdpcResult decode(const float* llr) const;
+
+    // frames x 174 LLRs back to back, on up to threads threads
+    std::vector<LdpcResult> decode_batch(const float* llr, size_t frames, int threads) const;
+
+    // The sparse parity-check matrix: the bits of check c are
+    // check_bits()[check_start()[c] .. check_start()[c + 1])
+    const std::vector<int>& check_start() const;
+    const std::vector<int>& check_bits() const;
+
+    static const int LANES = 8;
+
+private:
+    void decode_lanes(const float* llr, int count, LdpcResult* out) const;
+
+    LdpcConfig config_;
+};
+
+#endif
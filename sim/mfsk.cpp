@@ -0,0 +1,203 @@
+// mfsk.cpp
+//
+// Table-driven synthesis of the JTEncode MFSK modes (JT65, JT9, JT4, WSPR,
+// FT8 and FSQ) at any sample rate.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include "JTEncode.h"
+#include "mfsk.h"
+#include "synth.h"
+
+// Timing from the WSJT protocol definitions; the Si5351JTDemo delays and
+// spacings are these values rounded to ms and hundredths of a Hz
+static const MfskMode MFSK_MODES[] = {
+    // id           name      tones spacing (Hz)      period (s)        count              term  sync         base (Hz)
+    {MFSK_JT65,    "JT65",    66, 11025.0 / 4096,  4096.0 / 11025,  JT65_SYMBOL_COUNT, -1,   SYNC_MERGED, 1270.5},
+    {MFSK_JT9,     "JT9",      9, 12000.0 / 6912,  6912.0 / 12000,  JT9_SYMBOL_COUNT,  -1,   SYNC_MERGED, 1500.0},
+    {MFSK_JT4,     "JT4",      4, 11025.0 / 2520,  2520.0 / 11025,  JT4_SYMBOL_COUNT,  -1,   SYNC_MERGED, 1000.0},
+    {MFSK_WSPR,    "WSPR",     4, 12000.0 / 8192,  8192.0 / 12000,  WSPR_SYMBOL_COUNT, -1,   SYNC_MERGED, 1500.0 - 1.5 * 12000.0 / 8192},
+    {MFSK_WSPR_15, "WSPR15",   4, 1500.0 / 8192,   65536.0 / 12000, WSPR_SYMBOL_COUNT, -1,   SYNC_MERGED, 1500.0 - 1.5 * 1500.0 / 8192},
+    {MFSK_FT8,     "FT8",      8, 6.25,            0.16,            FT8_SYMBOL_COUNT,  -1,   SYNC_MERGED, 1500.0},
+    {MFSK_FSQ_2,   "FSQ2",    33, 9000.0 / 1024,   1.0 / 2,         0,                 0xff, SYNC_NONE,   1350.0},
+    {MFSK_FSQ_3,   "FSQ3",    33, 9000.0 / 1024,   1.0 / 3,         0,                 0xff, SYNC_NONE,   1350.0},
+    {MFSK_FSQ_4_5, "FSQ4.5",  33, 9000.0 / 1024,   1.0 / 4.5,       0,                 0xff, SYNC_NONE,   1350.0},
+    {MFSK_FSQ_6,   "FSQ6",    33, 9000.0 / 1024,   1.0 / 6,         0,                 0xff, SYNC_NONE,   1350.0},
+};
+
+static const int MFSK_MODE_COUNT = sizeof(MFSK_MODES) / sizeof(MFSK_MODES[0]);
+
+const MfskMode* find_mfsk_mode(const char* name) {
+    for (int i = 0; i < MFSK_MODE_COUNT; i++) {
+        if (strcasecmp(name, MFSK_MODES[i].name) == 0) return &MFSK_MODES[i];
+    }
+    return NULL;
+}
+
+const char* mfsk_mode_names() {
+    return "JT65, JT9, JT4, WSPR, WSPR15, FT8, FSQ2, FSQ3, FSQ4.5, FSQ6";
+}
+
+int encode_mfsk_message(const MfskMode& mode, const char* text, uint8_t* symbols) {
+    JTEncode encoder;
+    memset(symbols, 0, MFSK_MAX_SYMBOLS);
+
+    switch (mode.id) {
+    case MFSK_JT65:
+        if (strlen(text) > 13) return -1;
+        encoder.jt65_encode(text, symbols);
+        break;
+    case MFSK_JT9:
+        if (strlen(text) > 13) return -1;
+        encoder.jt9_encode(text, symbols);
+        break;
+    case MFSK_JT4:
+        if (strlen(text) > 13) return -1;
+        encoder.jt4_encode(text, symbols);
+        break;
+    case MFSK_FT8:
+        if (strlen(text) > 13) return -1;
+        encoder.ft8_encode(text, symbols);
+        break;
+    case MFSK_WSPR:
+    case MFSK_WSPR_15: {
+        char call[13], grid[7];
+        int dbm;
+        if (std::sscanf(text, "%12s %6s %d", call, grid, &dbm) != 3) return -1;
+        encoder.wspr_encode(call, grid, static_cast<int8_t>(dbm), symbols);
+        break;
+    }
+    case MFSK_FSQ_2:
+    case MFSK_FSQ_3:
+    case MFSK_FSQ_4_5:
+    case MFSK_FSQ_6: {
+        char from[21];
+        int skip = 0;
+        if (std::sscanf(text, "%20s %n", from, &skip) != 1 || skip == 0) return -1;
+        if (strlen(text + skip) > 130) return -1;
+        encoder.fsq_encode(from, text + skip, symbols);
+        break;
+    }
+    }
+    return mfsk_symbol_count(mode, symbols, MFSK_MAX_SYMBOLS);
+}
+
+int mfsk_symbol_count(const MfskMode& mode, const uint8_t* symbols, int max) {
+    if (mode.terminator < 0) return mode.symbol_count < max ? mode.symbol_count : max;
+    int n = 0;
+    while (n < max && symbols[n] != mode.terminator) n++;
+    return n;
+}
+
+MfskSynth::MfskSynth(const MfskMode& mode, const uint8_t* symbols, int count,
+                     double sample_rate, double base_freq, float amplitude)
+    : mode_(mode), symbols_(symbols), count_(count), sample_rate_(sample_rate),
+      base_freq_(base_freq), amplitude_(amplitude), delay_(0), tail_(0),
+      ramp_((size_t)(0.02 * sample_rate)), drift_(0.0), drift2_(0.0), pos_(0), sym_(0),
+      nco_(sample_rate) {
+}
+
+void MfskSynth::set_drift(double per_min, double per_min2) {
+    drift_ = per_min;
+    drift2_ = per_min2;
+}
+
+double MfskSynth::drift_offset(size_t pos) const {
+    double middle = (symbol_start(0) + symbol_start(count_)) / 2.0;
+    double minutes = (pos - middle) / sample_rate_ / 60.0;
+    return minutes * (drift_ + minutes * drift2_);
+}
+
+size_t MfskSynth::symbol_start(int k) const {
+    return delay_ + (size_t)llround(k * mode_.symbol_period * sample_rate_);
+}
+
+size_t MfskSynth::total_samples() const {
+    return symbol_start(count_) + tail_;
+}
+
+void MfskSynth::rewind() {
+    pos_ = 0;
+    sym_ = 0;
+    nco_.set_phase_word(0);
+}
+
+void MfskSynth::apply_ramp(float* out, size_t start, size_t n) const {
+    size_t first = delay_;
+    size_t last = symbol_start(count_);
+    size_t ramp = std::min(ramp_, (last - first) / 2);
+    if (ramp == 0) return;
+    size_t end = start + n;
+
+    // Fade in
+    for (size_t p = std::max(start, first); p < std::min(end, first + ramp); p++) {
+        out[p - start] *= raised_cosine(1.0 - (double)(p - first) / ramp);
+    }
+    // Fade out
+    for (size_t p = std::max(start, last - ramp); p < std::min(end, last); p++) {
+        out[p - start] *= raised_cosine((double)(p - (last - ramp)) / ramp);
+    }
+}
+
+size_t MfskSynth::render(float* out, size_t n) {
+    return render_impl(out, NULL, n);
+}
+
+size_t MfskSynth::render_iq(float* out_i, float* out_q, size_t n) {
+    return render_impl(out_i, out_q, n);
+}
+
+size_t MfskSynth::render_impl(float* out, float* out_q, size_t n) {
+    size_t written = 0;
+    size_t end = total_samples();
+    size_t last = symbol_start(count_);
+
+    while (written < n && pos_ < end) {
+        size_t start = pos_;
+        size_t todo = n - written;
+
+        if (pos_ < delay_ || pos_ >= last) {
+            // Leading or trailing silence
+            size_t stop = pos_ < delay_ ? delay_ : end;
+            size_t len = stop - pos_ < todo ? stop - pos_ : todo;
+            memset(out + written, 0, len * sizeof(float));
+            if (out_q) memset(out_q + written, 0, len * sizeof(float));
+            pos_ += len;
+            written += len;
+            continue;
+        }
+
+        while (sym_ < count_ && symbol_start(sym_ + 1) <= pos_) sym_++;
+        size_t sym_end = symbol_start(sym_ + 1);
+        size_t len = sym_end - pos_ < todo ? sym_end - pos_ : todo;
+
+        uint8_t s = symbols_[sym_];
+        double freq = base_freq_ + s * mode_.tone_spacing;
+        if (drift_ != 0.0 || drift2_ != 0.0) {
+            // Retune at the middle of each drift block
+            for (size_t j = 0; j < len; ) {
+                size_t p = pos_ + j;
+                size_t block_end = (p / MFSK_DRIFT_BLOCK + 1) * MFSK_DRIFT_BLOCK;
+                size_t m = std::min(len - j, block_end - p);
+                nco_.set_freq(freq + drift_offset(block_end - MFSK_DRIFT_BLOCK / 2));
+                if (out_q) nco_.generate_iq(out + written + j, out_q + written + j, m, amplitude_);
+                else nco_.generate(out + written + j, m, amplitude_);
+                j += m;
+            }
+        } else {
+            nco_.set_freq(freq);
+            if (out_q) nco_.generate_iq(out + written, out_q + written, len, amplitude_);
+            else nco_.generate(out + written, len, amplitude_);
+        }
+        if (out_q) apply_ramp(out_q + written, start, len);
+        apply_ramp(out + written, start, len);
+
+        pos_ += len;
+        written += len;
+    }
+    return written;
+}
@@ -0,0 +1,105 @@
+// mfsk.h
+//
+// Table-driven synthesis of the JTEncode MFSK modes (JT65, JT9, JT4, WSPR,
+// FT8 and FSQ) at any sample rate.
+
+#ifndef MFSK_H
+#define MFSK_H
+
+#include <cstddef>
+#include <cstdint>
+#include "nco.h"
+
+enum MfskModeId {
+    MFSK_JT65, MFSK_JT9, MFSK_JT4, MFSK_WSPR, MFSK_WSPR_15, MFSK_FT8,
+    MFSK_FSQ_2, MFSK_FSQ_3, MFSK_FSQ_4_5, MFSK_FSQ_6
+};
+
+// How sync reaches the air. JTEncode's *_merge_sync_vector already places
+// the sync symbols in the stream, so merged sync is played like data.
+enum MfskSync {
+    SYNC_NONE,    // no sync symbols (FSQ)
+    SYNC_MERGED   // sync symbols interleaved in the symbol stream
+};
+
+// Mode descriptor
+struct MfskMode {
+    MfskModeId id;
+    const char* name;
+    int tone_count;         // highest symbol value + 1
+    double tone_spacing;    // Hz
+    double symbol_period;   // seconds
+    int symbol_count;       // fixed count, 0 for terminated streams
+    int terminator;         // end-of-stream symbol, -1 if none
+    MfskSync sync;
+    double default_base;    // audio frequency of tone 0 (Hz)
+};
+
+// Look up a mode by name (case-insensitive: "JT65", "FSQ4.5", ...), NULL if unknown
+const MfskMode* find_mfsk_mode(const char* name);
+
+// Comma separated list of the mode names, for usage text
+const char* mfsk_mode_names();
+
+// Largest symbol buffer any mode needs
+const int MFSK_MAX_SYMBOLS = 320;
+
+// Encode a message for a mode. WSPR takes "CALL GRID DBM", FSQ takes
+// "FROMCALL message", the others take the message text. Returns the
+// number of symbols (excluding any terminator), or -1 on bad input.
+int encode_mfsk_message(const MfskMode& mode, const char* text, uint8_t* symbols);
+
+// Number of symbols in a buffer: the fixed count, or up to the terminator
+int mfsk_symbol_count(const MfskMode& mode, const uint8_t* symbols, int max);
+
+// Samples between NCO retunes under drift: 1.3 ms at 48 kHz, where even
+// 100 Hz/min moves the frequency by 2 mHz
+const size_t MFSK_DRIFT_BLOCK = 64;
+
+// Streaming phase-continuous MFSK synthesizer. Symbol boundaries fall on
+// the nearest sample of k * symbol_period, so arbitrary rates keep the
+// correct total duration.
+class MfskSynth {
+public:
+    MfskSynth(const MfskMode& mode, const uint8_t* symbols, int count,
+              double sample_rate, double base_freq, float amplitude);
+
+    // Silence before the first and after the last symbol, and raised cosine ramp length
+    void set_delay(size_t samples) { delay_ = samples; }
+    void set_tail(size_t samples) { tail_ = samples; }
+    void set_ramp(size_t samples) { ramp_ = samples; }
+    // Frequency drift about the middle of the symbols: linear in Hz per
+    // minute plus quadratic in Hz per minute^2. The NCO is retuned every
+    // MFSK_DRIFT_BLOCK samples.
+    void set_drift(double per_min, double per_min2);
+
+    size_t total_samples() const;
+    // Render the next n samples; returns the number written, 0 when done
+    size_t render(float* out, size_t n);
+    // Complex baseband variant: I = cos, Q = sin of the same phase
+    size_t render_iq(float* out_i, float* out_q, size_t n);
+    void rewind();
+
+private:
+    size_t symbol_start(int k) const;
+    size_t render_impl(float* out, float* out_q, size_t n);
+    void apply_ramp(float* out, size_t start, size_t n) const;
+    double drift_offset(size_t pos) const;
+
+    const MfskMode& mode_;
+    const uint8_t* symbols_;
+    int count_;
+    double sample_rate_;
+    double base_freq_;
+    float amplitude_;
+    size_t delay_;
+    size_t tail_;
+    size_t ramp_;
+    double drift_;
+    double drift2_;
+    size_t pos_;
+    int sym_;
+    Nco nco_;
+};
+
+#endif
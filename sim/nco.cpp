@@ -0,0 +1,63 @@
+// nco.cpp
+//
+// Numerically controlled oscillator: a 32-bit phase accumulator driving a
+// shared sine table with linear interpolation.
+
+#include <cmath>
+#include <vector>
+#include "nco.h"
+
+const float* nco_sine_table() {
+    static const std::vector<float> table = [] {
+        const int size = 1 << NCO_TABLE_BITS;
+        std::vector<float> t(size + 1);
+        for (int i = 0; i <= size; i++) t[i] = sin(2.0 * M_PI * i / size);
+        return t;
+    }();
+    return table.data();
+}
+
+Nco::Nco(double sample_rate) : sample_rate_(sample_rate), phase_(0), step_(0) {
+    nco_sine_table();
+}
+
+uint32_t Nco::step_for(double hz) const {
+    double cycles = hz / sample_rate_;
+    cycles -= floor(cycles);
+    return (uint32_t)(uint64_t)llround(cycles * 4294967296.0);
+}
+
+void Nco::set_freq(double hz) {
+    step_ = step_for(hz);
+}
+
+void Nco::set_phase(double radians) {
+    double cycles = radians / (2.0 * M_PI);
+    cycles -= floor(cycles);
+    phase_ = (uint32_t)(uint64_t)llround(cycles * 4294967296.0);
+}
+
+double Nco::phase() const {
+    return 2.0 * M_PI * phase_ / 4294967296.0;
+}
+
+void Nco::generate(float* out, size_t n, float amplitude) {
+    const float* table = nco_sine_table();
+    uint32_t phase = phase_;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = amplitude * nco_lookup(table, phase);
+        phase += step_;
+    }
+    phase_ = phase;
+}
+
+void Nco::generate_iq(float* out_i, float* out_q, size_t n, float amplitude) {
+    const float* table = nco_sine_table();
+    uint32_t phase = phase_;
+    for (size_t i = 0; i < n; i++) {
+        out_i[i] = amplitude * nco_lookup(table, phase + 0x40000000u);
+        out_q[i] = amplitude * nco_lookup(table, phase);
+        phase += step_;
+    }
+    phase_ = phase;
+}
@@ -0,0 +1,53 @@
+// nco.h
+//
+// Numerically controlled oscillator: a 32-bit phase accumulator driving a
+// shared sine table with linear interpolation.
+
+#ifndef NCO_H
+#define NCO_H
+
+#include <cstddef>
+#include <cstdint>
+
+const int NCO_TABLE_BITS = 12;  // 4096-entry table, interpolation error < 5e-7
+const int NCO_FRAC_BITS = 32 - NCO_TABLE_BITS;
+
+// Shared sine table, 2^NCO_TABLE_BITS entries plus one guard entry
+const float* nco_sine_table();
+
+// Interpolated sin of a phase word (2^-32 cycles)
+inline float nco_lookup(const float* table, uint32_t phase) {
+    uint32_t idx = phase >> NCO_FRAC_BITS;
+    float frac = (phase & ((1u << NCO_FRAC_BITS) - 1)) * (1.0f / (1u << NCO_FRAC_BITS));
+    return table[idx] + frac * (table[idx + 1] - table[idx]);
+}
+
+class Nco {
+public:
+    explicit Nco(double sample_rate);
+
+    // Tuning: the phase step is rounded to the nearest 2^-32 cycle
+    void set_freq(double hz);
+    void set_phase(double radians);
+    double phase() const;
+
+    uint32_t step() const { return step_; }
+    void set_step(uint32_t step) { step_ = step; }
+    uint32_t phase_word() const { return phase_; }
+    void set_phase_word(uint32_t phase) { phase_ = phase; }
+
+    // Phase step for a frequency at this sample rate
+    uint32_t step_for(double hz) const;
+
+    // amplitude * sin(phase) for n samples, advancing the phase
+    void generate(float* out, size_t n, float amplitude);
+    // Complex output: out_i = cos, out_q = sin
+    void generate_iq(float* out_i, float* out_q, size_t n, float amplitude);
+
+private:
+    double sample_rate_;
+    uint32_t phase_;
+    uint32_t step_;
+};
+
+#endif
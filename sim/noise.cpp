@@ -0,0 +1,475 @@
+// noise.cpp
+//
+// Counter-based Gaussian noise and QRM.
+//
+// Each block of 64 Box-Muller pairs takes 128 32-bit hashes of a counter:
+// the first 64 give the radius uniforms, the second 64 the angles. The
+// angle needs only an octant: phi is uniform in [-pi/4, pi/4), and three
+// more hash bits swap cos/sin and flip their signs, which spreads phi
+// uniformly over the circle without any range reduction.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "nco.h"
+#include "noise.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+double awgn_sigma(double amplitude, double snr_db, double sample_rate) {
+    // Signal power A^2/2 against noise power sigma^2 spread over fs/2,
+    // of which 2500 Hz falls in the reference bandwidth
+    double signal_power = amplitude * amplitude / 2.0;
+    double noise_power = signal_power / std::pow(10.0, snr_db / 10.0);
+    return std::sqrt(noise_power * (sample_rate / 2.0) / WSPR_SNR_BANDWIDTH);
+}
+
+double snr_amplitude(double sigma, double snr_db, double sample_rate) {
+    return sigma / awgn_sigma(1.0, snr_db, sample_rate);
+}
+
+double awgn_sigma_iq(double amplitude, double snr_db, double sample_rate) {
+    // Power A^2 against 2 sigma^2 spread over fs
+    return awgn_sigma(amplitude * std::sqrt(2.0), snr_db, sample_rate);
+}
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Hash keys for the epoch of 2^32 counters containing a block
+static void block_keys(uint64_t seed, uint64_t stream, uint64_t block, uint32_t& k0, uint32_t& k1) {
+    uint64_t key = splitmix64(seed ^ splitmix64(stream ^ splitmix64(block >> 25)));
+    k0 = (uint32_t)key;
+    k1 = (uint32_t)(key >> 32);
+}
+
+const uint32_t HASH_M1 = 0x7feb352d;
+const uint32_t HASH_M2 = 0x846ca68b;
+const int PAIRS = NOISE_BLOCK / 2;
+
+// Polynomial constants (Cephes logf, sinf, cosf)
+const float SQRTHF = 0.707106781186547524f;
+const float LOG_P[9] = {7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f,
+                        -1.2420140846E-1f, 1.4249322787E-1f, -1.6668057665E-1f,
+                        2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f};
+const float LOG_Q1 = -2.12194440e-4f;
+const float LOG_Q2 = 0.693359375f;
+const float SIN_P[3] = {-1.9515295891E-4f, 8.3321608736E-3f, -1.6666654611E-1f};
+const float COS_P[3] = {2.443315711809948E-5f, -1.388731625493765E-3f, 4.166664568298827E-2f};
+const float QUARTER_PI = 0.785398163397448f;
+
+#if !defined(__SSE2__)
+static inline uint32_t hash32(uint32_t x, uint32_t k0, uint32_t k1) {
+    // Two rounds of the lowbias32 integer hash
+    x += k0;
+    x ^= x >> 16; x *= HASH_M1; x ^= x >> 15; x *= HASH_M2; x ^= x >> 16;
+    x ^= k1;
+    x ^= x >> 16; x *= HASH_M1; x ^= x >> 15; x *= HASH_M2; x ^= x >> 16;
+    return x;
+}
+
+static inline float bits_float(uint32_t b) { float f; memcpy(&f, &b, 4); return f; }
+static inline uint32_t float_bits(float f) { uint32_t b; memcpy(&b, &f, 4); return b; }
+
+static void gaussian_pairs_scalar(uint32_t base, uint32_t k0, uint32_t k1, float sigma, float* out, bool add) {
+    for (int p = 0; p < PAIRS; p++) {
+        uint32_t h1 = hash32(base + p, k0, k1);
+        uint32_t h2 = hash32(base + PAIRS + p, k0, k1);
+
+        // ln(u), u in (0, 1)
+        float u = ((float)(h1 >> 8) + 0.5f) * (1.0f / 16777216.0f);
+        uint32_t bits = float_bits(u);
+        int e = (int)((bits >> 23) & 0xff) - 126;
+        float m = bits_float((bits & 0x807fffff) | 0x3f000000);
+        if (m < SQRTHF) { e -= 1; m = m + m; }
+        float x = m - 1.0f;
+        float z = x * x;
+        float z2 = z * z;
+        float y = (LOG_P[7] * x + LOG_P[8]) + z * (LOG_P[5] * x + LOG_P[6])
+                + z2 * (((LOG_P[3] * x + LOG_P[4]) + z * (LOG_P[1] * x + LOG_P[2])) + z2 * LOG_P[0]);
+        float fe = (float)e;
+        y = y * x * z + LOG_Q1 * fe - 0.5f * z;
+        float ln = x + y + LOG_Q2 * fe;
+        float r = sigma * std::sqrt(-2.0f * ln);
+
+        // sin and cos of phi in [-pi/4, pi/4)
+        float phi = ((float)(h2 >> 8) * (1.0f / 16777216.0f) - 0.5f) * (2.0f * QUARTER_PI);
+        float pz = phi * phi;
+        float s = ((SIN_P[0] * pz + SIN_P[1]) * pz + SIN_P[2]) * pz * phi + phi;
+        float c = ((COS_P[0] * pz + COS_P[1]) * pz + COS_P[2]) * pz * pz - 0.5f * pz + 1.0f;
+        if (h2 & 1) std::swap(c, s);
+        float z0 = bits_float(float_bits(r * c) ^ ((h2 & 2) << 30));
+        float z1 = bits_float(float_bits(r * s) ^ ((h2 & 4) << 29));
+        out[p] = add ? out[p] + z0 : z0;
+        out[PAIRS + p] = add ? out[PAIRS + p] + z1 : z1;
+    }
+}
+#else
+static inline __m128i mullo32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i lowbias4(__m128i x) {
+    const __m128i m1 = _mm_set1_epi32((int)HASH_M1);
+    const __m128i m2 = _mm_set1_epi32((int)HASH_M2);
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = mullo32(x, m1);
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = mullo32(x, m2);
+    return _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+}
+
+static inline __m128i hash4(__m128i x, __m128i k0, __m128i k1) {
+    return lowbias4(_mm_xor_si128(lowbias4(_mm_add_epi32(x, k0)), k1));
+}
+
+static void gaussian_pairs_sse2(uint32_t base, uint32_t k0, uint32_t k1, float sigma, float* out, bool add) {
+    const __m128i vk0 = _mm_set1_epi32((int)k0);
+    const __m128i vk1 = _mm_set1_epi32((int)k1);
+    const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 onef = _mm_set1_ps(1.0f);
+    const __m128 vsigma = _mm_set1_ps(sigma);
+
+    // Hash the whole block first: independent iterations that overlap
+    // well, where interleaving them with the long polynomial dependency
+    // chains below stalls on latency
+    __m128i hashes[NOISE_BLOCK / 4];
+    for (int i = 0; i < (int)NOISE_BLOCK / 4; i++) {
+        hashes[i] = hash4(_mm_add_epi32(_mm_set1_epi32((int)(base + 4 * i)), lanes), vk0, vk1);
+    }
+
+    for (int p = 0; p < PAIRS; p += 4) {
+        __m128i h1 = hashes[p / 4];
+        __m128i h2 = hashes[(PAIRS + p) / 4];
+
+        // ln(u)
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h1, 8)), half), scale);
+        __m128i bits = _mm_castps_si128(u);
+        __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)),
+                                  _mm_set1_epi32(126));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32((int)0x807fffff)),
+                                                 _mm_set1_epi32(0x3f000000)));
+        __m128 small = _mm_cmplt_ps(m, _mm_set1_ps(SQRTHF));
+        e = _mm_add_epi32(e, _mm_castps_si128(small));
+        m = _mm_add_ps(m, _mm_and_ps(small, m));
+        __m128 x = _mm_sub_ps(m, onef);
+        __m128 z = _mm_mul_ps(x, x);
+        // Estrin's scheme: shorter dependency chain than Horner
+        __m128 z2 = _mm_mul_ps(z, z);
+        __m128 pa = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG_P[7]), x), _mm_set1_ps(LOG_P[8]));
+        __m128 pb = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG_P[5]), x), _mm_set1_ps(LOG_P[6]));
+        __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG_P[3]), x), _mm_set1_ps(LOG_P[4]));
+        __m128 pd = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG_P[1]), x), _mm_set1_ps(LOG_P[2]));
+        __m128 y = _mm_add_ps(_mm_add_ps(pa, _mm_mul_ps(z, pb)),
+                  _mm_mul_ps(z2, _mm_add_ps(_mm_add_ps(pc, _mm_mul_ps(z, pd)),
+                                        _mm_mul_ps(z2, _mm_set1_ps(LOG_P[0])))));
+        __m128 fe = _mm_cvtepi32_ps(e);
+        y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, x), z), _mm_mul_ps(_mm_set1_ps(LOG_Q1), fe));
+        y = _mm_sub_ps(y, _mm_mul_ps(half, z));
+        __m128 ln = _mm_add_ps(_mm_add_ps(x, y), _mm_mul_ps(_mm_set1_ps(LOG_Q2), fe));
+        __m128 r = _mm_mul_ps(vsigma, _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(-2.0f), ln)));
+
+        // sin and cos of phi
+        __m128 phi = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h2, 8)), scale), half),
+                                _mm_set1_ps(2.0f * QUARTER_PI));
+        __m128 pz = _mm_mul_ps(phi, phi);
+        __m128 s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(
+                       _mm_mul_ps(_mm_set1_ps(SIN_P[0]), pz), _mm_set1_ps(SIN_P[1])), pz),
+                       _mm_set1_ps(SIN_P[2])), pz), phi), phi);
+        __m128 c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(
+                       _mm_mul_ps(_mm_set1_ps(COS_P[0]), pz), _mm_set1_ps(COS_P[1])), pz),
+                       _mm_set1_ps(COS_P[2])), pz), pz), _mm_mul_ps(half, pz)), onef);
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h2, one), one));
+        __m128 cs = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+        __m128 ss = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+        __m128 sign_c = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h2, _mm_set1_epi32(2)), 30));
+        __m128 sign_s = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h2, _mm_set1_epi32(4)), 29));
+        __m128 z0 = _mm_xor_ps(_mm_mul_ps(r, cs), sign_c);
+        __m128 z1 = _mm_xor_ps(_mm_mul_ps(r, ss), sign_s);
+        if (add) {
+            z0 = _mm_add_ps(z0, _mm_loadu_ps(out + p));
+            z1 = _mm_add_ps(z1, _mm_loadu_ps(out + PAIRS + p));
+        }
+        _mm_storeu_ps(out + p, z0);
+        _mm_storeu_ps(out + PAIRS + p, z1);
+    }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NOISE_HAVE_AVX2 1
+// The same kernel eight lanes wide, selected at run time. No FMA, so the
+// results match the SSE2 and scalar paths exactly.
+__attribute__((target("avx2"))) static inline __m256i lowbias8(__m256i x) {
+    const __m256i m1 = _mm256_set1_epi32((int)HASH_M1);
+    const __m256i m2 = _mm256_set1_epi32((int)HASH_M2);
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, m1);
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, m2);
+    return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+__attribute__((target("avx2"))) static inline __m256i hash8(__m256i x, __m256i k0, __m256i k1) {
+    return lowbias8(_mm256_xor_si256(lowbias8(_mm256_add_epi32(x, k0)), k1));
+}
+
+__attribute__((target("avx2"))) static void gaussian_pairs_avx2(uint32_t base, uint32_t k0, uint32_t k1, float sigma, float* out, bool add) {
+    const __m256i vk0 = _mm256_set1_epi32((int)k0);
+    const __m256i vk1 = _mm256_set1_epi32((int)k1);
+    const __m256i lanes = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 onef = _mm256_set1_ps(1.0f);
+    const __m256 vsigma = _mm256_set1_ps(sigma);
+
+    __m256i hashes[NOISE_BLOCK / 8];
+    for (int i = 0; i < (int)NOISE_BLOCK / 8; i++) {
+        hashes[i] = hash8(_mm256_add_epi32(_mm256_set1_epi32((int)(base + 8 * i)), lanes), vk0, vk1);
+    }
+
+#pragma GCC unroll 2
+    for (int p = 0; p < PAIRS; p += 8) {
+        __m256i h1 = hashes[p / 8];
+        __m256i h2 = hashes[(PAIRS + p) / 8];
+
+        // ln(u)
+        __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h1, 8)), half), scale);
+        __m256i bits = _mm256_castps_si256(u);
+        __m256i e = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)),
+                                  _mm256_set1_epi32(126));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32((int)0x807fffff)),
+                                                 _mm256_set1_epi32(0x3f000000)));
+        __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRTHF), _CMP_LT_OQ);
+        e = _mm256_add_epi32(e, _mm256_castps_si256(small));
+        m = _mm256_add_ps(m, _mm256_and_ps(small, m));
+        __m256 x = _mm256_sub_ps(m, onef);
+        __m256 z = _mm256_mul_ps(x, x);
+        __m256 z2 = _mm256_mul_ps(z, z);
+        __m256 pa = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(LOG_P[7]), x), _mm256_set1_ps(LOG_P[8]));
+        __m256 pb = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(LOG_P[5]), x), _mm256_set1_ps(LOG_P[6]));
+        __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(LOG_P[3]), x), _mm256_set1_ps(LOG_P[4]));
+        __m256 pd = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(LOG_P[1]), x), _mm256_set1_ps(LOG_P[2]));
+        __m256 y = _mm256_add_ps(_mm256_add_ps(pa, _mm256_mul_ps(z, pb)),
+                  _mm256_mul_ps(z2, _mm256_add_ps(_mm256_add_ps(pc, _mm256_mul_ps(z, pd)),
+                                        _mm256_mul_ps(z2, _mm256_set1_ps(LOG_P[0])))));
+        __m256 fe = _mm256_cvtepi32_ps(e);
+        y = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, x), z), _mm256_mul_ps(_mm256_set1_ps(LOG_Q1), fe));
+        y = _mm256_sub_ps(y, _mm256_mul_ps(half, z));
+        __m256 ln = _mm256_add_ps(_mm256_add_ps(x, y), _mm256_mul_ps(_mm256_set1_ps(LOG_Q2), fe));
+        __m256 r = _mm256_mul_ps(vsigma, _mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), ln)));
+
+        // sin and cos of phi
+        __m256 phi = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h2, 8)), scale), half),
+                                _mm256_set1_ps(2.0f * QUARTER_PI));
+        __m256 pz = _mm256_mul_ps(phi, phi);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(
+                       _mm256_mul_ps(_mm256_set1_ps(SIN_P[0]), pz), _mm256_set1_ps(SIN_P[1])), pz),
+                       _mm256_set1_ps(SIN_P[2])), pz), phi), phi);
+        __m256 c = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(
+                       _mm256_mul_ps(_mm256_set1_ps(COS_P[0]), pz), _mm256_set1_ps(COS_P[1])), pz),
+                       _mm256_set1_ps(COS_P[2])), pz), pz), _mm256_mul_ps(half, pz)), onef);
+
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(h2, one), one));
+        __m256 cs = _mm256_or_ps(_mm256_and_ps(swap, s), _mm256_andnot_ps(swap, c));
+        __m256 ss = _mm256_or_ps(_mm256_and_ps(swap, c), _mm256_andnot_ps(swap, s));
+        __m256 sign_c = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h2, _mm256_set1_epi32(2)), 30));
+        __m256 sign_s = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h2, _mm256_set1_epi32(4)), 29));
+        __m256 z0 = _mm256_xor_ps(_mm256_mul_ps(r, cs), sign_c);
+        __m256 z1 = _mm256_xor_ps(_mm256_mul_ps(r, ss), sign_s);
+        if (add) {
+            z0 = _mm256_add_ps(z0, _mm256_loadu_ps(out + p));
+            z1 = _mm256_add_ps(z1, _mm256_loadu_ps(out + PAIRS + p));
+        }
+        _mm256_storeu_ps(out + p, z0);
+        _mm256_storeu_ps(out + PAIRS + p, z1);
+    }
+}
+#endif
+
+#endif
+
+typedef void (*GaussianKernel)(uint32_t, uint32_t, uint32_t, float, float*, bool);
+
+static GaussianKernel select_kernel() {
+#if defined(NOISE_HAVE_AVX2)
+    if (__builtin_cpu_supports("avx2")) return gaussian_pairs_avx2;
+#endif
+#if defined(__SSE2__)
+    return gaussian_pairs_sse2;
+#else
+    return gaussian_pairs_scalar;
+#endif
+}
+
+static const GaussianKernel gaussian_kernel = select_kernel();
+
+void gaussian_block(uint64_t seed, uint64_t stream, uint64_t block, float sigma, float* out) {
+    uint32_t k0, k1;
+    block_keys(seed, stream, block, k0, k1);
+    gaussian_kernel((uint32_t)(block << 7), k0, k1, sigma, out, false);
+}
+
+// Samples [index, index + n) of a stream, written or added to out
+static void gaussian_range(uint64_t seed, uint64_t stream, uint64_t index,
+                           float* out, size_t n, float sigma, bool add) {
+    float tmp[NOISE_BLOCK];
+    uint64_t epoch = ~0ull;
+    uint32_t k0 = 0, k1 = 0;
+    while (n > 0) {
+        uint64_t block = index / NOISE_BLOCK;
+        if (block >> 25 != epoch) {
+            epoch = block >> 25;
+            block_keys(seed, stream, block, k0, k1);
+        }
+        uint32_t base = (uint32_t)(block << 7);   // 128 counters per block
+        size_t off = (size_t)(index % NOISE_BLOCK);
+        size_t len = std::min(n, NOISE_BLOCK - off);
+        if (len == NOISE_BLOCK) {
+            gaussian_kernel(base, k0, k1, sigma, out, add);
+        } else {
+            gaussian_kernel(base, k0, k1, sigma, tmp, false);
+            if (add) {
+                for (size_t i = 0; i < len; i++) out[i] += tmp[off + i];
+            } else {
+                memcpy(out, tmp + off, len * sizeof(float));
+            }
+        }
+        index += len;
+        out += len;
+        n -= len;
+    }
+}
+
+GaussianNoise::GaussianNoise(uint64_t seed, uint64_t stream)
+    : seed_(seed), stream_(stream), pos_(0) {}
+
+void GaussianNoise::add(float* out, size_t n, float sigma) {
+    add_at(pos_, out, n, sigma);
+    pos_ += n;
+}
+
+void GaussianNoise::fill(float* out, size_t n, float sigma) {
+    fill_at(pos_, out, n, sigma);
+    pos_ += n;
+}
+
+void GaussianNoise::fill_at(uint64_t index, float* out, size_t n, float sigma) const {
+    gaussian_range(seed_, stream_, index, out, n, sigma, false);
+}
+
+void GaussianNoise::add_at(uint64_t index, float* out, size_t n, float sigma) const {
+    gaussian_range(seed_, stream_, index, out, n, sigma, true);
+}
+
+// Stream numbers within a seed
+const uint64_t STREAM_NOISE_I = 0;
+const uint64_t STREAM_NOISE_Q = 1;
+const uint64_t STREAM_IMPULSE_I = 2;
+const uint64_t STREAM_IMPULSE_Q = 3;
+const uint64_t STREAM_QRM = 4;
+
+// Impulse arrivals are decided per 10 ms cell
+const double IMPULSE_CELL = 0.01;
+
+NoiseStage::NoiseStage(double sample_rate, double sigma, uint64_t seed)
+    : sample_rate_(sample_rate), sigma_((float)sigma), seed_(seed), center_(0.0),
+      impulse_rate_(0.0), impulse_peak_(0.0), impulse_decay_(0.0) {}
+
+void NoiseStage::add_carrier(double freq, double snr_db) {
+    Carrier c;
+    c.freq = freq;
+    c.amplitude = snr_amplitude(sigma_, snr_db, sample_rate_);
+    uint64_t h = splitmix64(seed_ ^ splitmix64(STREAM_QRM + carriers_.size()));
+    c.phase = 2.0 * M_PI * (h >> 11) * (1.0 / 9007199254740992.0);
+    carriers_.push_back(c);
+}
+
+void NoiseStage::set_impulses(double rate, double peak, double decay) {
+    impulse_rate_ = rate;
+    impulse_peak_ = peak;
+    impulse_decay_ = decay;
+}
+
+void NoiseStage::add_carriers(float* out_i, float* out_q, uint64_t start, size_t n) const {
+    const float* table = nco_sine_table();
+    const uint32_t quarter = 1u << 30;
+    Nco nco(sample_rate_);
+    for (size_t c = 0; c < carriers_.size(); c++) {
+        const Carrier& car = carriers_[c];
+        uint32_t step = nco.step_for(out_q ? car.freq - center_ : car.freq);
+        nco.set_phase(car.phase);
+        // Phase words wrap mod 2^32, so the phase at start is exact
+        uint32_t phase = nco.phase_word() + step * (uint32_t)start;
+        if (out_q) {
+            float a = (float)(car.amplitude / std::sqrt(2.0));
+            for (size_t i = 0; i < n; i++, phase += step) {
+                out_i[i] += a * nco_lookup(table, phase + quarter);
+                out_q[i] += a * nco_lookup(table, phase);
+            }
+        } else {
+            float a = (float)car.amplitude;
+            for (size_t i = 0; i < n; i++, phase += step) {
+                out_i[i] += a * nco_lookup(table, phase);
+            }
+        }
+    }
+}
+
+void NoiseStage::add_impulses(float* out, uint64_t stream, uint64_t start, size_t n) const {
+    uint64_t cell = (uint64_t)llround(IMPULSE_CELL * sample_rate_);
+    if (cell == 0) cell = 1;
+    double p = std::min(1.0, impulse_rate_ * IMPULSE_CELL);
+    double decay = impulse_decay_ * sample_rate_;   // samples
+    uint64_t tail = (uint64_t)std::ceil(8.0 * decay) + 1;
+    GaussianNoise burst(seed_, stream);
+    std::vector<float> g;
+
+    uint64_t first = start > tail ? (start - tail) / cell : 0;
+    uint64_t last = (start + n - 1) / cell;
+    for (uint64_t k = first; k <= last; k++) {
+        uint64_t h = splitmix64(seed_ ^ splitmix64(STREAM_IMPULSE_I ^ splitmix64(k)));
+        if ((h >> 11) * (1.0 / 9007199254740992.0) >= p) continue;
+        uint64_t at = k * cell + (uint32_t)h % cell;
+        uint64_t a = std::max(at, start);
+        uint64_t b = std::min(at + tail, (uint64_t)(start + n));
+        if (a >= b) continue;
+
+        g.resize(b - a);
+        burst.fill_at(a, g.data(), g.size(), (float)(impulse_peak_ * sigma_));
+        for (uint64_t i = a; i < b; i++) {
+            out[i - start] += g[i - a] * (float)std::exp(-(double)(i - at) / decay);
+        }
+    }
+}
+
+void NoiseStage::apply(float* out, uint64_t start, size_t n) const {
+    if (sigma_ > 0.0f) GaussianNoise(seed_, STREAM_NOISE_I).add_at(start, out, n, sigma_);
+    if (!carriers_.empty()) add_carriers(out, NULL, start, n);
+    if (impulse_rate_ > 0.0 && impulse_decay_ > 0.0) add_impulses(out, STREAM_IMPULSE_I, start, n);
+}
+
+void NoiseStage::apply_iq(float* out_i, float* out_q, uint64_t start, size_t n) const {
+    if (sigma_ > 0.0f) {
+        GaussianNoise(seed_, STREAM_NOISE_I).add_at(start, out_i, n, sigma_);
+        GaussianNoise(seed_, STREAM_NOISE_Q).add_at(start, out_q, n, sigma_);
+    }
+    if (!carriers_.empty()) add_carriers(out_i, out_q, start, n);
+    if (impulse_rate_ > 0.0 && impulse_decay_ > 0.0) {
+        add_impulses(out_i, STREAM_IMPULSE_I, start, n);
+        add_impulses(out_q, STREAM_IMPULSE_Q, start, n);
+    }
+}
@@ -0,0 +1,105 @@
+// noise.h
+//
+// Additive white Gaussian noise calibrated to WSPR SNR, which is measured
+// in a 2500 Hz reference bandwidth, and simple QRM (steady carriers and
+// static-crash impulse bursts).
+//
+// Noise comes from a counter-based generator: sample i of a stream is a
+// pure function of (seed, stream, i). Any block of a recording can be
+// generated on its own, so splitting the work between threads or chunks
+// never changes the output. The radius uniforms have 24 bits, which
+// bounds the tails at about 5.9 sigma.
+
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const double WSPR_SNR_BANDWIDTH = 2500.0;  // Hz
+
+// Noise level for 16-bit audio output: the 5.9 sigma tails plus a crowd
+// of signals stay clear of clipping
+const double AUDIO_NOISE_SIGMA = 0.05;
+
+// Per-sample noise standard deviation that puts a sinusoid of the given
+// amplitude at snr_db in 2500 Hz, for real samples at sample_rate
+double awgn_sigma(double amplitude, double snr_db, double sample_rate);
+
+// Sinusoid amplitude with snr_db in 2500 Hz against noise of this sigma
+double snr_amplitude(double sigma, double snr_db, double sample_rate);
+
+// The same as awgn_sigma for complex baseband: a complex exponential of the given
+// amplitude against noise of this sigma in each of I and Q
+double awgn_sigma_iq(double amplitude, double snr_db, double sample_rate);
+
+// Samples per generator block (64 Box-Muller pairs)
+const size_t NOISE_BLOCK = 128;
+
+// Unit Gaussian samples [block * NOISE_BLOCK, (block + 1) * NOISE_BLOCK)
+// of a stream, scaled by sigma. SSE2 on x86, scalar elsewhere, with the
+// same results.
+void gaussian_block(uint64_t seed, uint64_t stream, uint64_t block, float sigma, float* out);
+
+// Seeded Gaussian noise source
+class GaussianNoise {
+public:
+    explicit GaussianNoise(uint64_t seed, uint64_t stream = 0);
+
+    // Sequential use: continue from the current position
+    void add(float* out, size_t n, float sigma);
+    void fill(float* out, size_t n, float sigma);
+    uint64_t position() const { return pos_; }
+    void seek(uint64_t sample) { pos_ = sample; }
+
+    // Random access to samples [index, index + n) of the stream
+    void add_at(uint64_t index, float* out, size_t n, float sigma) const;
+    void fill_at(uint64_t index, float* out, size_t n, float sigma) const;
+
+private:
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t pos_;
+};
+
+// AWGN plus optional QRM, addressed by absolute sample position
+class NoiseStage {
+public:
+    NoiseStage(double sample_rate, double sigma, uint64_t seed);
+
+    // Steady carrier at freq Hz, with its power given as SNR in 2500 Hz
+    void add_carrier(double freq, double snr_db);
+    // Static crashes: on average rate bursts per second of Gaussian noise
+    // peaking at peak * sigma and decaying with time constant decay seconds
+    void set_impulses(double rate, double peak, double decay);
+    // Audio frequency at 0 Hz of complex baseband (for apply_iq carriers)
+    void set_center(double hz) { center_ = hz; }
+
+    float sigma() const { return sigma_; }
+
+    // Add noise and QRM to samples [start, start + n) of a recording
+    void apply(float* out, uint64_t start, size_t n) const;
+    void apply_iq(float* out_i, float* out_q, uint64_t start, size_t n) const;
+
+private:
+    struct Carrier {
+        double freq;
+        double amplitude;
+        double phase;
+    };
+
+    void add_carriers(float* out_i, float* out_q, uint64_t start, size_t n) const;
+    void add_impulses(float* out, uint64_t stream, uint64_t start, size_t n) const;
+
+    double sample_rate_;
+    float sigma_;
+    uint64_t seed_;
+    double center_;
+    std::vector<Carrier> carriers_;
+    double impulse_rate_;
+    double impulse_peak_;
+    double impulse_decay_;
+};
+
+#endif
@@ -0,0 +1,28 @@
+// parallel.cpp
+//
+// Minimal work sharing over std::thread.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+
+int default_thread_count() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 1;
+}
+
+void parallel_for(size_t count, int threads, const std::function<void(size_t)>& task) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < count) task(i);
+    };
+
+    if (threads < 1) threads = 1;
+    if ((size_t)threads > count) threads = count > 0 ? (int)count : 1;
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++) pool.push_back(std::thread(worker));
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
@@ -0,0 +1,19 @@
+// parallel.h
+//
+// Minimal work sharing: run tasks 0..count-1 on a number of threads,
+// handing out task indices from a shared counter.
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+// Number of hardware threads, at least 1
+int default_thread_count();
+
+// Call task(i) for every i in [0, count) using up to threads threads
+// (the calling thread included). Returns when all tasks are done.
+void parallel_for(size_t count, int threads, const std::function<void(size_t)>& task);
+
+#endif
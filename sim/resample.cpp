@@ -0,0 +1,247 @@
+// resample.cpp
+//
+// Polyphase FIR sample rate conversion by a rational ratio.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+#include "resample.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Band edges as fractions of the lower rate, and the Kaiser design target
+static const double PASS_EDGE = 0.4;
+static const double STOP_EDGE = 0.5;
+static const double STOP_DB = 100.0;
+// Largest L the phase table is built for
+static const int MAX_PHASES = 4096;
+static const int LANES = 8;
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+bool resample_ratio(int in_rate, int out_rate, int& up, int& down) {
+    if (in_rate <= 0 || out_rate <= 0) {
+        std::fprintf(stderr, "Error: Invalid resampling rates %d -> %d\n", in_rate, out_rate);
+        return false;
+    }
+    int g = gcd(in_rate, out_rate);
+    up = out_rate / g;
+    down = in_rate / g;
+    if (up > MAX_PHASES) {
+        std::fprintf(stderr, "Error: Resampling ratio %d/%d needs more than %d filter phases\n",
+                     up, down, MAX_PHASES);
+        return false;
+    }
+    return true;
+}
+
+// Zeroth order modified Bessel function of the first kind
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0, q = x * x / 4.0;
+    for (int k = 1; k < 64 && term > 1e-12 * sum; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static std::shared_ptr<const ResampleFilter> design_filter(int up, int down) {
+    std::shared_ptr<ResampleFilter> f = std::make_shared<ResampleFilter>();
+    f->up = up;
+    f->down = down;
+
+    // Kaiser's estimates for the window shape and the length needed for
+    // the transition band, in prototype samples (rate up * in_rate)
+    int wide = up > down ? up : down;
+    double beta = 0.1102 * (STOP_DB - 8.7);
+    double transition = 2.0 * M_PI * (STOP_EDGE - PASS_EDGE) / wide;
+    int half = (int)std::ceil((STOP_DB - 7.95) / (2.285 * transition) / 2.0);
+    // A multiple of down, so the delay is a whole number of outputs
+    half = (half + down - 1) / down * down;
+    f->delay = half / down;
+
+    int length = 2 * half + 1;
+    std::vector<double> h(length);
+    double fc = (PASS_EDGE + STOP_EDGE) / 2.0 / wide;
+    double sum = 0.0, i0_beta = bessel_i0(beta);
+    for (int k = 0; k < length; k++) {
+        double t = k - half;
+        double x = 2.0 * fc * t;
+        double sinc = t == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        double r = t / half;
+        h[k] = 2.0 * fc * sinc * bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        sum += h[k];
+    }
+
+    // Phase p holds h[p + k * up]; unit gain once every phase has its turn
+    int taps = (length + up - 1) / up;
+    f->taps = (taps + 2 * LANES - 1) / (2 * LANES) * (2 * LANES);
+    f->bank.assign((size_t)up * f->taps, 0.0f);
+    for (int p = 0; p < up; p++) {
+        float* row = &f->bank[(size_t)p * f->taps];
+        for (int k = 0; p + k * up < length; k++) {
+            row[f->taps - 1 - k] = (float)(h[p + k * up] * up / sum);
+        }
+    }
+    return f;
+}
+
+std::shared_ptr<const ResampleFilter> resample_filter(int up, int down) {
+    static std::mutex lock;
+    static std::map<std::pair<int, int>, std::shared_ptr<const ResampleFilter> > cache;
+    std::lock_guard<std::mutex> guard(lock);
+    std::shared_ptr<const ResampleFilter>& f = cache[std::make_pair(up, down)];
+    if (!f) f = design_filter(up, down);
+    return f;
+}
+
+// Dot products of n (a multiple of 16) taps. Sixteen partial sums, so
+// the adds of one output don't wait on each other, folded the same way
+// in every kernel: lane l of the sum is (l) + (l + 8), then
+// ((0+4)+(2+6)) + ((1+5)+(3+7)).
+
+#if !defined(__SSE2__)
+static float dot_scalar(const float* a, const float* b, int n) {
+    float acc[2 * LANES] = {0.0f};
+    for (int k = 0; k < n; k += 2 * LANES) {
+        for (int l = 0; l < 2 * LANES; l++) acc[l] += a[k + l] * b[k + l];
+    }
+    float s[LANES];
+    for (int l = 0; l < LANES; l++) s[l] = acc[l] + acc[l + LANES];
+    return ((s[0] + s[4]) + (s[2] + s[6])) + ((s[1] + s[5]) + (s[3] + s[7]));
+}
+#else
+static inline float fold4(__m128 s) {
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+static float dot_sse2(const float* a, const float* b, int n) {
+    __m128 acc[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+    for (int k = 0; k < n; k += 2 * LANES) {
+        for (int j = 0; j < 4; j++) {
+            acc[j] = _mm_add_ps(acc[j], _mm_mul_ps(_mm_loadu_ps(a + k + 4 * j), _mm_loadu_ps(b + k + 4 * j)));
+        }
+    }
+    return fold4(_mm_add_ps(_mm_add_ps(acc[0], acc[2]), _mm_add_ps(acc[1], acc[3])));
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESAMPLE_HAVE_AVX 1
+// No FMA, so the sums round exactly like the SSE2 and scalar kernels
+__attribute__((target("avx"))) static float dot_avx(const float* a, const float* b, int n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    for (int k = 0; k < n; k += 2 * LANES) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + k), _mm256_loadu_ps(b + k)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + k + 8), _mm256_loadu_ps(b + k + 8)));
+    }
+    __m256 s = _mm256_add_ps(acc0, acc1);
+    return fold4(_mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)));
+}
+#endif
+#endif
+
+typedef float (*DotKernel)(const float*, const float*, int);
+
+static DotKernel select_kernel() {
+#if defined(RESAMPLE_HAVE_AVX)
+    if (__builtin_cpu_supports("avx")) return dot_avx;
+#endif
+#if defined(__SSE2__)
+    return dot_sse2;
+#else
+    return dot_scalar;
+#endif
+}
+
+static const DotKernel dot_kernel = select_kernel();
+
+Resampler::Resampler(int up, int down) : filter_(resample_filter(up, down)) {
+    reset();
+}
+
+void Resampler::reset() {
+    // Zeros before the first input, so the first output has full history
+    int taps = filter_->taps;
+    history_.assign(taps - 1, 0.0f);
+    base_ = -(taps - 1);
+    index_ = 0;
+    phase_ = 0;
+    inputs_ = 0;
+}
+
+size_t Resampler::process(const float* in, size_t n, std::vector<float>& out) {
+    history_.insert(history_.end(), in, in + n);
+    inputs_ += n;
+
+    // Output y uses phase p = yM mod L against inputs up to i = yM / L:
+    // sum over k of h[p + kL] x[i - k]
+    const int taps = filter_->taps, up = filter_->up, down = filter_->down;
+    const float* bank = filter_->bank.data();
+    const int64_t end = base_ + (int64_t)history_.size();
+    // Outputs whose position yM is before end * L
+    int64_t pos = index_ * up + phase_;
+    size_t count = end * up > pos ? (size_t)((end * up - pos + down - 1) / down) : 0;
+    size_t first = out.size();
+    out.resize(first + count);
+    float* y = out.data() + first;
+    for (size_t c = 0; c < count; c++) {
+        const float* x = &history_[(size_t)(index_ - taps + 1 - base_)];
+        y[c] = dot_kernel(bank + (size_t)phase_ * taps, x, taps);
+        phase_ += down;
+        index_ += phase_ / up;
+        phase_ %= up;
+    }
+
+    // Keep only what the next output reaches back to
+    int64_t drop = index_ - taps + 1 - base_;
+    if (drop > 0) {
+        if (drop > (int64_t)history_.size()) drop = (int64_t)history_.size();
+        history_.erase(history_.begin(), history_.begin() + (size_t)drop);
+        base_ += drop;
+    }
+    return count;
+}
+
+size_t Resampler::flush(std::vector<float>& out) {
+    // Enough zeros for delay + 1 outputs past the last real input; they
+    // don't count as input
+    uint64_t zeros = ((uint64_t)(filter_->delay + 1) * filter_->down + filter_->up - 1) / filter_->up + 1;
+    std::vector<float> pad((size_t)zeros, 0.0f);
+    uint64_t inputs = inputs_;
+    size_t count = process(pad.data(), pad.size(), out);
+    inputs_ = inputs;
+    return count;
+}
+
+uint64_t Resampler::expected_outputs() const {
+    return (inputs_ * (uint64_t)filter_->up + filter_->down - 1) / filter_->down;
+}
+
+bool resample(const float* in, size_t n, int in_rate, int out_rate, std::vector<float>& out) {
+    int up, down;
+    if (!resample_ratio(in_rate, out_rate, up, down)) return false;
+    Resampler rs(up, down);
+    out.clear();
+    out.reserve((size_t)((uint64_t)n * up / down) + rs.delay() + 2);
+    rs.process(in, n, out);
+    uint64_t wanted = rs.expected_outputs();
+    rs.flush(out);
+    out.erase(out.begin(), out.begin() + rs.delay());
+    out.resize((size_t)wanted);
+    return true;
+}
@@ -0,0 +1,197 @@
+// rfsched.cpp
+//
+// Binary transmit schedules and a fast fixed-point text formatter.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "rfsched.h"
+
+static const char MAGIC[8] = {'R', 'F', 'S', 'C', 'H', 'E', 'D', '\0'};
+static const size_t HEADER_SIZE = 64;
+static const size_t MODE_SIZE = 8;
+
+static const int64_t POW10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+bool parse_rf_units(const char* text, RfScheduleFormat& format) {
+    format.units = RF_UNITS_MILLIHERTZ;
+    format.ref_clock_hz = 0.0;
+    format.word_bits = 0;
+    if (std::strcmp(text, "millihz") == 0) return true;
+    if (std::strncmp(text, "word:", 5) != 0) return false;
+    char* end;
+    format.units = RF_UNITS_TUNING_WORD;
+    format.ref_clock_hz = std::strtod(text + 5, &end);
+    format.word_bits = 32;
+    if (*end == ':') format.word_bits = (int)std::strtol(end + 1, &end, 10);
+    return *end == '\0' && format.ref_clock_hz > 0.0 && format.word_bits >= 1 && format.word_bits <= 63;
+}
+
+int64_t rf_millihertz(double hz) {
+    return llround(hz * 1000.0);
+}
+
+uint64_t rf_tuning_word(int64_t millihertz, double ref_clock_hz, int bits) {
+    long double word = (long double)millihertz * ldexpl(1.0L, bits) / ((long double)ref_clock_hz * 1000.0L);
+    return (uint64_t)llroundl(word);
+}
+
+template <typename T> static void put(unsigned char* p, T v) { std::memcpy(p, &v, sizeof(v)); }
+template <typename T> static T get(const unsigned char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void encode_header(unsigned char* h, const RfScheduleInfo& info) {
+    std::memset(h, 0, HEADER_SIZE);
+    std::memcpy(h, MAGIC, 8);
+    put(h + 8, (uint32_t)RF_SCHEDULE_VERSION);
+    put(h + 12, (uint32_t)info.format.units);
+    put(h + 16, info.dial_millihertz);
+    put(h + 24, info.symbol_ns);
+    put(h + 32, (uint64_t)rf_millihertz(info.format.ref_clock_hz));
+    put(h + 40, (uint32_t)info.format.word_bits);
+    put(h + 44, info.symbols);
+    put(h + 48, info.count);
+    std::memcpy(h + 56, info.mode.c_str(), std::min(info.mode.size(), MODE_SIZE));
+}
+
+RfScheduleWriter::RfScheduleWriter() : f_(NULL), tone_spacing_(0.0), count_(0), ok_(false) {}
+
+RfScheduleWriter::~RfScheduleWriter() {
+    if (f_) close();
+}
+
+bool RfScheduleWriter::open(const char* path, const MfskMode& mode, double dial_mhz,
+                            const RfScheduleFormat& format) {
+    if (f_) close();
+    if (mode.symbol_count <= 0) {
+        std::fprintf(stderr, "Error: %s messages have no fixed length to schedule\n", mode.name);
+        return false;
+    }
+    f_ = std::fopen(path, "wb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot create schedule %s\n", path);
+        return false;
+    }
+    path_ = path;
+    info_.mode = mode.name;
+    info_.format = format;
+    info_.dial_millihertz = rf_millihertz(dial_mhz * 1e6);
+    info_.symbol_ns = (uint64_t)llround(mode.symbol_period * 1e9);
+    info_.symbols = (uint32_t)mode.symbol_count;
+    info_.count = 0;
+    tone_spacing_ = mode.tone_spacing;
+    count_ = 0;
+    row_.resize(mode.symbol_count);
+
+    // Placeholder header, the count is filled in by close()
+    unsigned char h[HEADER_SIZE];
+    encode_header(h, info_);
+    ok_ = std::fwrite(h, 1, sizeof(h), f_) == sizeof(h);
+    return ok_;
+}
+
+bool RfScheduleWriter::add(const uint8_t* symbols, double base_hz) {
+    if (!f_ || !ok_) return false;
+    const RfScheduleFormat& format = info_.format;
+    for (size_t k = 0; k < row_.size(); k++) {
+        int64_t f = info_.dial_millihertz + rf_millihertz(base_hz + symbols[k] * tone_spacing_);
+        if (format.units == RF_UNITS_MILLIHERTZ) {
+            row_[k] = (uint64_t)f;
+            continue;
+        }
+        if (f < 0 || f >= rf_millihertz(format.ref_clock_hz)) {
+            std::fprintf(stderr, "Error: %.3f Hz is outside a %.0f Hz reference's range\n", f / 1000.0,
+                         format.ref_clock_hz);
+            return ok_ = false;
+        }
+        row_[k] = rf_tuning_word(f, format.ref_clock_hz, format.word_bits);
+    }
+    size_t bytes = row_.size() * sizeof(uint64_t);
+    ok_ = std::fwrite(row_.data(), 1, bytes, f_) == bytes;
+    if (ok_) count_++;
+    return ok_;
+}
+
+bool RfScheduleWriter::close() {
+    if (!f_) return false;
+    if (ok_) {
+        unsigned char h[HEADER_SIZE];
+        info_.count = count_;
+        encode_header(h, info_);
+        ok_ = std::fseek(f_, 0, SEEK_SET) == 0 && std::fwrite(h, 1, sizeof(h), f_) == sizeof(h);
+    }
+    if (std::fclose(f_) != 0) ok_ = false;
+    f_ = NULL;
+    if (!ok_) std::fprintf(stderr, "Error: Failed writing schedule %s\n", path_.c_str());
+    return ok_;
+}
+
+bool read_rf_schedule(const char* path, RfScheduleInfo& info, std::vector<uint64_t>& values) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot open schedule %s\n", path);
+        return false;
+    }
+    unsigned char h[HEADER_SIZE];
+    bool ok = std::fread(h, 1, sizeof(h), f) == sizeof(h) && std::memcmp(h, MAGIC, 8) == 0 &&
+              get<uint32_t>(h + 8) == (uint32_t)RF_SCHEDULE_VERSION && get<uint32_t>(h + 12) <= 1;
+    if (ok) {
+        info.format.units = (RfUnits)get<uint32_t>(h + 12);
+        info.dial_millihertz = get<int64_t>(h + 16);
+        info.symbol_ns = get<uint64_t>(h + 24);
+        info.format.ref_clock_hz = get<uint64_t>(h + 32) / 1000.0;
+        info.format.word_bits = (int)get<uint32_t>(h + 40);
+        info.symbols = get<uint32_t>(h + 44);
+        info.count = get<uint64_t>(h + 48);
+        info.mode.assign(reinterpret_cast<const char*>(h + 56), strnlen(reinterpret_cast<const char*>(h + 56), MODE_SIZE));
+
+        // Exactly count messages must follow
+        long end = std::fseek(f, 0, SEEK_END) == 0 ? std::ftell(f) : -1;
+        uint64_t bytes = end < 0 ? 0 : (uint64_t)end - HEADER_SIZE;
+        ok = end >= 0 && info.symbols > 0 && info.count == bytes / (info.symbols * sizeof(uint64_t)) &&
+             bytes % (info.symbols * sizeof(uint64_t)) == 0;
+        if (ok) {
+            values.resize((size_t)(bytes / sizeof(uint64_t)));
+            ok = std::fseek(f, (long)HEADER_SIZE, SEEK_SET) == 0 &&
+                 std::fread(values.data(), sizeof(uint64_t), values.size(), f) == values.size();
+        }
+    }
+    std::fclose(f);
+    if (!ok) {
+        std::fprintf(stderr, "Error: %s is not a complete schedule\n", path);
+        values.clear();
+    }
+    return ok;
+}
+
+size_t format_scaled(int64_t value, int decimals, char* out) {
+    char digits[24];
+    uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    int n = 0;
+    // Fraction and integer digits, least significant first
+    for (int d = 0; d < decimals; d++) {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    }
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    size_t len = 0;
+    if (value < 0) out[len++] = '-';
+    for (int k = n - 1; k >= decimals; k--) out[len++] = digits[k];
+    if (decimals > 0) {
+        out[len++] = '.';
+        for (int k = decimals - 1; k >= 0; k--) out[len++] = digits[k];
+    }
+    return len;
+}
+
+size_t format_fixed(double value, int decimals, char* out) {
+    return format_scaled(llround(value * POW10[decimals]), decimals, out);
+}
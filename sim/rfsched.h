@@ -0,0 +1,97 @@
+// rfsched.h
+//
+// Binary transmit schedules: the absolute RF frequency of every symbol
+// of one or more messages as integers, so a TX controller loads them
+// with one read and no float parsing.
+//
+//   header   "RFSCHED\0", version, units, dial frequency (mHz), symbol
+//            duration (ns), reference clock (mHz), tuning word bits,
+//            symbols per message, message count, mode name (64 bytes)
+//   values   count x symbols little endian 64-bit values, message by
+//            message: frequencies in millihertz, or synthesizer tuning
+//            words f * 2^bits / ref_clock for DDS parts such as the
+//            AD9850 (32 bits) or AD9912 (48 bits)
+//
+// Frequencies are summed in integer millihertz from the dial frequency
+// and the audio tone, so a schedule is exact to 0.5 mHz at any dial.
+
+#ifndef RFSCHED_H
+#define RFSCHED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "mfsk.h"
+
+const int RF_SCHEDULE_VERSION = 1;
+
+enum RfUnits {
+    RF_UNITS_MILLIHERTZ = 0,
+    RF_UNITS_TUNING_WORD = 1
+};
+
+struct RfScheduleFormat {
+    RfUnits units;
+    double ref_clock_hz;  // tuning words only
+    int word_bits;        // tuning words only, 1 ... 63
+};
+
+// "millihz", or "word:REF_HZ[:BITS]" with 32 bits by default
+bool parse_rf_units(const char* text, RfScheduleFormat& format);
+
+int64_t rf_millihertz(double hz);
+// Nearest tuning word for a frequency in millihertz
+uint64_t rf_tuning_word(int64_t millihertz, double ref_clock_hz, int bits);
+
+struct RfScheduleInfo {
+    std::string mode;
+    RfScheduleFormat format;
+    int64_t dial_millihertz;
+    uint64_t symbol_ns;
+    uint32_t symbols;       // per message
+    uint64_t count;         // messages
+};
+
+class RfScheduleWriter {
+public:
+    RfScheduleWriter();
+    ~RfScheduleWriter();
+
+    // Modes with a fixed symbol count only
+    bool open(const char* path, const MfskMode& mode, double dial_mhz, const RfScheduleFormat& format);
+    // Append one message with tone 0 at base_hz above the dial
+    bool add(const uint8_t* symbols, double base_hz);
+    // Write the final header
+    bool close();
+
+    uint64_t count() const { return count_; }
+
+private:
+    RfScheduleWriter(const RfScheduleWriter&);
+    RfScheduleWriter& operator=(const RfScheduleWriter&);
+
+    FILE* f_;
+    std::string path_;
+    RfScheduleInfo info_;
+    double tone_spacing_;
+    uint64_t count_;
+    bool ok_;
+    std::vector<uint64_t> row_;
+};
+
+// Load a whole schedule; false, with a message on stderr, if the file is
+// not one or is truncated
+bool read_rf_schedule(const char* path, RfScheduleInfo& info, std::vector<uint64_t>& values);
+
+// Write value with a fixed number of decimals (0 ... 9) to out and
+// return the length: printf("%.*f") without the locale, the terminator
+// or its cost, for |value| * 10^decimals below 9.2e18. A value within
+// a rounding error of a half may round the other way, and -0 prints as
+// 0. WSPR tone frequencies at 6 decimals match printf exactly.
+size_t format_fixed(double value, int decimals, char* out);
+// The same for an integer scaled by 10^-decimals
+size_t format_scaled(int64_t value, int decimals, char* out);
+
+#endif
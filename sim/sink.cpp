@@ -0,0 +1,60 @@
+// sink.cpp
+//
+// In-memory output files and running programs on them.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sink.h"
+
+MemFile::MemFile() : fd_(-1) {}
+
+MemFile::~MemFile() {
+    close();
+}
+
+bool MemFile::create(const char* name) {
+    close();
+    // No MFD_CLOEXEC: children must inherit the descriptor
+    fd_ = memfd_create(name, 0);
+    if (fd_ < 0) {
+        std::fprintf(stderr, "Error: Cannot create in-memory file: %s\n", std::strerror(errno));
+        return false;
+    }
+    path_ = "/proc/self/fd/" + std::to_string(fd_);
+    return true;
+}
+
+void MemFile::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    path_.clear();
+}
+
+size_t MemFile::size() const {
+    struct stat st;
+    return fd_ >= 0 && fstat(fd_, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+int run_with_path(const char* command, const std::string& path) {
+    std::string line(command);
+    size_t pos = line.find("{}");
+    if (pos == std::string::npos) {
+        line += " " + path;
+    }
+    for (; pos != std::string::npos; pos = line.find("{}", pos + path.size())) {
+        line.replace(pos, 2, path);
+    }
+    std::fflush(NULL);
+    int status = std::system(line.c_str());
+    if (status == -1 || !WIFEXITED(status)) {
+        std::fprintf(stderr, "Error: Could not run '%s'\n", line.c_str());
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
@@ -0,0 +1,43 @@
+// sink.h
+//
+// Output without temporary files: an anonymous in-memory file (a Linux
+// memfd) that other programs open by its /proc/self/fd/N path, and
+// running such a program on it. The path is inherited by child
+// processes, which see the same descriptor number, and behaves as a
+// seekable regular file, so tools that insist on a file name work.
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <cstddef>
+#include <string>
+
+class MemFile {
+public:
+    MemFile();
+    ~MemFile();
+
+    // Create an empty in-memory file; false, with a message on stderr,
+    // where memfd is not available
+    bool create(const char* name);
+    void close();
+
+    int fd() const { return fd_; }
+    // "/proc/self/fd/N", valid in this process and its children
+    const std::string& path() const { return path_; }
+    size_t size() const;
+
+private:
+    MemFile(const MemFile&);
+    MemFile& operator=(const MemFile&);
+
+    int fd_;
+    std::string path_;
+};
+
+// Run command through /bin/sh with each "{}" replaced by path, or path
+// appended when there is none. Returns its exit status, or -1 if it
+// could not run or was killed.
+int run_with_path(const char* command, const std::string& path);
+
+#endif
@@ -0,0 +1,231 @@
+// symfile.cpp
+//
+// Bit-packed symbol corpus files.
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "symfile.h"
+
+static const char MAGIC[8] = {'W', 'S', 'Y', 'M', 'P', 'A', 'C', 'K'};
+static const size_t HEADER_SIZE = 48;
+static const size_t META_SIZE = 32;
+static const size_t MODE_SIZE = 16;
+
+// Copy up to size characters of text into a NUL padded field
+static void copy_field(char* field, size_t size, const char* text) {
+    std::memset(field, 0, size);
+    std::memcpy(field, text, strnlen(text, size));
+}
+
+int symbol_bits(const MfskMode& mode) {
+    int bits = 1;
+    while ((1 << bits) < mode.tone_count) bits++;
+    return bits;
+}
+
+void set_symbol_meta(SymbolMeta& meta, const char* call, const char* grid, int dbm, int symbols,
+                     bool altered) {
+    std::memset(&meta, 0, sizeof(meta));
+    copy_field(meta.call, sizeof(meta.call), call);
+    copy_field(meta.grid, sizeof(meta.grid), grid);
+    meta.dbm = dbm;
+    meta.symbols = (uint16_t)symbols;
+    meta.altered = altered ? 1 : 0;
+}
+
+void pack_symbols(const uint8_t* symbols, int count, int bits, uint8_t* out) {
+    uint32_t acc = 0, mask = (1u << bits) - 1;
+    int have = 0;
+    for (int k = 0; k < count; k++) {
+        acc |= (uint32_t)(symbols[k] & mask) << have;
+        have += bits;
+        while (have >= 8) {
+            *out++ = (uint8_t)acc;
+            acc >>= 8;
+            have -= 8;
+        }
+    }
+    if (have > 0) *out = (uint8_t)acc;
+}
+
+void unpack_symbols(const uint8_t* in, int count, int bits, uint8_t* symbols) {
+    uint32_t acc = 0, mask = (1u << bits) - 1;
+    int have = 0;
+    for (int k = 0; k < count; k++) {
+        while (have < bits) {
+            acc |= (uint32_t)*in++ << have;
+            have += 8;
+        }
+        symbols[k] = (uint8_t)(acc & mask);
+        acc >>= bits;
+        have -= bits;
+    }
+}
+
+template <typename T> static void put(unsigned char* p, T v) { std::memcpy(p, &v, sizeof(v)); }
+template <typename T> static T get(const unsigned char* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void encode_header(unsigned char* h, const std::string& mode, int bits, int max_symbols,
+                          size_t row_bytes, uint64_t count) {
+    std::memset(h, 0, HEADER_SIZE);
+    std::memcpy(h, MAGIC, 8);
+    put(h + 8, (uint32_t)SYMFILE_VERSION);
+    put(h + 12, (uint32_t)bits);
+    put(h + 16, (uint32_t)max_symbols);
+    put(h + 20, (uint32_t)row_bytes);
+    put(h + 24, count);
+    copy_field(reinterpret_cast<char*>(h + 32), MODE_SIZE, mode.c_str());
+}
+
+static void encode_meta(unsigned char* e, const SymbolMeta& m) {
+    std::memset(e, 0, META_SIZE);
+    std::memcpy(e, m.call, sizeof(m.call));
+    std::memcpy(e + 12, m.grid, sizeof(m.grid));
+    put(e + 20, m.dbm);
+    put(e + 24, m.symbols);
+    e[26] = m.altered;
+}
+
+SymbolFileWriter::SymbolFileWriter()
+    : f_(NULL), bits_(0), max_symbols_(0), row_bytes_(0), ok_(false) {}
+
+SymbolFileWriter::~SymbolFileWriter() {
+    if (f_) close();
+}
+
+bool SymbolFileWriter::open(const char* path, const MfskMode& mode, int max_symbols) {
+    if (f_) close();
+    f_ = std::fopen(path, "wb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot create symbol file %s\n", path);
+        return false;
+    }
+    path_ = path;
+    mode_ = mode.name;
+    bits_ = symbol_bits(mode);
+    max_symbols_ = max_symbols > 0 ? max_symbols : (mode.symbol_count > 0 ? mode.symbol_count : MFSK_MAX_SYMBOLS);
+    row_bytes_ = ((size_t)max_symbols_ * bits_ + 7) / 8;
+    row_.assign(row_bytes_, 0);
+    meta_.clear();
+
+    // Placeholder header, the count is filled in by close()
+    unsigned char h[HEADER_SIZE];
+    encode_header(h, mode_, bits_, max_symbols_, row_bytes_, 0);
+    ok_ = std::fwrite(h, 1, sizeof(h), f_) == sizeof(h);
+    return ok_;
+}
+
+bool SymbolFileWriter::add(const SymbolMeta& meta, const uint8_t* symbols) {
+    if (!f_ || !ok_) return false;
+    if (meta.symbols > max_symbols_) {
+        std::fprintf(stderr, "Error: %d symbols do not fit rows of %d\n", meta.symbols, max_symbols_);
+        return false;
+    }
+    std::fill(row_.begin(), row_.end(), 0);
+    pack_symbols(symbols, meta.symbols, bits_, row_.data());
+    ok_ = std::fwrite(row_.data(), 1, row_bytes_, f_) == row_bytes_;
+    meta_.push_back(meta);
+    return ok_;
+}
+
+bool SymbolFileWriter::close() {
+    if (!f_) return false;
+    unsigned char e[META_SIZE];
+    for (size_t k = 0; ok_ && k < meta_.size(); k++) {
+        encode_meta(e, meta_[k]);
+        ok_ = std::fwrite(e, 1, sizeof(e), f_) == sizeof(e);
+    }
+    if (ok_) {
+        unsigned char h[HEADER_SIZE];
+        encode_header(h, mode_, bits_, max_symbols_, row_bytes_, meta_.size());
+        ok_ = std::fseek(f_, 0, SEEK_SET) == 0 && std::fwrite(h, 1, sizeof(h), f_) == sizeof(h);
+    }
+    if (std::fclose(f_) != 0) ok_ = false;
+    f_ = NULL;
+    if (!ok_) std::fprintf(stderr, "Error: Failed writing symbol file %s\n", path_.c_str());
+    return ok_;
+}
+
+SymbolFileReader::SymbolFileReader()
+    : map_(NULL), length_(0), bits_(0), max_symbols_(0), row_bytes_(0), count_(0), rows_(NULL),
+      meta_(NULL) {}
+
+SymbolFileReader::~SymbolFileReader() {
+    close();
+}
+
+bool SymbolFileReader::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "Error: Cannot open symbol file %s\n", path);
+        return false;
+    }
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= HEADER_SIZE) {
+        length_ = (size_t)st.st_size;
+        p = mmap(NULL, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        std::fprintf(stderr, "Error: %s is not a symbol file\n", path);
+        return false;
+    }
+    map_ = p;
+
+    const unsigned char* h = static_cast<const unsigned char*>(p);
+    bits_ = (int)get<uint32_t>(h + 12);
+    max_symbols_ = (int)get<uint32_t>(h + 16);
+    row_bytes_ = get<uint32_t>(h + 20);
+    uint64_t count = get<uint64_t>(h + 24);
+    mode_.assign(reinterpret_cast<const char*>(h + 32), strnlen(reinterpret_cast<const char*>(h + 32), MODE_SIZE));
+    bool ok = std::memcmp(h, MAGIC, 8) == 0 && get<uint32_t>(h + 8) == (uint32_t)SYMFILE_VERSION &&
+              bits_ >= 1 && bits_ <= 8 && row_bytes_ == ((size_t)max_symbols_ * bits_ + 7) / 8 &&
+              count == (length_ - HEADER_SIZE) / (row_bytes_ + META_SIZE) &&
+              (length_ - HEADER_SIZE) % (row_bytes_ + META_SIZE) == 0;
+    if (!ok) {
+        std::fprintf(stderr, "Error: %s is not a complete symbol file\n", path);
+        close();
+        return false;
+    }
+    count_ = (size_t)count;
+    rows_ = h + HEADER_SIZE;
+    meta_ = rows_ + count_ * row_bytes_;
+    return true;
+}
+
+void SymbolFileReader::close() {
+    if (map_) munmap(map_, length_);
+    map_ = NULL;
+    length_ = 0;
+    count_ = 0;
+    rows_ = NULL;
+    meta_ = NULL;
+}
+
+SymbolMeta SymbolFileReader::meta(size_t k) const {
+    const unsigned char* e = meta_ + k * META_SIZE;
+    SymbolMeta m;
+    std::memcpy(m.call, e, sizeof(m.call));
+    std::memcpy(m.grid, e + 12, sizeof(m.grid));
+    m.dbm = get<int32_t>(e + 20);
+    m.symbols = get<uint16_t>(e + 24);
+    m.altered = e[26];
+    if (m.symbols > max_symbols_) m.symbols = (uint16_t)max_symbols_;
+    return m;
+}
+
+int SymbolFileReader::symbols(size_t k, uint8_t* out) const {
+    int n = meta(k).symbols;
+    unpack_symbols(rows_ + k * row_bytes_, n, bits_, out);
+    return n;
+}
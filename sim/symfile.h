@@ -0,0 +1,114 @@
+// symfile.h
+//
+// Bit-packed symbol corpus: many messages of one MFSK mode in a file, each
+// symbol in the fewest bits its mode's alphabet needs (2 for WSPR and JT4,
+// 3 for FT8, 4 for JT9, 6 for FSQ, 7 for JT65 with its merged sync tone),
+// so a WSPR message takes 41 bytes instead of a 162 byte .bits file.
+//
+//   header    "WSYMPACK", version, bits per symbol, symbols per row,
+//             row bytes, message count, mode name (48 bytes)
+//   rows      one per message, symbol k in bits [k * bits, k * bits +
+//             bits) counting from bit 0 of byte 0
+//   metadata  32 bytes per message: call, grid, dBm, symbol count and
+//             sync variant
+//
+// Rows are fixed size, so the reader maps the file once and reaches any
+// message by index. Files are little endian.
+
+#ifndef SYMFILE_H
+#define SYMFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "mfsk.h"
+
+const int SYMFILE_VERSION = 1;
+
+// Bits per symbol for a mode: enough for tone_count values
+int symbol_bits(const MfskMode& mode);
+
+struct SymbolMeta {
+    char call[12];        // NUL padded
+    char grid[8];
+    int32_t dbm;
+    uint16_t symbols;     // in this message (FSQ varies)
+    uint8_t altered;      // 1 for the altered WSPR sync vector
+};
+
+// Fill meta from strings, truncating to the field sizes
+void set_symbol_meta(SymbolMeta& meta, const char* call, const char* grid, int dbm, int symbols,
+                     bool altered);
+
+class SymbolFileWriter {
+public:
+    SymbolFileWriter();
+    ~SymbolFileWriter();
+
+    // Rows of max_symbols symbols (the mode's fixed count, or
+    // MFSK_MAX_SYMBOLS for terminated modes when 0)
+    bool open(const char* path, const MfskMode& mode, int max_symbols = 0);
+    // Append one message of meta.symbols symbols
+    bool add(const SymbolMeta& meta, const uint8_t* symbols);
+    // Write the metadata table and the final header
+    bool close();
+
+    size_t count() const { return meta_.size(); }
+
+private:
+    SymbolFileWriter(const SymbolFileWriter&);
+    SymbolFileWriter& operator=(const SymbolFileWriter&);
+
+    FILE* f_;
+    std::string path_;
+    std::string mode_;
+    int bits_;
+    int max_symbols_;
+    size_t row_bytes_;
+    bool ok_;
+    std::vector<SymbolMeta> meta_;
+    std::vector<uint8_t> row_;
+};
+
+class SymbolFileReader {
+public:
+    SymbolFileReader();
+    ~SymbolFileReader();
+
+    // Map a file; returns false, with a message on stderr, if it is not
+    // a complete symbol file
+    bool open(const char* path);
+    void close();
+
+    size_t size() const { return count_; }
+    const std::string& mode() const { return mode_; }
+    int bits() const { return bits_; }
+    int max_symbols() const { return max_symbols_; }
+
+    SymbolMeta meta(size_t k) const;
+    // Unpack message k into symbols; returns its symbol count
+    int symbols(size_t k, uint8_t* out) const;
+
+private:
+    SymbolFileReader(const SymbolFileReader&);
+    SymbolFileReader& operator=(const SymbolFileReader&);
+
+    void* map_;
+    size_t length_;
+    std::string mode_;
+    int bits_;
+    int max_symbols_;
+    size_t row_bytes_;
+    size_t count_;
+    const unsigned char* rows_;
+    const unsigned char* meta_;
+};
+
+// Pack count symbols of bits bits each into out (ceil(count * bits / 8)
+// bytes), and the reverse
+void pack_symbols(const uint8_t* symbols, int count, int bits, uint8_t* out);
+void unpack_symbols(const uint8_t* in, int count, int bits, uint8_t* symbols);
+
+#endif
@@ -0,0 +1,139 @@
+// sync_search.cpp
+//
+// WSPR sync search over a DT x frequency grid.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "JTEncode.h"
+#include "fft.h"
+#include "sync_search.h"
+#include "wspr_sync.h"
+
+// Spectra per symbol
+static const long STEPS_PER_SYMBOL = SYNC_SYMBOL / SYNC_HOP;
+
+SyncSearch::SyncSearch(const float* in_i, const float* in_q, size_t n, double sample_rate)
+    : rate_(sample_rate), t_first_(0), t_count_(0), f_first_(0), f_count_(0) {
+    steps_ = n < (size_t)SYNC_SYMBOL ? 0 : (n - SYNC_SYMBOL) / SYNC_HOP + 1;
+    power_.resize(steps_ * SYNC_FFT_SIZE);
+
+    Fft fft(SYNC_FFT_SIZE);
+    std::vector<float> re(SYNC_FFT_SIZE), im(SYNC_FFT_SIZE);
+    for (size_t t = 0; t < steps_; t++) {
+        const float* xi = in_i + t * SYNC_HOP;
+        const float* xq = in_q + t * SYNC_HOP;
+        std::copy(xi, xi + SYNC_SYMBOL, re.begin());
+        std::copy(xq, xq + SYNC_SYMBOL, im.begin());
+        std::fill(re.begin() + SYNC_SYMBOL, re.end(), 0.0f);
+        std::fill(im.begin() + SYNC_SYMBOL, im.end(), 0.0f);
+        fft.forward(re.data(), im.data());
+
+        // Rotate so 0 Hz sits in the middle
+        float* p = &power_[t * SYNC_FFT_SIZE];
+        for (int b = 0; b < SYNC_FFT_SIZE; b++) {
+            int k = (b + SYNC_FFT_SIZE / 2) % SYNC_FFT_SIZE;
+            p[b] = re[k] * re[k] + im[k] * im[k];
+        }
+    }
+}
+
+void SyncSearch::correlate(double dt_min, double dt_max, double span) {
+    double bin_hz = rate_ / SYNC_FFT_SIZE;
+    // Tone 0 is 3 bins (1.5 tone spacings) below the signal center
+    long centre = SYNC_FFT_SIZE / 2 - 3;
+    long reach = (long)std::floor(span / bin_hz);
+    // Room for the neighbouring tones -1 and 4 on either side
+    f_first_ = std::max(2L, centre - reach);
+    long f_last = std::min((long)SYNC_FFT_SIZE - 9, centre + reach);
+    f_count_ = std::max(0L, f_last - f_first_ + 1);
+
+    t_first_ = (long)std::ceil((1.0 + dt_min) * rate_ / SYNC_HOP);
+    long t_last = (long)std::floor((1.0 + dt_max) * rate_ / SYNC_HOP);
+    t_count_ = std::max(0L, t_last - t_first_ + 1);
+
+    // Per spectrum and tone 0 bin: sync difference, and total power over
+    // tones -1 to 4
+    std::vector<float> diff(steps_ * f_count_), total(steps_ * f_count_);
+    for (size_t t = 0; t < steps_; t++) {
+        const float* p = &power_[t * SYNC_FFT_SIZE + f_first_];
+        float* d = &diff[t * f_count_];
+        float* s = &total[t * f_count_];
+        for (long f = 0; f < f_count_; f++) {
+            float even = p[f] + p[f + 4], odd = p[f + 2] + p[f + 6];
+            d[f] = odd - even;
+            s[f] = odd + even + p[f - 2] + p[f + 8];
+        }
+    }
+
+    grid_.assign(t_count_ * f_count_, 0.0f);
+    std::vector<float> num(f_count_), den(f_count_);
+    for (long t = 0; t < t_count_; t++) {
+        std::fill(num.begin(), num.end(), 0.0f);
+        std::fill(den.begin(), den.end(), 0.0f);
+        for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+            // Symbols outside the recording contribute nothing
+            long step = t_first_ + t + k * STEPS_PER_SYMBOL;
+            if (step < 0 || step >= (long)steps_) continue;
+            const float* d = &diff[step * f_count_];
+            const float* s = &total[step * f_count_];
+            float sign = WSPR_SYNC_VECTOR[k] ? 1.0f : -1.0f;
+            for (long f = 0; f < f_count_; f++) {
+                num[f] += sign * d[f];
+                den[f] += s[f];
+            }
+        }
+        float* g = &grid_[t * f_count_];
+        for (long f = 0; f < f_count_; f++) g[f] = den[f] > 0.0f ? num[f] / den[f] : 0.0f;
+    }
+}
+
+// Vertex offset of a parabola through three points, in (-0.5, 0.5)
+static double parabola(double a, double b, double c) {
+    double d = a - 2.0 * b + c;
+    return d < 0.0 ? std::max(-0.5, std::min(0.5, 0.5 * (a - c) / d)) : 0.0;
+}
+
+std::vector<SyncPeak> SyncSearch::peaks(bool altered, size_t count) const {
+    double sign = altered ? -1.0 : 1.0;
+    std::vector<std::pair<double, long> > maxima;
+    for (long t = 0; t < t_count_; t++) {
+        for (long f = 0; f < f_count_; f++) {
+            double m = sign * metric(t, f);
+            if (m <= 0.0) continue;
+            bool best = true;
+            for (long dt = -1; dt <= 1 && best; dt++) {
+                for (long df = -1; df <= 1; df++) {
+                    long tt = t + dt, ff = f + df;
+                    if ((dt || df) && tt >= 0 && tt < t_count_ && ff >= 0 && ff < f_count_ &&
+                        sign * metric(tt, ff) > m) {
+                        best = false;
+                        break;
+                    }
+                }
+            }
+            if (best) maxima.push_back(std::make_pair(m, t * f_count_ + f));
+        }
+    }
+    count = std::min(count, maxima.size());
+    std::partial_sort(maxima.begin(), maxima.begin() + count, maxima.end(),
+                      std::greater<std::pair<double, long> >());
+
+    std::vector<SyncPeak> out;
+    double bin_hz = rate_ / SYNC_FFT_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        long t = maxima[i].second / f_count_, f = maxima[i].second % f_count_;
+        double ot = 0.0, of = 0.0;
+        if (t > 0 && t + 1 < t_count_)
+            ot = parabola(sign * metric(t - 1, f), maxima[i].first, sign * metric(t + 1, f));
+        if (f > 0 && f + 1 < f_count_)
+            of = parabola(sign * metric(t, f - 1), maxima[i].first, sign * metric(t, f + 1));
+
+        SyncPeak p;
+        p.dt = (t_first_ + t + ot) * SYNC_HOP / rate_ - 1.0;
+        p.freq = (f_first_ + f + of + 3 - SYNC_FFT_SIZE / 2) * bin_hz;
+        p.metric = maxima[i].first;
+        out.push_back(p);
+    }
+    return out;
+}
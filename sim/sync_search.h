@@ -0,0 +1,64 @@
+// sync_search.h
+//
+// WSPR sync search over a whole DT x frequency grid from one pass of
+// symbol-length spectra, as wsprd's coarse search does but for any start
+// offset a test needs.
+//
+// Spectra are 256-sample (one symbol) windows zero padded to 512 points,
+// so bins fall every half tone spacing, taken every 1/16 symbol. For a
+// candidate whose tone 0 falls in bin b the sync metric is
+//   sum_k (2 s_k - 1) ((p1 + p3) - (p0 + p2)) / sum_k (p-1 + p0 + ... + p4)
+// over the 162 symbols, tone j at bin b + 2j. wsprd's coarse metric
+// divides by p0 + ... + p3 only, which scores a signal one tone off as a
+// perfect match of the other sync variant (and two tones off as itself);
+// it only gets away with that by testing spectral peaks. Counting the
+// neighbouring tones -1 and 4 brings those aliases down to about 0.85
+// (the other variant one tone off) and 0.7 (the same variant two tones
+// off) of a true match on a clean signal. Inverting the sync vector
+// negates the metric, so the altered variant's grid is the normal one
+// with the sign flipped and costs nothing extra.
+
+#ifndef SYNC_SEARCH_H
+#define SYNC_SEARCH_H
+
+#include <cstddef>
+#include <vector>
+
+const int SYNC_SYMBOL = 256;    // samples per symbol at 375 (or 375/8) sps
+const int SYNC_FFT_SIZE = 512;
+const int SYNC_HOP = 16;        // samples between spectra
+
+struct SyncPeak {
+    double dt;      // s, 0 = symbols starting 1 s into the file
+    double freq;    // Hz from 0 Hz baseband to the signal center (between tones 1 and 2)
+    double metric;  // normalized sync correlation, 1 for a clean signal
+};
+
+class SyncSearch {
+public:
+    // Complex baseband at 375 or 375/8 sps
+    SyncSearch(const float* in_i, const float* in_q, size_t n, double sample_rate);
+
+    // Metric for every grid point with dt in [dt_min, dt_max] and the
+    // signal center within +-span Hz
+    void correlate(double dt_min, double dt_max, double span);
+
+    // Up to count best local maxima of a variant's grid, refined by
+    // parabolic interpolation between grid points
+    std::vector<SyncPeak> peaks(bool altered, size_t count) const;
+
+    size_t spectra() const { return steps_; }
+    size_t grid_points() const { return grid_.size(); }
+
+private:
+    double metric(long t, long f) const { return grid_[t * f_count_ + f]; }
+
+    double rate_;
+    size_t steps_;
+    std::vector<float> power_;   // steps_ x SYNC_FFT_SIZE, 0 Hz at SYNC_FFT_SIZE / 2
+    long t_first_, t_count_;     // start spectrum index range of the grid
+    long f_first_, f_count_;     // tone 0 bin range
+    std::vector<float> grid_;
+};
+
+#endif
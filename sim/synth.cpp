@@ -0,0 +1,148 @@
+// synth.cpp
+//
+// WSPR audio synthesis: the direct per-sample generator and the
+// tone-template cache engine used for bulk rendering.
+
+#include <cmath>
+#include <cstring>
+#include "synth.h"
+#include "wspr_params.h"
+
+double raised_cosine(double x) {
+    if (x <= -1.0 || x >= 1.0) return 0.0;
+    return 0.5 * (1.0 + cos(M_PI * x));
+}
+
+double volume_envelope(int sample_pos) {
+    if (sample_pos >= 0 && sample_pos < SLOPE_SAMPLES) {
+        // Fade in
+        return raised_cosine(1.0 - (double)sample_pos / SLOPE_SAMPLES);
+    }
+    if (sample_pos >= (SIGNAL_LENGTH - SLOPE_SAMPLES) && sample_pos < SIGNAL_LENGTH) {
+        // Fade out
+        int fade_pos = sample_pos - (SIGNAL_LENGTH - SLOPE_SAMPLES);
+        return raised_cosine((double)fade_pos / SLOPE_SAMPLES);
+    }
+    if (sample_pos >= 0 && sample_pos < SIGNAL_LENGTH) {
+        // Full volume
+        return 1.0;
+    }
+    // Outside signal range
+    return 0.0;
+}
+
+void generate_wav_signal(const uint8_t* symbols, std::vector<double>& signal) {
+    signal.assign(TOTAL_SAMPLES, 0.0);
+
+    double phase = 0.0;
+    double two_pi_dt = 2.0 * M_PI / SAMPLE_RATE;
+
+    for (int sym = 0; sym < WSPR_SYMBOL_COUNT; sym++) {
+        // Calculate frequency for this symbol
+        double freq = CENTER_FREQ + ((double)symbols[sym] - 1.5) * FREQ_SPACING; //maps 4 audio freqs spaced around the center freq
+        double dphi = two_pi_dt * freq; // uses the freqs to generate the phase since the phase changes wit the freqs
+
+        // Generate samples for this symbol
+        for (int samp = 0; samp < SYMBOL_LENGTH; samp++) {
+            int total_pos = DELAY_SAMPLES + sym * SYMBOL_LENGTH + samp;//gets the absolute position of the signal vector where the sample should be stored
+
+            if (total_pos < TOTAL_SAMPLES) {
+                // apply fade-in/out envelope
+                int env_idx = total_pos - DELAY_SAMPLES;
+                double env = volume_envelope(env_idx);
+                signal[total_pos] = 0.5 * env * sin(phase);
+            }
+            phase += dphi;
+        }
+
+        // Keep phase continuous but normalize to prevent overflow
+        while (phase > 2.0 * M_PI) {
+            phase -= 2.0 * M_PI;
+        }
+        while (phase < -2.0 * M_PI) {
+            phase += 2.0 * M_PI;
+        }
+    }
+}
+
+ToneCache::ToneCache(int sample_rate, int symbol_length, double base_freq,
+                     double spacing, int tones, double amplitude)
+    : symbol_length_(symbol_length), tones_(tones),
+      sin_((size_t)tones * symbol_length), cos_((size_t)tones * symbol_length),
+      advance_(tones) {
+    for (int t = 0; t < tones; t++) {
+        double freq = base_freq + t * spacing;
+        double w = 2.0 * M_PI * freq / sample_rate;
+        float* s = &sin_[(size_t)t * symbol_length];
+        float* c = &cos_[(size_t)t * symbol_length];
+        for (int n = 0; n < symbol_length; n++) {
+            s[n] = amplitude * sin(w * n);
+            c[n] = amplitude * cos(w * n);
+        }
+        // Keep the advance in cycles so exact tone plans (WSPR: a whole
+        // number of half cycles per symbol) stay exact
+        double cycles = freq * symbol_length / sample_rate;
+        advance_[t] = cycles - floor(cycles);
+    }
+}
+
+void ToneCache::render(const uint8_t* symbols, int count, float* out, double& phase) const {
+    double cycle = phase / (2.0 * M_PI);
+    cycle -= floor(cycle);
+    const size_t len = symbol_length_;
+
+    for (int sym = 0; sym < count; sym++, out += len) {
+        int t = symbols[sym] < tones_ ? symbols[sym] : tones_ - 1;
+        const float* s = &sin_[t * len];
+        const float* c = &cos_[t * len];
+
+        double half = 2.0 * cycle;
+        if (fabs(half - floor(half + 0.5)) < 1e-12) {
+            // Start phase is 0 or pi: the block is reused as is
+            if (floor(half + 0.5) == 1.0) {
+                for (size_t n = 0; n < len; n++) out[n] = -s[n];
+            } else {
+                memcpy(out, s, len * sizeof(float));
+            }
+        } else {
+            const float cp = cos(2.0 * M_PI * cycle);
+            const float sp = sin(2.0 * M_PI * cycle);
+            for (size_t n = 0; n < len; n++) out[n] = cp * s[n] + sp * c[n];
+        }
+
+        cycle += advance_[t];
+        cycle -= floor(cycle);
+    }
+    phase = 2.0 * M_PI * cycle;
+}
+
+void apply_fade_in(float* signal, int slope) {
+    for (int i = 0; i < slope; i++) {
+        signal[i] *= raised_cosine(1.0 - (double)i / slope);
+    }
+}
+
+void apply_fade_out(float* signal, int length, int slope) {
+    for (int i = 0; i < slope; i++) {
+        signal[length - slope + i] *= raised_cosine((double)i / slope);
+    }
+}
+
+void apply_edge_envelope(float* signal, int length, int slope) {
+    if (slope <= 0) return;
+    if (slope > length / 2) slope = length / 2;
+    apply_fade_in(signal, slope);
+    apply_fade_out(signal, length, slope);
+}
+
+ToneCache make_wspr_tone_cache() {
+    return ToneCache(SAMPLE_RATE, SYMBOL_LENGTH, CENTER_FREQ - 1.5 * FREQ_SPACING,
+                     FREQ_SPACING, 4, 0.5);
+}
+
+void render_wspr_signal(const ToneCache& cache, const uint8_t* symbols, std::vector<float>& signal) {
+    signal.assign(TOTAL_SAMPLES, 0.0f);
+    double phase = 0.0;
+    cache.render(symbols, WSPR_SYMBOL_COUNT, &signal[DELAY_SAMPLES], phase);
+    apply_edge_envelope(&signal[DELAY_SAMPLES], SIGNAL_LENGTH, SLOPE_SAMPLES);
+}
@@ -0,0 +1,62 @@
+// synth.h
+//
+// WSPR audio synthesis: the direct per-sample generator and the
+// tone-template cache engine used for bulk rendering.
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <cstdint>
+#include <vector>
+
+// Calculate raised cosine slope for fade in/out
+double raised_cosine(double x);
+
+// Volume envelope for fade in/out
+double volume_envelope(int sample_pos);
+
+// Generate WAV audio signal from WSPR symbols, one sin() per sample
+void generate_wav_signal(const uint8_t* symbols, std::vector<double>& signal);
+
+// Precomputed per-tone sample blocks for phase-continuous MFSK.
+//
+// Every symbol of a given tone is the same sinusoid segment, only started
+// at a different phase. The cache holds amplitude * sin and amplitude * cos
+// of one symbol for each tone, so a symbol starting at phase p is
+//   sin(p + wn) = cos(p) * sin(wn) + sin(p) * cos(wn)
+// (the imaginary part of one complex multiply). When the start phase is a
+// multiple of pi the block is copied, or negated, without any multiply.
+class ToneCache {
+public:
+    ToneCache(int sample_rate, int symbol_length, double base_freq,
+              double spacing, int tones, double amplitude);
+
+    // Render count symbols (symbol_length() samples each) into out,
+    // continuing from and updating the running phase.
+    void render(const uint8_t* symbols, int count, float* out, double& phase) const;
+
+    int symbol_length() const { return symbol_length_; }
+    int tones() const { return tones_; }
+
+private:
+    int symbol_length_;
+    int tones_;
+    std::vector<float> sin_;       // tones x symbol_length
+    std::vector<float> cos_;       // tones x symbol_length
+    std::vector<double> advance_;  // phase advance over one symbol, per tone
+};
+
+// Raised cosine fade in over the first, or fade out over the last, slope samples
+void apply_fade_in(float* signal, int slope);
+void apply_fade_out(float* signal, int length, int slope);
+
+// Apply the raised cosine fade in/out to the first and last slope samples
+void apply_edge_envelope(float* signal, int length, int slope);
+
+// ToneCache laid out for WSPR-2 at SAMPLE_RATE (0.5 amplitude, like generate_wav_signal)
+ToneCache make_wspr_tone_cache();
+
+// Cached equivalent of generate_wav_signal: TOTAL_SAMPLES with delays and envelope
+void render_wspr_signal(const ToneCache& cache, const uint8_t* symbols, std::vector<float>& signal);
+
+#endif
@@ -0,0 +1,90 @@
+// timing.cpp
+//
+// Clock and timing impairments.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "timing.h"
+#include "wspr_stream.h"
+
+// Sample rate the card actually ran at
+static double true_rate(double sample_rate, const TimingImpairment& timing) {
+    return sample_rate * (1.0 + timing.ppm * 1e-6);
+}
+
+// Output position of the first symbol, in samples
+static double start_position(double sample_rate, const TimingImpairment& timing) {
+    double rate = true_rate(sample_rate, timing);
+    return (double)llround(rate) + timing.dt * rate;
+}
+
+// Fraction of the start position left to the fractional delay
+static double start_fraction(double sample_rate, const TimingImpairment& timing) {
+    double start = start_position(sample_rate, timing);
+    return start - std::floor(start);
+}
+
+static MfskSynth make_timed_synth(const MfskMode& mode, const uint8_t* symbols, double sample_rate,
+                                  double center_freq, float amplitude,
+                                  const TimingImpairment& timing, double reference) {
+    // A tone rendered at g Hz at the true rate lands at g / (1 + e) in the
+    // file; shift so audio frequency F lands at F / (1 + e) - reference
+    double e = timing.ppm * 1e-6;
+    MfskSynth synth = make_wspr_synth(mode, symbols, true_rate(sample_rate, timing),
+                                      center_freq - reference * e, amplitude);
+    synth.set_drift(timing.drift, timing.drift2);
+    return synth;
+}
+
+TimedSynth::TimedSynth(const MfskMode& mode, const uint8_t* symbols, double sample_rate,
+                       double center_freq, float amplitude, const TimingImpairment& timing,
+                       double reference)
+    : synth_(make_timed_synth(mode, symbols, sample_rate, center_freq, amplitude, timing, reference)),
+      delay_i_(start_fraction(sample_rate, timing)),
+      delay_q_(start_fraction(sample_rate, timing)),
+      pos_(0) {
+    total_ = make_wspr_synth(mode, symbols, sample_rate, center_freq, amplitude).total_samples();
+
+    // The filter adds FRAC_DELAY_LATENCY samples; start the synthesizer
+    // that much earlier, or drop the head of the output if the signal
+    // starts before the recording does
+    double start = std::floor(start_position(sample_rate, timing));
+    double lead = start - (double)FRAC_DELAY_LATENCY;
+    synth_.set_delay(lead > 0.0 ? (size_t)lead : 0);
+    size_t skip = lead < 0.0 ? (size_t)-lead : 0;
+
+    std::vector<float> i(std::min<size_t>(skip, 4096)), q(i.size());
+    while (skip > 0) {
+        size_t n = std::min(skip, i.size());
+        std::fill(i.begin(), i.end(), 0.0f);
+        std::fill(q.begin(), q.end(), 0.0f);
+        synth_.render_iq(i.data(), q.data(), n);
+        delay_i_.process(i.data(), n);
+        delay_q_.process(q.data(), n);
+        skip -= n;
+    }
+}
+
+size_t TimedSynth::render(float* out, size_t n) {
+    return render_impl(out, NULL, n);
+}
+
+size_t TimedSynth::render_iq(float* out_i, float* out_q, size_t n) {
+    return render_impl(out_i, out_q, n);
+}
+
+size_t TimedSynth::render_impl(float* out_i, float* out_q, size_t n) {
+    n = std::min(n, total_ - pos_);
+    size_t got = out_q ? synth_.render_iq(out_i, out_q, n) : synth_.render(out_i, n);
+    // Past the synthesizer's end only the filter tail remains
+    std::fill(out_i + got, out_i + n, 0.0f);
+    delay_i_.process(out_i, n);
+    if (out_q) {
+        std::fill(out_q + got, out_q + n, 0.0f);
+        delay_q_.process(out_q, n);
+    }
+    pos_ += n;
+    return n;
+}
@@ -0,0 +1,58 @@
+// timing.h
+//
+// Clock and timing impairments of a WSPR transmission: a start offset
+// with any sub-sample fraction, linear and quadratic frequency drift, and
+// a sound card sample clock running off nominal by some ppm.
+//
+// The whole-sample part of the offset moves the synthesizer start, the
+// fraction goes through a polyphase fractional-delay filter, drift
+// retunes the NCO, and clock error renders at the true rate the card
+// would have sampled at, so the signal stretches in time and frequency
+// relative to the nominal rate in the file.
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include "fracdelay.h"
+#include "mfsk.h"
+
+struct TimingImpairment {
+    double dt;       // start offset from the nominal 1 s (s)
+    double drift;    // Hz per minute
+    double drift2;   // Hz per minute^2
+    double ppm;      // sample clock error, positive = card runs fast
+};
+
+const TimingImpairment NO_TIMING_IMPAIRMENT = {0.0, 0.0, 0.0, 0.0};
+
+// A WSPR transmission laid out as make_wspr_synth does, with impairments
+// applied. The output has the unimpaired length; anything moved past
+// either end is cut off, as a recording would. With no impairment the
+// output is identical to the plain synthesizer's.
+class TimedSynth {
+public:
+    // reference is the audio frequency at 0 Hz of the output: 0 for real
+    // audio, the audio center for complex baseband, so clock error scales
+    // audio frequencies even in baseband output
+    TimedSynth(const MfskMode& mode, const uint8_t* symbols, double sample_rate,
+               double center_freq, float amplitude, const TimingImpairment& timing,
+               double reference = 0.0);
+
+    size_t total_samples() const { return total_; }
+    // Render the next n samples; returns the number written, 0 when done
+    size_t render(float* out, size_t n);
+    size_t render_iq(float* out_i, float* out_q, size_t n);
+
+private:
+    size_t render_impl(float* out_i, float* out_q, size_t n);
+
+    MfskSynth synth_;
+    FractionalDelay delay_i_;
+    FractionalDelay delay_q_;
+    size_t total_;
+    size_t pos_;
+};
+
+#endif
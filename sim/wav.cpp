@@ -0,0 +1,208 @@
+// wav.cpp
+//
+// 16-bit mono PCM WAV output, and input of 16-bit PCM files.
+
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+#include "wav.h"
+
+void wav_header_init(WavHeader& header, int sample_rate, size_t num_samples) {
+    header.sample_rate = sample_rate;
+    header.byte_rate = sample_rate * 2;
+    header.subchunk2_size = num_samples * 2; // 16-bit samples
+    header.chunk_size = 36 + header.subchunk2_size;
+}
+
+void float_to_pcm16(const float* in, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        float s = in[i];
+        s = s < -1.0f ? -1.0f : (s > 1.0f ? 1.0f : s);
+        out[i] = static_cast<int16_t>(s * 32767);
+    }
+}
+
+bool write_wav_file(const char* filename, const float* samples, size_t n, int sample_rate) {
+    WavWriter wav;
+    if (!wav.open(filename, sample_rate)) return false;
+    wav.write(samples, n);
+    return wav.close();
+}
+
+static uint32_t le32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool read_wav_file(const char* filename, std::vector<float>& samples, int& sample_rate) {
+    WavReader wav;
+    if (!wav.open(filename)) return false;
+    sample_rate = wav.sample_rate();
+    samples.clear();
+    float buf[8192];
+    size_t n;
+    while ((n = wav.read(buf, 8192)) > 0) samples.insert(samples.end(), buf, buf + n);
+    return wav.ok();
+}
+
+WavReader::WavReader() : f_(NULL), sample_rate_(0), channels_(0), remaining_(0), ok_(false) {}
+
+WavReader::~WavReader() {
+    close();
+}
+
+// Discard n bytes; works on pipes too
+static bool skip_bytes(FILE* f, uint32_t n) {
+    unsigned char buf[4096];
+    while (n > 0) {
+        size_t want = n < sizeof(buf) ? n : sizeof(buf);
+        if (std::fread(buf, 1, want, f) != want) return false;
+        n -= (uint32_t)want;
+    }
+    return true;
+}
+
+bool WavReader::open(const char* filename) {
+    close();
+    bool use_stdin = std::strcmp(filename, "-") == 0;
+    f_ = use_stdin ? stdin : std::fopen(filename, "rb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot open WAV file %s\n", filename);
+        return false;
+    }
+    name_ = use_stdin ? "<stdin>" : filename;
+
+    unsigned char riff[12];
+    bool ok = std::fread(riff, 1, sizeof(riff), f_) == sizeof(riff) &&
+              memcmp(riff, "RIFF", 4) == 0 && memcmp(riff + 8, "WAVE", 4) == 0;
+
+    int bits = 0;
+    bool have_fmt = false, have_data = false;
+    while (ok && !have_data) {
+        unsigned char chunk[8];
+        if (std::fread(chunk, 1, sizeof(chunk), f_) != sizeof(chunk)) break;
+        uint32_t size = le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[16];
+            ok = std::fread(fmt, 1, sizeof(fmt), f_) == sizeof(fmt) &&
+                 skip_bytes(f_, size - 16 + (size & 1));
+            ok = ok && le16(fmt) == 1;   // PCM
+            channels_ = le16(fmt + 2);
+            sample_rate_ = (int)le32(fmt + 4);
+            bits = le16(fmt + 14);
+            have_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0 && have_fmt) {
+            ok = bits == 16 && channels_ > 0;
+            // An unfinished recording leaves the size at 0xffffffff: read to the end
+            remaining_ = ok ? size / 2 / channels_ : 0;
+            have_data = true;
+        } else {
+            ok = skip_bytes(f_, size + (size & 1));
+        }
+    }
+    ok_ = ok && have_data;
+    if (!ok_) {
+        std::fprintf(stderr, "Error: %s is not a 16-bit PCM WAV file\n", name_.c_str());
+        close();
+    }
+    return ok_;
+}
+
+size_t WavReader::read(float* samples, size_t n) {
+    if (!f_ || !ok_) return 0;
+    if (n > remaining_) n = remaining_;
+    const size_t CHUNK = 8192;
+    size_t frame = (size_t)channels_, got = 0;
+    if (pcm_.size() < CHUNK * frame) pcm_.resize(CHUNK * frame);
+    while (got < n) {
+        size_t want = std::min(CHUNK, n - got);
+        size_t frames = std::fread(pcm_.data(), 2 * frame, want, f_);
+        for (size_t k = 0; k < frames; k++) samples[got + k] = pcm_[k * frame] / 32768.0f;
+        got += frames;
+        remaining_ -= frames;
+        if (frames < want) {
+            if (std::ferror(f_)) {
+                std::fprintf(stderr, "Error: Failed reading WAV file %s\n", name_.c_str());
+                ok_ = false;
+            }
+            remaining_ = 0;
+            break;
+        }
+    }
+    return got;
+}
+
+void WavReader::close() {
+    if (f_ && f_ != stdin) std::fclose(f_);
+    f_ = NULL;
+}
+
+WavWriter::WavWriter()
+    : f_(NULL), sample_rate_(0), count_(0), ok_(false), seekable_(false), raw_(false) {}
+
+WavWriter::~WavWriter() {
+    if (f_) close();
+}
+
+bool WavWriter::open(const char* filename, int sample_rate) {
+    if (f_) close();
+    raw_ = std::strncmp(filename, "raw:", 4) == 0;
+    if (raw_) filename += 4;
+    bool use_stdout = std::strcmp(filename, "-") == 0;
+    f_ = use_stdout ? stdout : std::fopen(filename, "wb");
+    if (!f_) {
+        std::fprintf(stderr, "Error: Cannot create WAV file %s\n", filename);
+        return false;
+    }
+    name_ = use_stdout ? "<stdout>" : filename;
+    sample_rate_ = sample_rate;
+    count_ = 0;
+    struct stat st;
+    seekable_ = fstat(fileno(f_), &st) == 0 && (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode));
+    ok_ = true;
+    if (!raw_) {
+        // Placeholder header, sizes are rewritten on close; a stream keeps
+        // the unknown-length sizes
+        WavHeader header;
+        wav_header_init(header, sample_rate, 0);
+        if (!seekable_) header.chunk_size = header.subchunk2_size = 0xffffffff;
+        ok_ = std::fwrite(&header, sizeof(header), 1, f_) == 1;
+    }
+    io_.start(f_);
+    return ok_;
+}
+
+bool WavWriter::write(const float* samples, size_t n) {
+    // Convert in chunks so the int16 copy stays in cache
+    const size_t CHUNK = 16384;
+    if (pcm_.size() < CHUNK) pcm_.resize(CHUNK);
+    for (size_t pos = 0; ok_ && pos < n; pos += CHUNK) {
+        size_t count = n - pos < CHUNK ? n - pos : CHUNK;
+        float_to_pcm16(samples + pos, pcm_.data(), count);
+        ok_ = io_.write(pcm_.data(), count * sizeof(int16_t));
+        count_ += count;
+    }
+    return ok_;
+}
+
+bool WavWriter::close() {
+    if (!f_) return false;
+    if (!io_.finish()) ok_ = false;
+    if (ok_ && !raw_ && seekable_) {
+        WavHeader header;
+        wav_header_init(header, sample_rate_, count_);
+        ok_ = std::fseek(f_, 0, SEEK_SET) == 0 &&
+              std::fwrite(&header, sizeof(header), 1, f_) == 1;
+    }
+    if (f_ == stdout) {
+        if (std::fflush(f_) != 0) ok_ = false;
+    } else if (std::fclose(f_) != 0) {
+        ok_ = false;
+    }
+    f_ = NULL;
+    if (!ok_) std::fprintf(stderr, "Error: Failed writing WAV file %s\n", name_.c_str());
+    return ok_;
+}
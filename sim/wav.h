@@ -0,0 +1,111 @@
+// wav.h
+//
+// 16-bit mono PCM WAV output, and input of 16-bit PCM files.
+
+#ifndef WAV_H
+#define WAV_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "async_writer.h"
+
+// WAV file header structure
+struct WavHeader {
+    char     riff[4] = {'R', 'I', 'F', 'F'};
+    uint32_t chunk_size;
+    char     wave[4] = {'W', 'A', 'V', 'E'};
+    char     fmt[4] = {'f', 'm', 't', ' '};
+    uint32_t subchunk1_size = 16;
+    uint16_t audio_format = 1;  // PCM
+    uint16_t num_channels = 1;  // mono
+    uint32_t sample_rate;
+    uint32_t byte_rate;         // 16-bit samples
+    uint16_t block_align = 2;
+    uint16_t bits_per_sample = 16;
+    char     data[4] = {'d', 'a', 't', 'a'};
+    uint32_t subchunk2_size;
+};
+
+// Fill a header for num_samples mono 16-bit samples
+void wav_header_init(WavHeader& header, int sample_rate, size_t num_samples);
+
+// Clamp to [-1.0, 1.0] and convert to 16-bit
+void float_to_pcm16(const float* in, int16_t* out, size_t n);
+
+// Write samples in [-1, 1] as a 16-bit mono WAV file. Returns false on I/O error.
+bool write_wav_file(const char* filename, const float* samples, size_t n, int sample_rate);
+
+// Read a 16-bit PCM WAV file (the first channel if there are several) as
+// samples in [-1, 1]. Chunks other than fmt and data are skipped.
+// Returns false, with a message on stderr, for anything else.
+bool read_wav_file(const char* filename, std::vector<float>& samples, int& sample_rate);
+
+// Streaming WAV reader for the same files: the header is parsed by open()
+// and samples of the first channel come back block by block. "-" reads
+// stdin, so chunks are skipped by reading rather than seeking.
+class WavReader {
+public:
+    WavReader();
+    ~WavReader();
+
+    bool open(const char* filename);
+    // Up to n samples in [-1, 1]; 0 at the end of the data or on error
+    size_t read(float* samples, size_t n);
+    void close();
+
+    int sample_rate() const { return sample_rate_; }
+    int channels() const { return channels_; }
+    bool ok() const { return ok_; }
+
+private:
+    WavReader(const WavReader&);
+    WavReader& operator=(const WavReader&);
+
+    FILE* f_;
+    std::string name_;
+    int sample_rate_;
+    int channels_;
+    size_t remaining_;      // frames left in the data chunk
+    bool ok_;
+    std::vector<int16_t> pcm_;
+};
+
+// Streaming WAV writer: samples are converted block by block and written
+// by an I/O thread (AsyncWriter) while the caller renders the next ones,
+// and the header sizes are filled in by close().
+//
+// "-" writes to stdout. Where the output cannot seek (stdout, a named
+// pipe or a socket) the header goes out with the sizes at 0xffffffff,
+// the streaming convention sox, aplay and WavReader read to the end of.
+// A "raw:" prefix, e.g. "raw:-", writes bare 16-bit little endian PCM
+// without a header.
+class WavWriter {
+public:
+    WavWriter();
+    ~WavWriter();
+
+    bool open(const char* filename, int sample_rate);
+    bool write(const float* samples, size_t n);
+    bool close();
+
+    size_t samples() const { return count_; }
+
+private:
+    WavWriter(const WavWriter&);
+    WavWriter& operator=(const WavWriter&);
+
+    FILE* f_;
+    std::string name_;
+    int sample_rate_;
+    size_t count_;
+    bool ok_;
+    bool seekable_;
+    bool raw_;
+    std::vector<int16_t> pcm_;
+    AsyncWriter io_;
+};
+
+#endif
@@ -0,0 +1,204 @@
+// wspr_demod.cpp
+//
+// WSPR soft-symbol demodulation.
+
+#include <algorithm>
+#include <cmath>
+#include "wspr_demod.h"
+#include "wspr_sync.h"
+
+// wsprd's soft symbol scale: rms of the data metrics
+static const double SOFT_RMS = 50.0;
+// Candidates closer than this many tone spacings (and 0.5 s) to a
+// stronger one are its aliases
+static const double ALIAS_TONES = 2.2;
+// Independent accumulators in the per-symbol loops
+static const int LANES = 8;
+
+void wspr_deinterleave(const uint8_t* channel, uint8_t* code) {
+    // Code bit i went to the i-th bit-reversed 8-bit index below 162
+    int i = 0;
+    for (int j = 0; j < 256 && i < WSPR_SYMBOL_COUNT; j++) {
+        int rev = 0;
+        for (int b = 0; b < 8; b++) rev |= ((j >> b) & 1) << (7 - b);
+        if (rev < WSPR_SYMBOL_COUNT) code[i++] = channel[rev];
+    }
+}
+
+WsprDemod::WsprDemod(const float* in_i, const float* in_q, size_t n, double sample_rate, bool altered)
+    : in_i_(in_i), in_q_(in_q), n_(n), rate_(sample_rate), altered_(altered),
+      tone_re_(4 * SYNC_SYMBOL), tone_im_(4 * SYNC_SYMBOL) {
+    for (int j = 0; j < 4; j++) {
+        for (int t = 0; t < SYNC_SYMBOL; t++) {
+            double phase = -2.0 * M_PI * j * t / SYNC_SYMBOL;
+            tone_re_[j * SYNC_SYMBOL + t] = (float)std::cos(phase);
+            tone_im_[j * SYNC_SYMBOL + t] = (float)std::sin(phase);
+        }
+    }
+}
+
+std::vector<WsprCandidate> WsprDemod::candidates(const SyncSearch& search, double min_sync,
+                                                 size_t max) const {
+    double spacing = rate_ / SYNC_SYMBOL;
+    std::vector<SyncPeak> peaks = search.peaks(altered_, 4 * max + 16);
+    std::vector<WsprCandidate> out;
+    for (size_t k = 0; k < peaks.size() && out.size() < max; k++) {
+        if (peaks[k].metric < min_sync) break;
+        bool alias = false;
+        for (size_t c = 0; c < out.size() && !alias; c++) {
+            alias = std::fabs(peaks[k].freq - out[c].freq) < ALIAS_TONES * spacing &&
+                    std::fabs(peaks[k].dt - out[c].dt) < 0.5;
+        }
+        if (alias) continue;
+        WsprCandidate c;
+        c.dt = peaks[k].dt;
+        c.freq = peaks[k].freq;
+        c.drift = 0.0;
+        c.sync = peaks[k].metric;
+        std::fill(c.soft, c.soft + WSPR_SYMBOL_COUNT, 128);
+        out.push_back(c);
+    }
+    return out;
+}
+
+// Tone powers of every symbol (4 per symbol) for a signal whose symbol 0
+// starts at sample start, and the sync metric against the chosen vector
+double WsprDemod::sync_metric(long start, double freq, double drift, float* power) const {
+    double spacing = rate_ / SYNC_SYMBOL;
+    double half = WSPR_SYMBOL_COUNT / 2;
+    float wr[SYNC_SYMBOL], wi[SYNC_SYMBOL];
+    float edge_re[SYNC_SYMBOL], edge_im[SYNC_SYMBOL];
+    double num = 0.0, den = 0.0;
+
+    for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+        // Mix tone 0 of this symbol down to 0 Hz; tone j is then bin j.
+        // The mixer runs as LANES interleaved rotations (32 steps each),
+        // so it vectorizes and float precision is plenty.
+        double f = freq + drift / 2.0 * (k - half) / half - 1.5 * spacing;
+        double step = -2.0 * M_PI * f / rate_;
+        double s_re = std::cos(step), s_im = std::sin(step);
+        double p_re = 1.0, p_im = 0.0;
+        float c_re[LANES], c_im[LANES];
+        for (int l = 0; l < LANES; l++) {
+            c_re[l] = (float)p_re;
+            c_im[l] = (float)p_im;
+            double r = p_re * s_re - p_im * s_im;
+            p_im = p_re * s_im + p_im * s_re;
+            p_re = r;
+        }
+        float rot_re = (float)p_re, rot_im = (float)p_im;
+
+        long first = start + (long)k * SYNC_SYMBOL;
+        const float* x_re = in_i_ + first;
+        const float* x_im = in_q_ + first;
+        if (first < 0 || first + SYNC_SYMBOL > (long)n_) {
+            // Symbol runs off the recording: zeros outside
+            for (int t = 0; t < SYNC_SYMBOL; t++) {
+                long idx = first + t;
+                bool valid = idx >= 0 && idx < (long)n_;
+                edge_re[t] = valid ? in_i_[idx] : 0.0f;
+                edge_im[t] = valid ? in_q_[idx] : 0.0f;
+            }
+            x_re = edge_re;
+            x_im = edge_im;
+        }
+        for (int t = 0; t < SYNC_SYMBOL; t += LANES) {
+            for (int l = 0; l < LANES; l++) {
+                wr[t + l] = x_re[t + l] * c_re[l] - x_im[t + l] * c_im[l];
+                wi[t + l] = x_re[t + l] * c_im[l] + x_im[t + l] * c_re[l];
+                float r = c_re[l] * rot_re - c_im[l] * rot_im;
+                c_im[l] = c_re[l] * rot_im + c_im[l] * rot_re;
+                c_re[l] = r;
+            }
+        }
+
+        float* p = power + 4 * k;
+        for (int j = 0; j < 4; j++) {
+            const float* tr = &tone_re_[j * SYNC_SYMBOL];
+            const float* ti = &tone_im_[j * SYNC_SYMBOL];
+            float sr[LANES] = {0.0f}, si[LANES] = {0.0f};
+            for (int t = 0; t < SYNC_SYMBOL; t += LANES) {
+                for (int l = 0; l < LANES; l++) {
+                    sr[l] += wr[t + l] * tr[t + l] - wi[t + l] * ti[t + l];
+                    si[l] += wr[t + l] * ti[t + l] + wi[t + l] * tr[t + l];
+                }
+            }
+            float re = 0.0f, im = 0.0f;
+            for (int l = 0; l < LANES; l++) {
+                re += sr[l];
+                im += si[l];
+            }
+            p[j] = re * re + im * im;
+        }
+        double sign = wspr_sync_bit(k, altered_) ? 1.0 : -1.0;
+        num += sign * ((p[1] + p[3]) - (p[0] + p[2]));
+        den += p[0] + p[1] + p[2] + p[3];
+    }
+    return den > 0.0 ? num / den : 0.0;
+}
+
+void WsprDemod::refine(WsprCandidate& c) const {
+    std::vector<float> power(4 * WSPR_SYMBOL_COUNT);
+    long start = std::lround((1.0 + c.dt) * rate_);
+    double freq = c.freq, drift = c.drift;
+    double best = sync_metric(start, freq, drift, power.data());
+
+    // Coarse to fine sweeps of one parameter at a time, starting from the
+    // coarse grid's 1/16 symbol in DT and half a tone spacing in frequency
+    double spacing = rate_ / SYNC_SYMBOL;
+    struct Sweep { int param; double range; double step; };
+    const Sweep sweeps[] = {
+        {2, 4.0, 1.0},                       // drift, Hz
+        {1, 0.5 * spacing, spacing / 8},     // frequency
+        {0, 16.0, 4.0},                      // start, samples
+        {0, 3.0, 1.0},
+        {2, 0.5, 0.25},
+        {1, spacing / 16, spacing / 64},
+    };
+    for (size_t s = 0; s < sizeof(sweeps) / sizeof(sweeps[0]); s++) {
+        const Sweep& sw = sweeps[s];
+        long best_start = start;
+        double best_freq = freq, best_drift = drift;
+        int steps = (int)std::lround(sw.range / sw.step);
+        for (int i = -steps; i <= steps; i++) {
+            if (i == 0) continue;
+            long st = start;
+            double f = freq, d = drift;
+            if (sw.param == 0) st += i;
+            else if (sw.param == 1) f += i * sw.step;
+            else d += i * sw.step;
+            double m = sync_metric(st, f, d, power.data());
+            if (m > best) {
+                best = m;
+                best_start = st;
+                best_freq = f;
+                best_drift = d;
+            }
+        }
+        start = best_start;
+        freq = best_freq;
+        drift = best_drift;
+    }
+
+    c.dt = start / rate_ - 1.0;
+    c.freq = freq;
+    c.drift = drift;
+    c.sync = sync_metric(start, freq, drift, power.data());
+
+    // Data bit metrics from tone amplitudes, normalized to wsprd's scale
+    double metric[WSPR_SYMBOL_COUNT], sum2 = 0.0;
+    for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+        const float* p = &power[4 * k];
+        int s = wspr_sync_bit(k, altered_);
+        metric[k] = std::sqrt((double)p[2 + s]) - std::sqrt((double)p[s]);
+        sum2 += metric[k] * metric[k];
+    }
+    double rms = std::sqrt(sum2 / WSPR_SYMBOL_COUNT);
+    uint8_t channel[WSPR_SYMBOL_COUNT];
+    for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+        double v = rms > 0.0 ? SOFT_RMS * metric[k] / rms : 0.0;
+        v = std::max(-127.0, std::min(127.0, std::floor(v + 0.5)));
+        channel[k] = (uint8_t)(128 + (int)v);
+    }
+    wspr_deinterleave(channel, c.soft);
+}
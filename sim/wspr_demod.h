@@ -0,0 +1,60 @@
+// wspr_demod.h
+//
+// WSPR soft-symbol demodulation of complex baseband: candidates from the
+// coarse sync search, refined in DT, frequency and drift against the
+// chosen sync vector, then one soft metric per data bit.
+//
+// Soft symbols follow wsprd: for symbol k with sync bit s the data metric
+// is sqrt(p[2 + s]) - sqrt(p[s]) over the tone powers p, scaled so the
+// rms is 50 and offset to 0..255, where 128 carries no information and
+// larger values favour a 1. They are deinterleaved into the order the
+// convolutional code produced them, ready for a Fano or Viterbi decoder.
+
+#ifndef WSPR_DEMOD_H
+#define WSPR_DEMOD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "JTEncode.h"
+#include "sync_search.h"
+
+struct WsprCandidate {
+    double dt;       // s, 0 = symbols starting 1 s into the recording
+    double freq;     // Hz from baseband 0 Hz to the signal center
+    double drift;    // total frequency change over the transmission (Hz)
+    double sync;     // sync metric, 1 for a clean signal
+    uint8_t soft[WSPR_SYMBOL_COUNT];   // code order
+};
+
+// Undo JTEncode's bit-reversal interleaving: channel order to code order
+void wspr_deinterleave(const uint8_t* channel, uint8_t* code);
+
+class WsprDemod {
+public:
+    // Complex baseband at 375 or 375/8 sps; altered selects the inverted
+    // sync vector
+    WsprDemod(const float* in_i, const float* in_q, size_t n, double sample_rate, bool altered);
+
+    // Peaks of the coarse search above min_sync, strongest first, at most
+    // max, dropping the one-tone aliases of stronger candidates
+    std::vector<WsprCandidate> candidates(const SyncSearch& search, double min_sync, size_t max) const;
+
+    // Refine DT, frequency and drift by coordinate search on the sync
+    // metric, then fill in the soft symbols. Candidates are independent,
+    // so they can be refined on different threads.
+    void refine(WsprCandidate& c) const;
+
+private:
+    double sync_metric(long start, double freq, double drift, float* power) const;
+
+    const float* in_i_;
+    const float* in_q_;
+    size_t n_;
+    double rate_;
+    bool altered_;
+    std::vector<float> tone_re_;   // e^{-2 pi i j n / 256}, tones j = 0..3
+    std::vector<float> tone_im_;
+};
+
+#endif
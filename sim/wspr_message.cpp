@@ -0,0 +1,171 @@
+// wspr_message.cpp
+//
+// WSPR message unpacking, after wsprd's unpk_.
+
+#include <cctype>
+#include <cstring>
+#include "wspr_message.h"
+
+// 37 x 36 x 10 x 27 x 27 x 27 callsigns
+static const uint32_t CALL_LIMIT = 262177560;
+// 180 x 180 four-character grids
+static const uint32_t GRID_LIMIT = 32400;
+
+static char alnum(uint32_t code) {
+    return code < 10 ? (char)('0' + code) : code < 36 ? (char)('A' + code - 10) : ' ';
+}
+
+// The six padded characters of a packed callsign
+static bool unpack_call_chars(uint32_t n, char* c) {
+    if (n >= CALL_LIMIT) return false;
+    for (int k = 5; k >= 3; k--) {
+        c[k] = alnum(n % 27 + 10);
+        n /= 27;
+    }
+    c[2] = alnum(n % 10);
+    n /= 10;
+    c[1] = alnum(n % 36);
+    c[0] = alnum(n / 36);
+    return true;
+}
+
+// Spaces only as padding before or after, and something in between
+static bool trim_call(const char* c, std::string& call) {
+    int first = 0, last = 5;
+    while (first <= last && c[first] == ' ') first++;
+    while (last >= first && c[last] == ' ') last--;
+    if (first > last) return false;
+    call.assign(c + first, last - first + 1);
+    return call.find(' ') == std::string::npos;
+}
+
+// The powers a packed message carries: 0 to 60 dBm ending in 0, 3 or 7
+static bool unpacked_dbm(int dbm) {
+    int unit = dbm % 10;
+    return dbm >= 0 && dbm <= 60 && (unit == 0 || unit == 3 || unit == 7);
+}
+
+static bool is_letter(char c, char last) {
+    return c >= 'A' && c <= last;
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+std::string WsprMessage::text() const {
+    std::string s = call;
+    if (!grid.empty()) s += " " + grid;
+    return s + " " + std::to_string(dbm);
+}
+
+bool wspr_unpack(const uint8_t* data, WsprMessage& msg) {
+    uint32_t n = (uint32_t)data[0] << 20 | (uint32_t)data[1] << 12 | (uint32_t)data[2] << 4 | data[3] >> 4;
+    uint32_t m = (uint32_t)(data[3] & 0x0f) << 18 | (uint32_t)data[4] << 10 | (uint32_t)data[5] << 2 | data[6] >> 6;
+    if (n == 0 && m == 0) return false;
+    int ntype = (int)(m & 127) - 64;
+    uint32_t ngrid = m >> 7;
+
+    char c[6];
+    if (!unpack_call_chars(n, c)) return false;
+    msg.grid.clear();
+
+    if (ntype < 0) {
+        // Type 3: the six-character grid, rotated one place, in the call field
+        msg.type = 3;
+        msg.call = "<...>";
+        msg.grid.assign(1, c[5]);
+        msg.grid.append(c, 5);
+        msg.dbm = -(ntype + 1);
+        const std::string& g = msg.grid;
+        return is_letter(g[0], 'R') && is_letter(g[1], 'R') && is_digit(g[2]) && is_digit(g[3]) &&
+               is_letter(g[4], 'X') && is_letter(g[5], 'X') && unpacked_dbm(msg.dbm);
+    }
+    if (ntype > 62 || !trim_call(c, msg.call)) return false;
+
+    int unit = ntype % 10;
+    if (unit == 0 || unit == 3 || unit == 7) {
+        // Type 1
+        if (ngrid >= GRID_LIMIT) return false;
+        uint32_t lon = 179 - ngrid / 180, lat = ngrid % 180;
+        char grid[4] = {(char)('A' + lon / 10), (char)('A' + lat / 10), (char)('0' + lon % 10),
+                        (char)('0' + lat % 10)};
+        msg.type = 1;
+        msg.grid.assign(grid, 4);
+        msg.dbm = ntype;
+        return unpacked_dbm(msg.dbm);
+    }
+
+    // Type 2: a prefix or suffix in place of the grid, flagged by adding
+    // 1 or 2 to the power
+    int add = unit > 7 ? unit - 7 : unit > 3 ? unit - 3 : unit;
+    uint32_t affix = ngrid + 32768 * (uint32_t)(add - 1);
+    msg.type = 2;
+    msg.dbm = ntype - add;
+    if (affix < 60000) {
+        if (affix >= 37 * 37 * 37) return false;
+        char p[6] = {' ', ' ', ' ', ' ', ' ', ' '};
+        for (int k = 2; k >= 0; k--) {
+            p[k] = alnum(affix % 37);
+            affix /= 37;
+        }
+        std::string prefix;
+        if (!trim_call(p, prefix)) return false;
+        msg.call = prefix + "/" + msg.call;
+    } else {
+        uint32_t code = affix - 60000;
+        if (code < 36) {
+            msg.call += "/" + std::string(1, alnum(code));
+        } else if (code <= 125) {
+            msg.call += "/" + std::to_string(code - 26);
+        } else {
+            return false;
+        }
+    }
+    return unpacked_dbm(msg.dbm);
+}
+
+bool wspr_valid_call(const char* call) {
+    size_t len = call ? std::strlen(call) : 0;
+    if (len == 0 || len > 12) return false;
+    bool has_letter = false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = call[i];
+        if (std::isalpha(c)) has_letter = true;
+        else if (!std::isdigit(c) && c != '/' && c != '<' && c != '>') return false;
+    }
+    return has_letter;
+}
+
+bool wspr_valid_grid(const char* grid) {
+    size_t len = grid ? std::strlen(grid) : 0;
+    if (len != 4 && len != 6) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)std::toupper((unsigned char)grid[i]);
+        bool ok = i < 2 ? is_letter(c, 'R') : i < 4 ? is_digit(c) : is_letter(c, 'X');
+        if (!ok) return false;
+    }
+    return true;
+}
+
+bool wspr_valid_dbm(int dbm) {
+    static const int LEVELS[] = {-30, -27, -23, -20, -17, -13, -10, -7, -3, 0, 3, 7, 10, 13,
+                                 17,  20,  23,  27,  30,  33,  37,  40, 43, 47, 50, 53, 57, 60};
+    for (size_t i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); i++) {
+        if (dbm == LEVELS[i]) return true;
+    }
+    return false;
+}
+
+std::string wspr_normalize_message(const char* text) {
+    std::string out;
+    for (const char* p = text; *p; p++) {
+        if (std::isspace((unsigned char)*p)) {
+            if (!out.empty() && out[out.size() - 1] != ' ') out += ' ';
+        } else {
+            out += (char)std::toupper((unsigned char)*p);
+        }
+    }
+    if (!out.empty() && out[out.size() - 1] == ' ') out.resize(out.size() - 1);
+    return out;
+}
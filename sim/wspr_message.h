@@ -0,0 +1,44 @@
+// wspr_message.h
+//
+// Unpacking of the 50 WSPR data bits that JTEncode::wspr_bit_packing
+// produces and a Fano decoder returns: a 28-bit callsign and a 22-bit
+// grid and power field, read back as wsprd does.
+//
+//   type 1   CALL GRID DBM            4-character grid, dBm 0, 3, 7 ... 60
+//   type 2   PFX/CALL or CALL/SFX     DBM only
+//   type 3   <CALL> GRID6 DBM         the call is a 15-bit hash, printed
+//                                     as <...>
+//
+// Anything else, including the all-zero frame a decoder can converge on
+// in noise, is rejected rather than printed as a message.
+
+#ifndef WSPR_MESSAGE_H
+#define WSPR_MESSAGE_H
+
+#include <cstdint>
+#include <string>
+
+struct WsprMessage {
+    int type;            // 1, 2 or 3
+    std::string call;    // "<...>" for type 3
+    std::string grid;    // empty for type 2
+    int dbm;
+
+    // "W1AW FN42 30", as decoders print it
+    std::string text() const;
+};
+
+// Unpack 50 data bits, MSB first; false for bits that are no valid message
+bool wspr_unpack(const uint8_t* data, WsprMessage& msg);
+
+// Upper case with single spaces, for comparing a message with text()
+std::string wspr_normalize_message(const char* text);
+
+// Checks on messages to encode, as wsprsim applies them: a call of up to
+// 12 letters, digits, '/', '<' and '>' with at least one letter, an AA00
+// or AA00AA grid, and one of WSPR's 28 power levels from -30 to 60 dBm
+bool wspr_valid_call(const char* call);
+bool wspr_valid_grid(const char* grid);
+bool wspr_valid_dbm(int dbm);
+
+#endif
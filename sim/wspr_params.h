@@ -0,0 +1,21 @@
+// wspr_params.h
+//
+// WSPR-2 audio timing shared by wsprsim and the other simulation tools.
+
+#ifndef WSPR_PARAMS_H
+#define WSPR_PARAMS_H
+
+#include "JTEncode.h"
+
+// Audio parameters (matching wsprsimwav.c)
+const int    SAMPLE_RATE   = 48000;             // 48kHz sampling rate
+const int    SYMBOL_LENGTH = 32768;             // samples per symbol
+const double CENTER_FREQ   = 1500.0;           // center frequency (Hz)
+const double FREQ_SPACING  = 48000.0 / 32768;  // = 1.46484375 Hz spacing
+const int    DELAY_SAMPLES = 48000;             // 1 second delay
+const int    SIGNAL_LENGTH = SYMBOL_LENGTH * WSPR_SYMBOL_COUNT;  // total samples
+const int    SLOPE_SAMPLES = 0.02 * SAMPLE_RATE;  // 20ms slope
+// Total samples: each symbol plus one-second delays at start/end
+const int    TOTAL_SAMPLES = SIGNAL_LENGTH + 2 * DELAY_SAMPLES;  // =162*32768 + 2*48000 = 5404416 samples
+
+#endif
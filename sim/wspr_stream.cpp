@@ -0,0 +1,82 @@
+// wspr_stream.cpp
+//
+// WSPR-2 and WSPR-15 transmissions rendered block by block.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "c2file.h"
+#include "wav.h"
+#include "wspr_params.h"
+#include "wspr_stream.h"
+
+static const size_t BLOCK = 16384;
+
+const MfskMode* wspr_mode(int type) {
+    if (type == 2) return find_mfsk_mode("WSPR");
+    if (type == 15) return find_mfsk_mode("WSPR15");
+    return NULL;
+}
+
+MfskSynth make_wspr_synth(const MfskMode& mode, const uint8_t* symbols,
+                          double sample_rate, double center_freq, float amplitude) {
+    MfskSynth synth(mode, symbols, WSPR_SYMBOL_COUNT, sample_rate,
+                    center_freq - 1.5 * mode.tone_spacing, amplitude);
+    size_t second = (size_t)llround(sample_rate);
+    synth.set_delay(second);
+    synth.set_tail(second);
+    synth.set_ramp((size_t)llround(0.02 * sample_rate));
+    return synth;
+}
+
+bool write_wspr_wav(int type, const uint8_t* symbols, const char* path,
+                    float amplitude, const NoiseStage* noise, FadingChannel* fading,
+                    const TimingImpairment* timing) {
+    const MfskMode* mode = wspr_mode(type);
+    if (!mode) return false;
+    TimedSynth synth(*mode, symbols, SAMPLE_RATE, CENTER_FREQ, amplitude,
+                     timing ? *timing : NO_TIMING_IMPAIRMENT);
+
+    WavWriter wav;
+    if (!wav.open(path, SAMPLE_RATE)) return false;
+    std::vector<float> block(BLOCK);
+    size_t n, pos = 0;
+    while ((n = synth.render(block.data(), block.size())) > 0) {
+        if (fading) fading->process(block.data(), n);
+        if (noise) noise->apply(block.data(), pos, n);
+        wav.write(block.data(), n);
+        pos += n;
+    }
+    return wav.close();
+}
+
+bool write_wspr_c2(int type, const uint8_t* symbols, const char* path, double dial_mhz,
+                   float amplitude, const NoiseStage* noise, FadingChannel* fading,
+                   const TimingImpairment* timing) {
+    const MfskMode* mode = wspr_mode(type);
+    if (!mode) return false;
+    TimedSynth synth(*mode, symbols, c2_sample_rate(type), 0.0, amplitude,
+                     timing ? *timing : NO_TIMING_IMPAIRMENT, CENTER_FREQ);
+
+    // The file is pre-sized and zero filled, so only rendered frames are stored
+    C2MapWriter c2;
+    if (!c2.open(path, type, dial_mhz)) return false;
+    std::vector<float> i(BLOCK), q(BLOCK);
+    size_t n, pos = 0;
+    while (pos < C2_FRAMES && (n = synth.render_iq(i.data(), q.data(), BLOCK)) > 0) {
+        if (fading) fading->process_iq(i.data(), q.data(), n);
+        if (noise) noise->apply_iq(i.data(), q.data(), pos, n);
+        c2.write(pos, i.data(), q.data(), n);
+        pos += n;
+    }
+    // Noise continues through the padding to the fixed file length
+    while (noise && pos < C2_FRAMES) {
+        n = std::min(BLOCK, C2_FRAMES - pos);
+        std::fill(i.begin(), i.begin() + n, 0.0f);
+        std::fill(q.begin(), q.begin() + n, 0.0f);
+        noise->apply_iq(i.data(), q.data(), pos, n);
+        c2.write(pos, i.data(), q.data(), n);
+        pos += n;
+    }
+    return c2.close();
+}
@@ -0,0 +1,36 @@
+// wspr_stream.h
+//
+// WSPR-2 and WSPR-15 transmissions rendered block by block, so memory use
+// does not grow with the transmission length (a WSPR-15 WAV is about 43M
+// samples at 48 kHz).
+
+#ifndef WSPR_STREAM_H
+#define WSPR_STREAM_H
+
+#include <cstdint>
+#include "fading.h"
+#include "mfsk.h"
+#include "noise.h"
+#include "timing.h"
+
+// Mode descriptor for a WSPR type (2 or 15), NULL for anything else
+const MfskMode* wspr_mode(int type);
+
+// Synthesizer for one transmission centered on center_freq, with one
+// second of silence before and after, as in the WSPR-2 WAV output
+MfskSynth make_wspr_synth(const MfskMode& mode, const uint8_t* symbols,
+                          double sample_rate, double center_freq, float amplitude);
+
+// Stream a transmission to a 16-bit WAV file at SAMPLE_RATE, optionally
+// with timing impairments, passing it through a fading channel and then
+// adding noise from the start of the file
+bool write_wspr_wav(int type, const uint8_t* symbols, const char* path,
+                    float amplitude = 0.5f, const NoiseStage* noise = NULL,
+                    FadingChannel* fading = NULL, const TimingImpairment* timing = NULL);
+
+// Stream a transmission to a .c2 file as baseband centered on 1500 Hz audio
+bool write_wspr_c2(int type, const uint8_t* symbols, const char* path, double dial_mhz,
+                   float amplitude = 1.0f, const NoiseStage* noise = NULL,
+                   FadingChannel* fading = NULL, const TimingImpairment* timing = NULL);
+
+#endif
@@ -0,0 +1,24 @@
+// wspr_sync.cpp
+//
+// The WSPR sync vector and the altered-sync variant.
+
+#include "wspr_sync.h"
+
+const uint8_t WSPR_SYNC_VECTOR[WSPR_SYMBOL_COUNT] = {
+    1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0,
+    1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0,
+    0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1,
+    0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0,
+    1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1,
+    0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
+    1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0
+};
+
+void make_altered_symbols(const uint8_t* normal, uint8_t* altered) {
+    for (int i = 0; i < WSPR_SYMBOL_COUNT; ++i) {
+      uint8_t d = (normal[i] >> 1) & 1;            // extract data bit
+      uint8_t s = WSPR_SYNC_VECTOR[i] ^ 1;         // invert sync bit
+      altered[i] = s + 2 * d;                      // rebuild symbol
+    }
+}
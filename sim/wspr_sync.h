@@ -0,0 +1,23 @@
+// wspr_sync.h
+//
+// The WSPR sync vector and the altered-sync variant used by this project:
+// every channel symbol is sync + 2 * data, and the altered variant inverts
+// the sync bit while keeping the data bit.
+
+#ifndef WSPR_SYNC_H
+#define WSPR_SYNC_H
+
+#include <cstdint>
+#include "JTEncode.h"
+
+extern const uint8_t WSPR_SYNC_VECTOR[WSPR_SYMBOL_COUNT];
+
+// Rebuild normal channel symbols with the sync bit inverted
+void make_altered_symbols(const uint8_t* normal, uint8_t* altered);
+
+// Sync bit of symbol i for the normal or altered variant
+inline uint8_t wspr_sync_bit(int i, bool altered) {
+    return WSPR_SYNC_VECTOR[i] ^ (altered ? 1 : 0);
+}
+
+#endif
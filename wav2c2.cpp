@@ -0,0 +1,97 @@
+// wav2c2.cpp
+//
+// WAV to wsprd .c2 downconverter: mixes a 12 or 48 kHz (or any rate)
+// real recording down about an audio center frequency and decimates it
+// to the .c2 rate, 375 sps for WSPR-2 (375/8 for WSPR-15), block by
+// block. A two minute 12 kHz record.sh WAV shrinks from 2.7 MB of audio
+// to a 360026 byte .c2 file that wsprd reads directly.
+//
+// Build:
+//   make wav2c2
+//
+// Usage:
+//   ./wav2c2 [-c CENTER] [-f DIAL_MHZ] [-t TYPE] [-n NAME] IN.wav|- OUT.c2
+//
+//   -c   audio frequency that becomes 0 Hz (default 1500)
+//   -f   dial frequency in MHz for the header (default 14.0956)
+//   -t   WSPR type for the header and rate, 2 or 15 (default 2)
+//   -n   file name for the header, 14 characters at most (default the
+//        base name of OUT.c2)
+//
+// "-" reads the WAV from stdin, e.g. straight from arecord. Output is
+// the fixed 45000 frames of the format: zero padded if the recording is
+// shorter, cut off (with a warning) if it is longer.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "sim/baseband.h"
+#include "sim/c2file.h"
+#include "sim/wav.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-c CENTER] [-f DIAL_MHZ] [-t TYPE] [-n NAME] IN.wav|- OUT.c2\n", prog);
+}
+
+int main(int argc, char** argv) {
+    double center = 1500.0;
+    double dial_mhz = 14.0956;
+    int type = 2;
+    const char* name = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:f:t:n:")) != -1) {
+        switch (opt) {
+        case 'c': center = std::atof(optarg); break;
+        case 'f': dial_mhz = std::atof(optarg); break;
+        case 't': type = std::atoi(optarg); break;
+        case 'n': name = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (type != 2 && type != 15) {
+        std::fprintf(stderr, "Error: WSPR type must be 2 or 15, got %d\n", type);
+        return 1;
+    }
+
+    WavReader in;
+    if (!in.open(argv[optind])) return 2;
+    int up, down;
+    if (!c2_ratio(in.sample_rate(), type, up, down)) return 1;
+    Downconverter dc(in.sample_rate(), center, up, down);
+
+    C2Writer out;
+    if (!out.open(argv[optind + 1], type, dial_mhz, name)) return 2;
+
+    const size_t BLOCK = 65536;
+    std::vector<float> block(BLOCK), bb_i, bb_q;
+    size_t n, total = 0, frames = 0;
+    bool ok = true;
+    while (ok && (n = in.read(block.data(), BLOCK)) > 0) {
+        total += n;
+        frames += dc.process(block.data(), n, bb_i, bb_q);
+        ok = out.write(bb_i.data(), bb_q.data(), bb_i.size());
+        bb_i.clear();
+        bb_q.clear();
+    }
+    if (!in.ok()) ok = false;
+    frames += dc.flush(bb_i, bb_q);
+    ok = out.write(bb_i.data(), bb_q.data(), bb_i.size()) && ok;
+    in.close();
+    if (!out.close() || !ok) return 2;
+
+    if (frames > C2_FRAMES) {
+        std::fprintf(stderr, "Warning: %zu of %zu frames beyond the %zu of a .c2 file dropped\n",
+                     frames - C2_FRAMES, frames, C2_FRAMES);
+    }
+    std::fprintf(stderr, "%s: %zu samples at %d Hz -> %s: %zu frames at %g sps about %g Hz (%.0fx)\n",
+                 argv[optind], total, in.sample_rate(), argv[optind + 1], frames < C2_FRAMES ? frames : C2_FRAMES,
+                 dc.out_rate(), center, (double)down / up);
+    return 0;
+}
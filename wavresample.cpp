@@ -0,0 +1,111 @@
+// wavresample.cpp
+//
+// Sample rate converter for 16-bit WAV files, in place of the
+// `sox IN.wav -r 12000 OUT.wav trim START LENGTH` step before wsprd in
+// the test_*_offsets.sh scripts. The input is streamed block by block
+// through the library's polyphase resampler, so recordings of any length
+// (or stdin) convert in constant memory.
+//
+// Build:
+//   make wavresample
+//
+// Usage:
+//   ./wavresample [-r RATE] [-t START:LENGTH] IN.wav|- OUT.wav
+//
+//   -r   output sample rate in Hz (default 12000); any rational ratio
+//   -t   keep LENGTH seconds from START seconds into the input, like
+//        sox trim; LENGTH 0 keeps the rest
+//
+// The output is aligned with the input (the filter delay is removed) and
+// has ceil(inputs * RATE / input rate) samples. The first channel of a
+// multi-channel file is used.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include "sim/resample.h"
+#include "sim/wav.h"
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-r RATE] [-t START:LENGTH] IN.wav|- OUT.wav\n", prog);
+}
+
+int main(int argc, char** argv) {
+    int out_rate = 12000;
+    double start = 0.0, length = 0.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:t:")) != -1) {
+        switch (opt) {
+        case 'r': out_rate = std::atoi(optarg); break;
+        case 't':
+            if (std::sscanf(optarg, "%lf:%lf", &start, &length) != 2 || start < 0.0 || length < 0.0) {
+                std::fprintf(stderr, "Error: -t expects START:LENGTH, got '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    WavReader in;
+    if (!in.open(argv[optind])) return 2;
+    int up, down;
+    if (!resample_ratio(in.sample_rate(), out_rate, up, down)) return 1;
+
+    // Input samples to skip and to keep (0 for all)
+    uint64_t skip = (uint64_t)(start * in.sample_rate() + 0.5);
+    uint64_t keep = (uint64_t)(length * in.sample_rate() + 0.5);
+    if (length > 0.0 && keep == 0) keep = 1;
+
+    WavWriter out;
+    if (!out.open(argv[optind + 1], out_rate)) return 2;
+
+    Resampler rs(up, down);
+    const size_t BLOCK = 65536;
+    std::vector<float> block(BLOCK), result;
+    uint64_t consumed = 0, taken = 0, written = 0, delayed = (uint64_t)rs.delay();
+    bool ok = true;
+
+    // Write what is past the filter delay, up to the expected length
+    auto emit = [&](uint64_t limit) {
+        size_t first = 0;
+        if (delayed > 0) {
+            first = (size_t)(delayed < result.size() ? delayed : result.size());
+            delayed -= first;
+        }
+        size_t n = result.size() - first;
+        if (written + n > limit) n = (size_t)(limit - written);
+        if (n > 0) ok = out.write(&result[first], n) && ok;
+        written += n;
+        result.clear();
+    };
+
+    size_t n;
+    while (ok && (keep == 0 || taken < keep) && (n = in.read(block.data(), BLOCK)) > 0) {
+        size_t from = 0;
+        if (consumed < skip) from = (size_t)(skip - consumed < n ? skip - consumed : n);
+        consumed += n;
+        size_t count = n - from;
+        if (keep > 0 && taken + count > keep) count = (size_t)(keep - taken);
+        taken += count;
+        rs.process(&block[from], count, result);
+        emit(~0ull);
+    }
+    if (!in.ok()) ok = false;
+    rs.flush(result);
+    emit(rs.expected_outputs());
+    in.close();
+
+    if (!out.close() || !ok) return 2;
+    std::fprintf(stderr, "%s: %llu samples at %d Hz -> %s: %llu samples at %d Hz\n", argv[optind],
+                 (unsigned long long)taken, in.sample_rate(), argv[optind + 1],
+                 (unsigned long long)written, out_rate);
+    return 0;
+}
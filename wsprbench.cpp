@@ -0,0 +1,513 @@
+// wsprbench.cpp
+//
+// Throughput benchmarks for the simulation library.
+//
+// Build:
+//   make wsprbench
+//
+// Usage:
+//   ./wsprbench synth [ITERATIONS]
+//   ./wsprbench ft8 [FRAMES]
+//   ./wsprbench noise [ITERATIONS]
+//   ./wsprbench fading [ITERATIONS]
+//   ./wsprbench fano [FRAMES]
+//   ./wsprbench ldpc [FRAMES]
+//   ./wsprbench resample [ITERATIONS]
+//
+// synth: renders the WSPR-2 WAV signal with the direct per-sample
+//        generator and with the tone-template cache, and compares both
+//        against a plain memcpy of the same output size.
+// ft8:   renders batches of 15 s FT8 GFSK frames at 12 and 48 kHz on
+//        one core and reports frames per second.
+// noise: counter-based Gaussian noise against std::normal_distribution,
+//        with the sample variance as a calibration check.
+// fading: two minutes of a 1500 Hz tone through each Watterson preset,
+//        real audio and complex baseband at 48 kHz, with the output power
+//        relative to the input (near 1 once the fading averages out).
+// fano:  round-trips wspr_encode and jt9_encode output through the Fano
+//        decoder, then decodes random WSPR frames with Gaussian soft
+//        symbols over a range of Eb/N0 on all cores, reporting the
+//        decoded fraction, cycles per bit, frames/s and the slowest frame.
+// ldpc:  recovers the codeword from ft8_encode tones and checks it
+//        against the library encoder and the decoder, then decodes random
+//        FT8 codewords with BPSK LLR noise over a range of Eb/N0 on all
+//        cores, reporting the decoded fraction, iterations and frames/s.
+// resample: the polyphase filter's measured passband ripple and stopband
+//        attenuation for common ratios, input samples/s converting two
+//        minutes of audio in 64k blocks, and the error of a resampled
+//        tone against the same tone generated at the output rate.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "src/JTEncode.h"
+#include "sim/fading.h"
+#include "sim/fano.h"
+#include "sim/ft8_synth.h"
+#include "sim/ldpc.h"
+#include "sim/noise.h"
+#include "sim/parallel.h"
+#include "sim/resample.h"
+#include "sim/wspr_params.h"
+#include "sim/synth.h"
+#include "sim/wspr_demod.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double seconds_since(bench_clock::time_point start) {
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+static int bench_synth(int iterations) {
+    uint8_t syms[WSPR_SYMBOL_COUNT];
+    JTEncode encoder;
+    encoder.wspr_encode("K1ABC", "FN42", 37, syms);
+
+    // Direct synthesis
+    std::vector<double> direct;
+    bench_clock::time_point t0 = bench_clock::now();
+    for (int i = 0; i < iterations; i++) generate_wav_signal(syms, direct);
+    double t_direct = seconds_since(t0) / iterations;
+
+    // Tone-template cache, including the one-time table setup
+    t0 = bench_clock::now();
+    ToneCache cache = make_wspr_tone_cache();
+    double t_setup = seconds_since(t0);
+
+    std::vector<float> cached;
+    t0 = bench_clock::now();
+    for (int i = 0; i < iterations; i++) render_wspr_signal(cache, syms, cached);
+    double t_cached = seconds_since(t0) / iterations;
+
+    // Memory bandwidth reference: copy a buffer of the same size
+    std::vector<float> copy(cached.size());
+    t0 = bench_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        memcpy(copy.data(), cached.data(), cached.size() * sizeof(float));
+    }
+    double t_copy = seconds_since(t0) / iterations;
+
+    double max_err = 0.0;
+    for (size_t i = 0; i < cached.size(); i++) {
+        max_err = std::max(max_err, std::fabs(direct[i] - cached[i]));
+    }
+
+    double msamples = TOTAL_SAMPLES / 1e6;
+    std::printf("WSPR-2 synthesis, %d samples, %d iterations\n", TOTAL_SAMPLES, iterations);
+    std::printf("  direct       %8.2f ms  %8.1f Msamples/s\n", t_direct * 1e3, msamples / t_direct);
+    std::printf("  tone cache   %8.2f ms  %8.1f Msamples/s  (setup %.2f ms)\n",
+                t_cached * 1e3, msamples / t_cached, t_setup * 1e3);
+    std::printf("  memcpy       %8.2f ms  %8.1f Msamples/s\n", t_copy * 1e3, msamples / t_copy);
+    std::printf("  speedup %.1fx, %.1fx of memcpy time, max |error| %.2e\n",
+                t_direct / t_cached, t_cached / t_copy, max_err);
+    return max_err < 1e-5 ? 0 : 1;
+}
+
+static int bench_ft8(int frames) {
+    // A batch of distinct messages at spread out audio frequencies
+    const int BATCH = 16;
+    std::vector<uint8_t> tones(BATCH * FT8_SYMBOL_COUNT);
+    std::vector<double> f0(BATCH);
+    JTEncode encoder;
+    for (int i = 0; i < BATCH; i++) {
+        char msg[14];
+        std::snprintf(msg, sizeof(msg), "K1ABC W%dXY", i % 10);
+        encoder.ft8_encode(msg, &tones[i * FT8_SYMBOL_COUNT]);
+        f0[i] = 500.0 + 100.0 * i;
+    }
+
+    const int rates[] = {12000, 48000};
+    for (int r = 0; r < 2; r++) {
+        bench_clock::time_point t0 = bench_clock::now();
+        Ft8Synth synth(rates[r]);
+        double t_setup = seconds_since(t0);
+
+        std::vector<float> out(BATCH * synth.frame_samples());
+        int done = 0;
+        t0 = bench_clock::now();
+        while (done < frames) {
+            int n = frames - done < BATCH ? frames - done : BATCH;
+            synth.render_batch(tones.data(), f0.data(), n, FT8_START_TIME, 0.5f, out.data());
+            done += n;
+        }
+        double t = seconds_since(t0);
+
+        std::printf("FT8 GFSK at %5d Hz: %d frames in %7.1f ms  %8.1f frames/s  %7.1f Msamples/s  (tables %.2f ms)\n",
+                    rates[r], frames, t * 1e3, frames / t,
+                    frames * (double)synth.frame_samples() / t / 1e6, t_setup * 1e3);
+    }
+    return 0;
+}
+
+static int bench_noise(int iterations) {
+    const size_t N = 1 << 20;
+    std::vector<float> buf(N);
+
+    // Reference: the standard library generator
+    std::mt19937_64 rng(1);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    bench_clock::time_point t0 = bench_clock::now();
+    for (size_t i = 0; i < N; i++) buf[i] = dist(rng);
+    double t_std = seconds_since(t0);
+
+    GaussianNoise noise(1);
+    t0 = bench_clock::now();
+    for (int i = 0; i < iterations; i++) noise.fill(buf.data(), N, 1.0f);
+    double t_fill = seconds_since(t0) / iterations;
+
+    t0 = bench_clock::now();
+    for (int i = 0; i < iterations; i++) noise.add(buf.data(), N, 0.1f);
+    double t_add = seconds_since(t0) / iterations;
+
+    noise.fill_at(0, buf.data(), N, 1.0f);
+    double mean = 0.0, var = 0.0;
+    for (size_t i = 0; i < N; i++) mean += buf[i];
+    mean /= N;
+    for (size_t i = 0; i < N; i++) var += (buf[i] - mean) * (buf[i] - mean);
+    var /= N;
+
+    double ms = N / 1e6;
+    std::printf("Gaussian noise, %zu samples, %d iterations\n", N, iterations);
+    std::printf("  normal_distribution %8.1f Msamples/s\n", ms / t_std);
+    std::printf("  counter fill        %8.1f Msamples/s\n", ms / t_fill);
+    std::printf("  counter add         %8.1f Msamples/s\n", ms / t_add);
+    std::printf("  mean %+.5f, variance %.5f\n", mean, var);
+    return std::fabs(var - 1.0) < 0.01 ? 0 : 1;
+}
+
+static int bench_fading(int iterations) {
+    const double fs = SAMPLE_RATE;
+    const size_t N = (size_t)(120 * fs);
+    std::vector<float> tone_i(N), tone_q(N), buf_i(N), buf_q(N);
+    for (size_t i = 0; i < N; i++) {
+        double phase = 2.0 * M_PI * 1500.0 * i / fs;
+        tone_i[i] = (float)std::cos(phase);
+        tone_q[i] = (float)std::sin(phase);
+    }
+
+    const char* presets[] = {"good", "moderate", "poor", "flutter", "high-disturbed"};
+    std::printf("Watterson fading, %zu samples (120 s at %.0f Hz), %d iterations\n", N, fs, iterations);
+    std::printf("  %-15s %10s %10s %10s\n", "preset", "real Ms/s", "iq Ms/s", "power");
+    for (size_t p = 0; p < sizeof(presets) / sizeof(presets[0]); p++) {
+        std::vector<FadingTap> taps;
+        parse_fading_taps(presets[p], taps);
+
+        double t_real = 0.0, t_iq = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            buf_i = tone_i;
+            FadingChannel real(taps, fs, it + 1);
+            bench_clock::time_point t0 = bench_clock::now();
+            real.process(buf_i.data(), N);
+            t_real += seconds_since(t0);
+
+            buf_i = tone_i;
+            buf_q = tone_q;
+            FadingChannel iq(taps, fs, it + 1);
+            t0 = bench_clock::now();
+            iq.process_iq(buf_i.data(), buf_q.data(), N);
+            t_iq += seconds_since(t0);
+        }
+
+        // Mean |gain|^2 from the last complex run; the tone has unit power
+        double power = 0.0;
+        for (size_t i = 0; i < N; i++) power += buf_i[i] * buf_i[i] + buf_q[i] * buf_q[i];
+        power /= N;
+
+        double ms = N / 1e6 * iterations;
+        std::printf("  %-15s %10.1f %10.1f %10.3f\n", presets[p], ms / t_real, ms / t_iq, power);
+    }
+    return 0;
+}
+
+// Hard soft symbols: 0 -> 78, 1 -> 178
+static void hard_soft(const uint8_t* code, int n, uint8_t* soft) {
+    for (int i = 0; i < n; i++) soft[i] = code[i] ? 178 : 78;
+}
+
+// Decode noiseless code bits and check that the data re-encodes to them
+static bool fano_round_trip(const FanoDecoder& fano, const char* name, const uint8_t* code, int nbits) {
+    int n = conv_code_bits(nbits);
+    std::vector<uint8_t> soft(n), again(n);
+    hard_soft(code, n, soft.data());
+    FanoResult r = fano.decode(soft.data(), nbits);
+    if (r.status == FANO_OK) conv_encode(r.data, nbits, again.data());
+    bool ok = r.status == FANO_OK && std::memcmp(code, again.data(), n) == 0;
+    std::printf("  %-5s round trip %s (%ld cycles)\n", name, ok ? "ok" : "FAILED", r.cycles);
+    return ok;
+}
+
+static int bench_fano(int frames) {
+    FanoDecoder fano;
+    JTEncode encoder;
+    std::printf("Fano decoder, K=32 r=1/2, delta %d, %ld cycles/bit\n",
+                fano.config().delta, fano.config().max_cycles);
+
+    // WSPR: data bits of the channel symbols, deinterleaved
+    uint8_t syms[JT9_BIT_COUNT], channel[JT9_BIT_COUNT], code[JT9_BIT_COUNT];
+    encoder.wspr_encode("K1ABC", "FN42", 37, syms);
+    for (int i = 0; i < WSPR_SYMBOL_COUNT; i++) channel[i] = syms[i] >> 1;
+    wspr_deinterleave(channel, code);
+    bool ok = fano_round_trip(fano, "WSPR", code, 50);
+
+    // JT9: undo the sync merge, Gray code, 3-bit packing and interleaving
+    encoder.jt9_encode("K1ABC FN42", syms);
+    int k = 0;
+    for (int i = 0; i < JT9_SYMBOL_COUNT; i++) {
+        if (syms[i] == 0) continue;
+        uint8_t g = syms[i] - 1, a = g;
+        for (uint8_t s = g >> 1; s; s >>= 1) a ^= s;
+        for (int b = 2; b >= 0; b--) channel[k++] = (a >> b) & 1;
+    }
+    for (int i = 0; i < JT9_BIT_COUNT; i++) code[i] = channel[jt9i[i]];
+    ok = fano_round_trip(fano, "JT9", code, 72) && ok;
+
+    // Random WSPR frames, antipodal code bits in Gaussian noise scaled to
+    // the soft symbol format
+    const int NBITS = 50;
+    const int N = conv_code_bits(NBITS);
+    const double ebn0s[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 8.0};
+    int threads = default_thread_count();
+    std::vector<uint8_t> soft((size_t)frames * N);
+    std::vector<uint8_t> data((size_t)frames * FANO_MAX_DATA_BITS / 8);
+    std::printf("  %d WSPR frames per point, %d threads\n", frames, threads);
+    std::printf("  %7s %9s %7s %12s %10s %11s\n", "Eb/N0", "decoded", "wrong", "cycles/bit", "frames/s", "slowest ms");
+    for (size_t p = 0; p < sizeof(ebn0s) / sizeof(ebn0s[0]); p++) {
+        double esn0 = std::pow(10.0, ebn0s[p] / 10.0) * NBITS / N;
+        double sigma = 50.0 / std::sqrt(1.0 + 2.0 * esn0);
+        double a = sigma * std::sqrt(2.0 * esn0);
+        GaussianNoise noise(7, p);
+        std::vector<float> n(N);
+        for (int f = 0; f < frames; f++) {
+            uint8_t* d = &data[(size_t)f * FANO_MAX_DATA_BITS / 8];
+            std::memset(d, 0, FANO_MAX_DATA_BITS / 8);
+            uint64_t h = 0x9e3779b97f4a7c15ULL * (uint64_t)(f + 1);
+            for (int i = 0; i < NBITS; i++) {
+                h ^= h >> 31;
+                h *= 0xbf58476d1ce4e5b9ULL;
+                if (h >> 63) d[i / 8] |= (uint8_t)(0x80 >> (i % 8));
+            }
+            conv_encode(d, NBITS, code);
+            noise.fill_at((uint64_t)f * N, n.data(), N, (float)sigma);
+            for (int i = 0; i < N; i++) {
+                double y = 128.0 + (code[i] ? a : -a) + n[i];
+                soft[(size_t)f * N + i] = (uint8_t)std::max(0.0, std::min(255.0, std::floor(y + 0.5)));
+            }
+        }
+
+        std::vector<double> frame_ms(frames);
+        std::vector<FanoResult> results(frames);
+        bench_clock::time_point t0 = bench_clock::now();
+        parallel_for(frames, threads, [&](size_t f) {
+            bench_clock::time_point f0 = bench_clock::now();
+            results[f] = fano.decode(&soft[f * N], NBITS);
+            frame_ms[f] = seconds_since(f0) * 1e3;
+        });
+        double t = seconds_since(t0);
+
+        int decoded = 0, wrong = 0;
+        double cycles = 0.0, slowest = 0.0;
+        for (int f = 0; f < frames; f++) {
+            cycles += results[f].cycles;
+            slowest = std::max(slowest, frame_ms[f]);
+            if (results[f].status != FANO_OK) continue;
+            decoded++;
+            if (std::memcmp(results[f].data, &data[(size_t)f * FANO_MAX_DATA_BITS / 8], 7) != 0) wrong++;
+        }
+        std::printf("  %5.1f dB %8.1f%% %7d %12.1f %10.0f %11.2f\n", ebn0s[p], 100.0 * decoded / frames,
+                    wrong, cycles / frames / NBITS, frames / t, slowest);
+    }
+    return ok ? 0 : 1;
+}
+
+static int bench_ldpc(int frames) {
+    Ft8Ldpc ldpc;
+    JTEncode encoder;
+    std::printf("FT8 LDPC (174,91), layered min-sum, %d iterations, scale %.2f\n",
+                DEFAULT_LDPC_CONFIG.max_iterations, DEFAULT_LDPC_CONFIG.scale);
+
+    // Codeword bits from the 58 data tones (Costas arrays at 0, 36 and 72)
+    const uint8_t gray_inverse[8] = {0, 1, 3, 2, 6, 4, 5, 7};
+    uint8_t tones[FT8_SYMBOL_COUNT], code[FT8_LDPC_N], again[FT8_LDPC_N];
+    encoder.ft8_encode("K1ABC W9XYZ", tones);
+    int k = 0;
+    for (int i = 7; i < FT8_SYMBOL_COUNT - 7; i++) {
+        if (i >= 36 && i < 43) continue;
+        for (int b = 2; b >= 0; b--) code[k++] = (gray_inverse[tones[i]] >> b) & 1;
+    }
+    ft8_ldpc_encode(code, again);
+    bool ok = std::memcmp(code, again, FT8_LDPC_N) == 0;
+    std::vector<float> llr(FT8_LDPC_N);
+    for (int i = 0; i < FT8_LDPC_N; i++) llr[i] = code[i] ? 4.0f : -4.0f;
+    LdpcResult r = ldpc.decode(llr.data());
+    bool decoded = r.ok && r.iterations == 1;
+    for (int i = 0; i < FT8_LDPC_K; i++) decoded = decoded && ((r.bits[i / 8] >> (7 - i % 8)) & 1) == code[i];
+    std::printf("  ft8_encode codeword: encoder %s, decoder %s\n", ok ? "ok" : "MISMATCH",
+                decoded ? "ok" : "FAILED");
+    ok = ok && decoded;
+
+    const double ebn0s[] = {1.0, 1.5, 2.0, 2.5, 3.0, 4.0, 6.0};
+    int threads = default_thread_count();
+    std::vector<uint8_t> codes((size_t)frames * FT8_LDPC_N);
+    llr.resize((size_t)frames * FT8_LDPC_N);
+    std::vector<float> n(FT8_LDPC_N);
+    std::printf("  %d random codewords per point, %d threads\n", frames, threads);
+    std::printf("  %7s %9s %7s %11s %10s\n", "Eb/N0", "decoded", "wrong", "iterations", "frames/s");
+    for (size_t p = 0; p < sizeof(ebn0s) / sizeof(ebn0s[0]); p++) {
+        // Unit amplitude BPSK: sigma^2 = 1 / (2 R Eb/N0), LLR = 2 y / sigma^2
+        double sigma = std::sqrt(1.0 / (2.0 * FT8_LDPC_K / FT8_LDPC_N * std::pow(10.0, ebn0s[p] / 10.0)));
+        GaussianNoise noise(11, p);
+        for (int f = 0; f < frames; f++) {
+            uint8_t msg[FT8_MESSAGE_BITS];
+            uint64_t h = 0x9e3779b97f4a7c15ULL * (uint64_t)(f + 1);
+            for (int i = 0; i < FT8_MESSAGE_BITS; i++) {
+                h ^= h >> 31;
+                h *= 0xbf58476d1ce4e5b9ULL;
+                msg[i] = (uint8_t)(h >> 63);
+            }
+            uint8_t* c = &codes[(size_t)f * FT8_LDPC_N];
+            ft8_ldpc_encode(msg, c);
+            noise.fill_at((uint64_t)f * FT8_LDPC_N, n.data(), FT8_LDPC_N, (float)sigma);
+            for (int i = 0; i < FT8_LDPC_N; i++) {
+                double y = (c[i] ? 1.0 : -1.0) + n[i];
+                llr[(size_t)f * FT8_LDPC_N + i] = (float)(2.0 * y / (sigma * sigma));
+            }
+        }
+
+        bench_clock::time_point t0 = bench_clock::now();
+        std::vector<LdpcResult> results = ldpc.decode_batch(llr.data(), frames, threads);
+        double t = seconds_since(t0);
+
+        int good = 0, wrong = 0;
+        double iterations = 0.0;
+        for (int f = 0; f < frames; f++) {
+            iterations += results[f].iterations;
+            if (!results[f].ok) continue;
+            good++;
+            const uint8_t* c = &codes[(size_t)f * FT8_LDPC_N];
+            for (int i = 0; i < FT8_LDPC_K; i++) {
+                if (((results[f].bits[i / 8] >> (7 - i % 8)) & 1) != c[i]) {
+                    wrong++;
+                    break;
+                }
+            }
+        }
+        std::printf("  %5.1f dB %8.1f%% %7d %11.2f %10.0f\n", ebn0s[p], 100.0 * good / frames, wrong,
+                    iterations / frames, frames / t);
+    }
+    return ok ? 0 : 1;
+}
+
+// Magnitude response of the prototype at f (fraction of its own rate)
+static double filter_gain(const std::vector<double>& h, double f) {
+    double re = 0.0, im = 0.0;
+    for (size_t k = 0; k < h.size(); k++) {
+        re += h[k] * std::cos(2.0 * M_PI * f * k);
+        im -= h[k] * std::sin(2.0 * M_PI * f * k);
+    }
+    return std::sqrt(re * re + im * im);
+}
+
+static int bench_resample(int iterations) {
+    const int rates[][2] = {{48000, 12000}, {12000, 48000}, {44100, 12000}, {375, 12000}};
+    const double seconds = 120.0;
+    const size_t BLOCK = 65536;
+    bool ok = true;
+    std::printf("Polyphase resampling, %.0f s of input in %zu-sample blocks, %d iterations\n", seconds,
+                BLOCK, iterations);
+    std::printf("  %-13s %6s %5s %9s %9s %9s %10s %9s %9s\n", "ratio", "phases", "taps", "design ms",
+                "ripple dB", "stop dB", "in Ms/s", "realtime", "error dB");
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        int in_rate = rates[r][0], out_rate = rates[r][1], up, down;
+        resample_ratio(in_rate, out_rate, up, down);
+        bench_clock::time_point t0 = bench_clock::now();
+        std::shared_ptr<const ResampleFilter> f = resample_filter(up, down);
+        double t_design = seconds_since(t0);
+
+        // Undo the phase split; band edges 0.4 and 0.5 of the lower rate
+        std::vector<double> h((size_t)up * f->taps, 0.0);
+        for (int p = 0; p < up; p++) {
+            for (int k = 0; k < f->taps; k++) h[p + (size_t)k * up] = f->bank[(size_t)p * f->taps + f->taps - 1 - k];
+        }
+        double dc = filter_gain(h, 0.0), low = 1.0 / (up > down ? up : down);
+        double pass_min = 1e9, pass_max = -1e9, stop_max = -1e9;
+        const int GRID = 2000;
+        for (int g = 0; g <= GRID; g++) {
+            double db = 20.0 * std::log10(filter_gain(h, 0.4 * low * g / GRID) / dc);
+            pass_min = std::min(pass_min, db);
+            pass_max = std::max(pass_max, db);
+            double fs = 0.5 * low + (0.5 - 0.5 * low) * g / GRID;
+            stop_max = std::max(stop_max, 20.0 * std::log10(filter_gain(h, fs) / dc + 1e-300));
+        }
+
+        // Throughput on noise
+        size_t n = (size_t)(seconds * in_rate);
+        std::vector<float> in(n), out;
+        GaussianNoise(7, r).fill_at(0, in.data(), n, 0.1f);
+        double t_run = 0.0;
+        for (int it = 0; it < iterations; it++) {
+            Resampler rs(up, down);
+            out.clear();
+            out.reserve((size_t)((uint64_t)n * up / down) + 1024);
+            t0 = bench_clock::now();
+            for (size_t pos = 0; pos < n; pos += BLOCK) rs.process(&in[pos], std::min(BLOCK, n - pos), out);
+            t_run += seconds_since(t0);
+        }
+
+        // A tone at a tenth of the lower rate against the ideal output,
+        // away from the ends
+        double tone = 0.1 * std::min(in_rate, out_rate);
+        for (size_t k = 0; k < n; k++) in[k] = (float)std::sin(2.0 * M_PI * tone * k / in_rate);
+        resample(in.data(), n, in_rate, out_rate, out);
+        double err = 0.0, sig = 0.0;
+        size_t edge = out.size() / 10;
+        for (size_t k = edge; k + edge < out.size(); k++) {
+            double ideal = std::sin(2.0 * M_PI * tone * k / out_rate);
+            err += (out[k] - ideal) * (out[k] - ideal);
+            sig += ideal * ideal;
+        }
+        double error_db = 10.0 * std::log10(err / sig);
+        ok = ok && out.size() == (size_t)(((uint64_t)n * up + down - 1) / down) && error_db < -80.0;
+
+        char ratio[32];
+        std::snprintf(ratio, sizeof(ratio), "%d->%d", in_rate, out_rate);
+        double ms = n / 1e6 * iterations;
+        std::printf("  %-13s %6d %5d %9.2f %9.5f %9.1f %10.1f %8.0fx %9.1f\n", ratio, up, f->taps,
+                    t_design * 1e3, pass_max - pass_min, -stop_max, ms / t_run,
+                    seconds * iterations / t_run, error_db);
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s BENCHMARK [ITERATIONS]\n", argv[0]);
+        std::fprintf(stderr, "\nBenchmarks:\n");
+        std::fprintf(stderr, "  synth   direct vs tone-cache WSPR-2 synthesis\n");
+        std::fprintf(stderr, "  ft8     FT8 GFSK frame rendering (ITERATIONS = frames)\n");
+        std::fprintf(stderr, "  noise   counter-based Gaussian noise generation\n");
+        std::fprintf(stderr, "  fading  Watterson channel presets, real and complex\n");
+        std::fprintf(stderr, "  fano    Fano decoding of WSPR frames vs Eb/N0 (ITERATIONS = frames)\n");
+        std::fprintf(stderr, "  ldpc    FT8 LDPC decoding vs Eb/N0 (ITERATIONS = frames)\n");
+        std::fprintf(stderr, "  resample polyphase resampler response and throughput\n");
+        return 1;
+    }
+
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (iterations < 1) iterations = 1;
+
+    if (std::strcmp(argv[1], "synth") == 0) return bench_synth(iterations);
+    if (std::strcmp(argv[1], "ft8") == 0) return bench_ft8(argc > 2 ? iterations : 1000);
+    if (std::strcmp(argv[1], "noise") == 0) return bench_noise(argc > 2 ? iterations : 50);
+    if (std::strcmp(argv[1], "fading") == 0) return bench_fading(argc > 2 ? iterations : 3);
+    if (std::strcmp(argv[1], "fano") == 0) return bench_fano(argc > 2 ? iterations : 1000);
+    if (std::strcmp(argv[1], "ldpc") == 0) return bench_ldpc(argc > 2 ? iterations : 10000);
+    if (std::strcmp(argv[1], "resample") == 0) return bench_resample(argc > 2 ? iterations : 3);
+
+    std::fprintf(stderr, "Error: Unknown benchmark '%s'\n", argv[1]);
+    return 1;
+}
@@ -0,0 +1,647 @@
+// wsprmatrix.cpp
+//
+// Decode matrix runner: runs every decoder on every input under every
+// impairment, on a bounded pool of worker threads, and reports pass/fail
+// with timings as JSON. It replaces decode_{norm,alt}_{norm,alt}.sh,
+// which run one decoder on one file and grep its output.
+//
+// Build:
+//   make wsprmatrix
+//
+// Usage:
+//   ./wsprmatrix [-d DECODER]... [-i IMPAIRMENT]... [-j THREADS] [-o OUT.json]
+//                [-C CACHE] [-c CENTER] [-m MESSAGE] INPUT...
+//
+//   -d   decoder, repeatable (default: native and native-alt):
+//          native        built-in demodulator and Fano decoder, standard sync
+//          native-alt    the same against the altered sync vector
+//          NAME[@altered]=COMMAND
+//                        external command; {} is replaced by the file path
+//                        and any output line other than <DecodeFinished>
+//                        (with -m, any line containing the message) counts
+//                        as a decode. @altered marks a decoder for altered
+//                        sync (default standard).
+//   -i   impairment, repeatable (default none): "none" or comma-separated
+//        snr=DB (AWGN, SNR in 2500 Hz relative to the input's power),
+//        fading=PROFILE (Watterson, see wsprsim -f), dt=SECONDS (delay)
+//   -j   worker threads (default: all cores)
+//   -o   JSON output file (default stdout)
+//   -C   result cache (default .wsprmatrix.cache, "" for none)
+//   -c   audio frequency at baseband 0 Hz for WAV input (default 1500)
+//   -m   expected message, e.g. "W1AW FN42 30"; without it any valid
+//        message counts as a decode
+//
+// INPUT is a .c2 or WAV file, optionally prefixed "normal:" or "altered:"
+// for its sync variant; otherwise a base name containing "alt" means
+// altered. A cell passes when a decoder for the input's variant decodes
+// it, or a decoder for the other variant does not. The native decoders
+// unpack what the Fano decoder returns and only count valid messages.
+//
+// Cells are cached by the input's content hash (and for WAV input the
+// center), decoder, impairment and expected message, so rerunning the
+// matrix skips the cells whose inputs did not change. Every key also
+// carries a hash of the wsprmatrix executable, so a rebuild with changed
+// decoders or signal processing in sim/ reruns every cell, and
+// MATRIX_VERSION, to be bumped when the key or pass rule changes.
+//
+// Example, the four decode_*.sh checks (one command line):
+//   ./wsprmatrix -d 'wsprd=./wspr-cui/wsprd/wsprd -d -f 1.5 {}'
+//                -d 'wsprd-alt@altered=./wspr-cui/wsprd-alt/wsprd -d -f 1.5 {}'
+//                wspr_normal.c2 wspr_altered.c2
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "sim/artifact.h"
+#include "sim/baseband.h"
+#include "sim/c2file.h"
+#include "sim/fading.h"
+#include "sim/fano.h"
+#include "sim/noise.h"
+#include "sim/parallel.h"
+#include "sim/sync_search.h"
+#include "sim/wspr_demod.h"
+#include "sim/wspr_message.h"
+
+typedef std::chrono::steady_clock matrix_clock;
+
+// Cache key prefix, see above
+const char* const MATRIX_VERSION = "wsprmatrix-3";
+
+// Native decoding: candidates per variant and the Fano effort per
+// candidate, well past what a real signal needs
+const size_t NATIVE_CANDIDATES = 10;
+const double NATIVE_MIN_SYNC = 0.1;
+const long NATIVE_CYCLES = 2000;
+const int WSPR_DATA_BITS = 50;
+const double DIAL_FREQ_MHZ = 14.0956;
+
+struct Decoder {
+    std::string name;
+    bool altered;
+    std::string command;    // empty for the native decoder
+};
+
+struct Impairment {
+    std::string name;
+    bool has_snr;
+    double snr;
+    std::string fading;
+    double dt;
+};
+
+struct Input {
+    std::string path;
+    bool altered;
+    uint64_t hash;
+    bool ok;
+};
+
+struct Cell {
+    bool decoded;
+    bool cached;
+    bool error;
+    double ms;
+    std::string detail;
+};
+
+static double ms_since(matrix_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(matrix_clock::now() - start).count();
+}
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-d DECODER]... [-i IMPAIRMENT]... [-j THREADS] [-o OUT.json]\n"
+                         "       %*s [-C CACHE] [-c CENTER] [-m MESSAGE] INPUT...\n",
+                 prog, (int)std::strlen(prog), "");
+}
+
+static bool parse_decoder(const char* spec, Decoder& d) {
+    std::string s(spec);
+    if (s == "native" || s == "native-alt") {
+        d.name = s;
+        d.altered = s == "native-alt";
+        d.command.clear();
+        return true;
+    }
+    size_t eq = s.find('=');
+    if (eq == std::string::npos || eq == 0 || s.find("{}", eq) == std::string::npos) {
+        std::fprintf(stderr, "Error: decoder '%s' is not native, native-alt or NAME=COMMAND with {}\n", spec);
+        return false;
+    }
+    d.name = s.substr(0, eq);
+    d.command = s.substr(eq + 1);
+    d.altered = false;
+    size_t at = d.name.find('@');
+    if (at != std::string::npos) {
+        std::string variant = d.name.substr(at + 1);
+        if (variant != "altered" && variant != "normal") {
+            std::fprintf(stderr, "Error: decoder variant '%s' is not normal or altered\n", variant.c_str());
+            return false;
+        }
+        d.altered = variant == "altered";
+        d.name = d.name.substr(0, at);
+    }
+    return true;
+}
+
+static bool parse_impairment(const char* spec, Impairment& imp) {
+    imp.name = spec;
+    imp.has_snr = false;
+    imp.snr = 0.0;
+    imp.fading.clear();
+    imp.dt = 0.0;
+    if (imp.name == "none") return true;
+
+    std::string s(spec);
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) comma = s.size();
+        std::string item = s.substr(pos, comma - pos);
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+        char* end = NULL;
+        bool ok = !value.empty();
+        if (ok && key == "snr") {
+            imp.has_snr = true;
+            imp.snr = std::strtod(value.c_str(), &end);
+            ok = *end == '\0';
+        } else if (ok && key == "dt") {
+            imp.dt = std::strtod(value.c_str(), &end);
+            ok = *end == '\0';
+        } else if (ok && key == "fading") {
+            std::vector<FadingTap> taps;
+            if (!parse_fading_taps(value.c_str(), taps)) {
+                std::fprintf(stderr, "Error: Unknown fading '%s'\n", value.c_str());
+                std::fprintf(stderr, "Use DELAY_MS:SPREAD_HZ or one of: %s\n", fading_profile_names());
+                return false;
+            }
+            imp.fading = value;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "Error: bad impairment '%s' (expected snr=DB, fading=PROFILE, dt=S)\n", spec);
+            return false;
+        }
+        pos = comma + 1;
+    }
+    return true;
+}
+
+static bool is_impaired(const Impairment& imp) {
+    return imp.has_snr || !imp.fading.empty() || imp.dt != 0.0;
+}
+
+// 64-bit FNV-1a of a whole file
+static bool hash_file(const char* path, uint64_t& hash) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot open %s\n", path);
+        return false;
+    }
+    hash = 0xcbf29ce484222325ULL;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            hash ^= buf[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+static uint64_t mix_hash(uint64_t hash, const std::string& text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Every parameter read_baseband is given goes into the key: the input's
+// content and format, and for WAV input the center it is mixed down about
+static std::string cell_key(const Input& in, const Decoder& d, const Impairment& imp, double center,
+                            const std::string& expected) {
+    char text[64];
+    if (is_c2_path(in.path.c_str())) {
+        std::snprintf(text, sizeof(text), "%016llx c2", (unsigned long long)in.hash);
+    } else {
+        std::snprintf(text, sizeof(text), "%016llx wav@%.17g", (unsigned long long)in.hash, center);
+    }
+    std::string cmd = d.command.empty() ? d.name : d.command;
+    return std::string(MATRIX_VERSION) + "|" + executable_hash() + "|" + text + "|" + (d.altered ? "altered" : "normal") + "|" + cmd +
+           "|" + imp.name + "|" + expected;
+}
+
+// path in single quotes for sh, each ' in it as '\''
+static std::string shell_quote(const std::string& path) {
+    std::string out = "'";
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '\'') out += "'\\''";
+        else out += path[i];
+    }
+    return out + "'";
+}
+
+// Cache lines: KEY \t DECODED \t MS \t DETAIL
+static void load_cache(const std::string& path, std::map<std::string, Cell>& cache) {
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return;
+    char line[4096];
+    while (std::fgets(line, sizeof(line), f)) {
+        line[std::strcspn(line, "\n")] = '\0';
+        char* fields[4];
+        int n = 0;
+        char* p = line;
+        while (n < 4) {
+            fields[n++] = p;
+            char* tab = std::strchr(p, '\t');
+            if (!tab) break;
+            *tab = '\0';
+            p = tab + 1;
+        }
+        if (n != 4) continue;
+        Cell c;
+        c.decoded = std::atoi(fields[1]) != 0;
+        c.cached = true;
+        c.error = false;
+        c.ms = std::atof(fields[2]);
+        c.detail = fields[3];
+        cache[fields[0]] = c;
+    }
+    std::fclose(f);
+}
+
+static bool save_cache(const std::string& path, const std::map<std::string, Cell>& cache) {
+    std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot write %s\n", tmp.c_str());
+        return false;
+    }
+    for (std::map<std::string, Cell>::const_iterator it = cache.begin(); it != cache.end(); ++it) {
+        std::fprintf(f, "%s\t%d\t%.3f\t%s\n", it->first.c_str(), it->second.decoded ? 1 : 0,
+                     it->second.ms, it->second.detail.c_str());
+    }
+    if (std::fclose(f) != 0 || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::fprintf(stderr, "Error: Cannot write %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Mean power of the nonzero samples: the signal power of a clean rendering
+static double signal_power(const std::vector<float>& in_i, const std::vector<float>& in_q) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t k = 0; k < in_i.size(); k++) {
+        double p = in_i[k] * in_i[k] + in_q[k] * in_q[k];
+        if (p > 0.0) {
+            sum += p;
+            count++;
+        }
+    }
+    return count ? sum / count : 0.0;
+}
+
+static void apply_impairment(const Impairment& imp, uint64_t seed, double rate, std::vector<float>& in_i,
+                             std::vector<float>& in_q) {
+    size_t n = in_i.size();
+    if (imp.dt != 0.0) {
+        long shift = std::lround(imp.dt * rate);
+        std::vector<float> i2(n, 0.0f), q2(n, 0.0f);
+        for (size_t k = 0; k < n; k++) {
+            long src = (long)k - shift;
+            if (src >= 0 && src < (long)n) {
+                i2[k] = in_i[src];
+                q2[k] = in_q[src];
+            }
+        }
+        in_i.swap(i2);
+        in_q.swap(q2);
+    }
+    double amplitude = std::sqrt(signal_power(in_i, in_q));
+    if (!imp.fading.empty()) {
+        std::vector<FadingTap> taps;
+        parse_fading_taps(imp.fading.c_str(), taps);
+        FadingChannel channel(taps, rate, seed);
+        channel.process_iq(in_i.data(), in_q.data(), n);
+    }
+    if (imp.has_snr && amplitude > 0.0) {
+        NoiseStage noise(rate, awgn_sigma_iq(amplitude, imp.snr, rate), seed);
+        noise.apply_iq(in_i.data(), in_q.data(), 0, n);
+    }
+}
+
+// Decoded when a candidate unpacks to a valid message, the expected one
+// if given; otherwise detail names the first other message, if any
+static bool native_decode(const SyncSearch& search, const std::vector<float>& in_i,
+                          const std::vector<float>& in_q, double rate, double center, bool altered,
+                          const std::string& expected, std::string& detail) {
+    FanoConfig config = DEFAULT_FANO_CONFIG;
+    config.max_cycles = NATIVE_CYCLES;
+    FanoDecoder fano(config);
+    WsprDemod demod(in_i.data(), in_q.data(), in_i.size(), rate, altered);
+    std::vector<WsprCandidate> cands = demod.candidates(search, NATIVE_MIN_SYNC, NATIVE_CANDIDATES);
+    detail.clear();
+    for (size_t k = 0; k < cands.size(); k++) {
+        demod.refine(cands[k]);
+        FanoResult r = fano.decode(cands[k].soft, WSPR_DATA_BITS);
+        WsprMessage msg;
+        if (r.status != FANO_OK || !wspr_unpack(r.data, msg)) continue;
+        bool match = expected.empty() || msg.text() == expected;
+        if (!match && !detail.empty()) continue;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "dt %+.2f freq %.1f ", cands[k].dt, center + cands[k].freq);
+        detail = (match ? buf : std::string(buf) + "other message ") + msg.text();
+        if (match) return true;
+    }
+    return false;
+}
+
+static bool external_decode(const std::string& command, const std::string& path, const std::string& expected,
+                            std::string& detail, bool& error) {
+    std::string cmd = command;
+    std::string quoted = shell_quote(path);
+    for (size_t pos = 0; (pos = cmd.find("{}", pos)) != std::string::npos; pos += quoted.size()) {
+        cmd.replace(pos, 2, quoted);
+    }
+    cmd += " 2>/dev/null";
+    FILE* p = popen(cmd.c_str(), "r");
+    if (!p) {
+        error = true;
+        detail = "cannot run decoder";
+        return false;
+    }
+    bool decoded = false;
+    char line[1024];
+    while (std::fgets(line, sizeof(line), p)) {
+        line[std::strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || std::strstr(line, "<DecodeFinished>")) continue;
+        if (!expected.empty() && wspr_normalize_message(line).find(expected) == std::string::npos) continue;
+        if (!decoded) detail = line;
+        decoded = true;
+    }
+    int status = pclose(p);
+    if (!decoded && status != 0) {
+        error = true;
+        detail = "decoder exited with status " +
+                 std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : status);
+    }
+    return decoded;
+}
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+int main(int argc, char** argv) {
+    std::vector<Decoder> decoders;
+    std::vector<Impairment> impairments;
+    int threads = default_thread_count();
+    const char* out_path = NULL;
+    std::string cache_path = ".wsprmatrix.cache";
+    double center = 1500.0;
+    std::string expected;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:i:j:o:C:c:m:")) != -1) {
+        switch (opt) {
+        case 'd': {
+            Decoder d;
+            if (!parse_decoder(optarg, d)) return 1;
+            decoders.push_back(d);
+            break;
+        }
+        case 'i': {
+            Impairment imp;
+            if (!parse_impairment(optarg, imp)) return 1;
+            impairments.push_back(imp);
+            break;
+        }
+        case 'j': threads = std::atoi(optarg); break;
+        case 'o': out_path = optarg; break;
+        case 'C': cache_path = optarg; break;
+        case 'c': center = std::atof(optarg); break;
+        case 'm': expected = wspr_normalize_message(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind < 1 || threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (decoders.empty()) {
+        Decoder d;
+        parse_decoder("native", d);
+        decoders.push_back(d);
+        parse_decoder("native-alt", d);
+        decoders.push_back(d);
+    }
+    if (impairments.empty()) {
+        Impairment imp;
+        parse_impairment("none", imp);
+        impairments.push_back(imp);
+    }
+
+    std::vector<Input> inputs;
+    for (int a = optind; a < argc; a++) {
+        Input in;
+        std::string arg = argv[a];
+        if (arg.compare(0, 7, "normal:") == 0) {
+            in.path = arg.substr(7);
+            in.altered = false;
+        } else if (arg.compare(0, 8, "altered:") == 0) {
+            in.path = arg.substr(8);
+            in.altered = true;
+        } else {
+            in.path = arg;
+            size_t slash = arg.find_last_of('/');
+            in.altered = arg.find("alt", slash == std::string::npos ? 0 : slash + 1) != std::string::npos;
+        }
+        in.hash = 0;
+        in.ok = false;
+        inputs.push_back(in);
+    }
+
+    matrix_clock::time_point t0 = matrix_clock::now();
+    parallel_for(inputs.size(), threads, [&](size_t k) {
+        inputs[k].ok = hash_file(inputs[k].path.c_str(), inputs[k].hash);
+    });
+
+    std::map<std::string, Cell> cache;
+    if (!cache_path.empty()) load_cache(cache_path, cache);
+
+    char tmpl[] = "/tmp/wsprmatrix.XXXXXX";
+    bool need_tmp = false;
+    for (size_t d = 0; d < decoders.size(); d++) need_tmp = need_tmp || !decoders[d].command.empty();
+    const char* tmp_dir = need_tmp ? mkdtemp(tmpl) : NULL;
+    if (need_tmp && !tmp_dir) {
+        std::fprintf(stderr, "Error: Cannot create a temporary directory\n");
+        return 2;
+    }
+
+    // One task per input and impairment: load and impair once, then run
+    // every decoder whose cell is not cached
+    const size_t nd = decoders.size(), ni = impairments.size();
+    std::vector<Cell> cells(inputs.size() * ni * nd);
+    std::vector<std::string> keys(cells.size());
+    parallel_for(inputs.size() * ni, threads, [&](size_t task) {
+        const Input& in = inputs[task / ni];
+        const Impairment& imp = impairments[task % ni];
+        Cell* row = &cells[task * nd];
+        bool todo = false;
+        for (size_t d = 0; d < nd; d++) {
+            keys[task * nd + d] = cell_key(in, decoders[d], imp, center, expected);
+            std::map<std::string, Cell>::const_iterator it = cache.find(keys[task * nd + d]);
+            if (in.ok && it != cache.end()) {
+                row[d] = it->second;
+            } else {
+                row[d].decoded = false;
+                row[d].cached = false;
+                row[d].error = !in.ok;
+                row[d].ms = 0.0;
+                row[d].detail = in.ok ? "" : "cannot read input";
+                todo = todo || in.ok;
+            }
+        }
+        if (!todo) return;
+
+        // Inputs are only loaded when a native decoder or an impairment
+        // needs the samples
+        bool need_samples = is_impaired(imp);
+        for (size_t d = 0; d < nd; d++) {
+            need_samples = need_samples || (decoders[d].command.empty() && !row[d].cached);
+        }
+        std::vector<float> in_i, in_q;
+        double rate = 0.0;
+        if (need_samples && !read_baseband(in.path.c_str(), center, in_i, in_q, rate)) {
+            for (size_t d = 0; d < nd; d++) {
+                if (row[d].cached) continue;
+                row[d].error = true;
+                row[d].detail = "cannot read input";
+            }
+            return;
+        }
+        std::string impaired_path = in.path;
+        if (is_impaired(imp)) {
+            uint64_t seed = mix_hash(in.hash, imp.name);
+            apply_impairment(imp, seed, rate, in_i, in_q);
+            if (tmp_dir) {
+                char name[64];
+                std::snprintf(name, sizeof(name), "/%zu.c2", task);
+                impaired_path = std::string(tmp_dir) + name;
+                C2Writer writer;
+                int type = rate < 100.0 ? 15 : 2;
+                bool ok = writer.open(impaired_path.c_str(), type, DIAL_FREQ_MHZ) &&
+                          writer.write(in_i.data(), in_q.data(), in_i.size()) && writer.close();
+                if (!ok) impaired_path.clear();
+            }
+        }
+
+        SyncSearch* search = NULL;
+        for (size_t d = 0; d < nd; d++) {
+            Cell& c = row[d];
+            if (c.cached) continue;
+            matrix_clock::time_point start = matrix_clock::now();
+            if (decoders[d].command.empty()) {
+                if (!search) {
+                    search = new SyncSearch(in_i.data(), in_q.data(), in_i.size(), rate);
+                    search->correlate(-2.0, 4.0, 150.0);
+                }
+                c.decoded = native_decode(*search, in_i, in_q, rate, center, decoders[d].altered, expected,
+                                          c.detail);
+            } else if (impaired_path.empty()) {
+                c.error = true;
+                c.detail = "cannot write impaired input";
+            } else {
+                c.decoded = external_decode(decoders[d].command, impaired_path, expected, c.detail, c.error);
+            }
+            c.ms = ms_since(start);
+        }
+        delete search;
+        if (impaired_path != in.path && !impaired_path.empty()) std::remove(impaired_path.c_str());
+    });
+    if (tmp_dir) rmdir(tmp_dir);
+    double wall_ms = ms_since(t0);
+
+    // Results, and the cache updated with every successful new cell
+    size_t passed = 0, failed = 0, errors = 0, cached = 0;
+    for (size_t k = 0; k < cells.size(); k++) {
+        const Cell& c = cells[k];
+        const Input& in = inputs[k / (ni * nd)];
+        bool expected = decoders[k % nd].altered == in.altered;
+        if (c.error) errors++;
+        else if (c.decoded == expected) passed++;
+        else failed++;
+        if (c.cached) cached++;
+        else if (!c.error) cache[keys[k]] = c;
+    }
+    if (!cache_path.empty()) save_cache(cache_path, cache);
+
+    FILE* out = stdout;
+    if (out_path && !(out = std::fopen(out_path, "w"))) {
+        std::fprintf(stderr, "Error: Cannot open %s for writing\n", out_path);
+        return 2;
+    }
+    std::fprintf(out, "{\n  \"decoders\": [");
+    for (size_t d = 0; d < nd; d++) {
+        std::fprintf(out, "%s{\"name\": %s, \"sync\": \"%s\"}", d ? ", " : "", json_string(decoders[d].name).c_str(),
+                     decoders[d].altered ? "altered" : "normal");
+    }
+    std::fprintf(out, "],\n  \"impairments\": [");
+    for (size_t i = 0; i < ni; i++) {
+        std::fprintf(out, "%s%s", i ? ", " : "", json_string(impairments[i].name).c_str());
+    }
+    std::fprintf(out, "],\n  \"cells\": [\n");
+    for (size_t k = 0; k < cells.size(); k++) {
+        const Cell& c = cells[k];
+        const Input& in = inputs[k / (ni * nd)];
+        const Decoder& d = decoders[k % nd];
+        bool expected = d.altered == in.altered;
+        const char* result = c.error ? "error" : c.decoded == expected ? "pass" : "fail";
+        std::fprintf(out, "    {\"input\": %s, \"sync\": \"%s\", \"decoder\": %s, \"impairment\": %s, "
+                          "\"expected\": %s, \"decoded\": %s, \"result\": \"%s\", \"cached\": %s, "
+                          "\"ms\": %.1f, \"detail\": %s}%s\n",
+                     json_string(in.path).c_str(), in.altered ? "altered" : "normal",
+                     json_string(d.name).c_str(), json_string(impairments[(k / nd) % ni].name).c_str(),
+                     expected ? "true" : "false", c.decoded ? "true" : "false", result,
+                     c.cached ? "true" : "false", c.ms, json_string(c.detail).c_str(),
+                     k + 1 < cells.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n  \"summary\": {\"cells\": %zu, \"passed\": %zu, \"failed\": %zu, "
+                      "\"errors\": %zu, \"cached\": %zu, \"threads\": %d, \"wall_ms\": %.1f}\n}\n",
+                 cells.size(), passed, failed, errors, cached, threads, wall_ms);
+    if (out != stdout && std::fclose(out) != 0) {
+        std::fprintf(stderr, "Error: Failed writing %s\n", out_path);
+        return 2;
+    }
+    return failed || errors ? 3 : 0;
+}
@@ -0,0 +1,335 @@
+// wsprmsim.cpp
+//
+// Multi-transmitter WSPR-2 band simulator: mixes many normal and altered
+// sync transmissions into one 2 minute recording for decoder stress tests.
+//
+// Build:
+//   make wsprmsim
+//
+// Usage:
+//   ./wsprmsim [options] OUTPUT.wav
+//
+// Options:
+//   -n COUNT      random transmissions (default 100)
+//   -l LIST       read transmissions from LIST instead
+//   -a FRACTION   fraction of random transmissions with altered sync (default 0.5)
+//   -S SEED       random seed (default 1)
+//   -r RATE       WAV sample rate (default 48000)
+//   -c FILE.c2    also write the slot as wsprd .c2 baseband
+//   -m FILE.csv   ground-truth manifest (default OUTPUT.csv)
+//   -j THREADS    mixing threads (default: all cores)
+//   -C FREQ:SNR   add a steady QRM carrier (Hz, dB in 2500 Hz); repeatable
+//   -I RATE:PEAK:DECAY
+//                 add static crashes: bursts per second, peak in noise
+//                 sigmas, decay time constant in ms
+//   -N            no noise or QRM; SNRs still set the relative levels
+//
+// Random transmissions get a standard callsign, grid and power, a center
+// frequency in 1400-1600 Hz, DT in -1..2 s, SNR in -28..0 dB and drift
+// in -2..2 Hz. LIST lines, '#' starts a comment:
+//   CALL GRID DBM FREQ_HZ DT_S SNR_DB [DRIFT_HZ [ALTERED]]
+// Messages are checked as wsprsim checks them, and every tone, drift
+// included, must lie between 0 Hz and half the sample rate (within the
+// 375 Hz around 1500 Hz the .c2 file holds, with -c).
+//
+// The manifest has one row per transmission with its message, sync
+// variant and the exact frequency, DT, SNR and drift used.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "src/JTEncode.h"
+#include "sim/band.h"
+#include "sim/c2file.h"
+#include "sim/noise.h"
+#include "sim/parallel.h"
+#include "sim/wav.h"
+#include "sim/wspr_message.h"
+#include "sim/wspr_params.h"
+#include "sim/wspr_sync.h"
+
+const double DIAL_FREQ_MHZ = 14.0956;
+// Noise is added in chunks shared between the threads
+const size_t NOISE_CHUNK = 65536;
+
+struct Transmission {
+    std::string call;
+    std::string grid;
+    int dbm;
+    bool altered;
+};
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-n COUNT | -l LIST] [-a FRACTION] [-S SEED] [-r RATE]\n", prog);
+    std::fprintf(stderr, "       [-c FILE.c2] [-m FILE.csv] [-j THREADS] [-C FREQ:SNR]... [-I RATE:PEAK:DECAY_MS]\n");
+    std::fprintf(stderr, "       [-N] OUTPUT.wav\n");
+    std::fprintf(stderr, "\nLIST lines: CALL GRID DBM FREQ_HZ DT_S SNR_DB [DRIFT_HZ [ALTERED]]\n");
+}
+
+static void encode(const Transmission& tx, BandSignal& sig) {
+    JTEncode encoder;
+    encoder.wspr_encode(tx.call.c_str(), tx.grid.c_str(), tx.dbm, sig.symbols);
+    if (tx.altered) {
+        uint8_t normal[WSPR_SYMBOL_COUNT];
+        memcpy(normal, sig.symbols, sizeof(normal));
+        make_altered_symbols(normal, sig.symbols);
+    }
+}
+
+static void random_transmissions(int count, double altered_fraction, uint64_t seed,
+                                 std::vector<Transmission>& txs, std::vector<BandSignal>& sigs) {
+    static const char* prefixes[] = {"K", "W", "N", "G", "F", "DL", "JA", "VK", "PA", "OH"};
+    static const int powers[] = {0, 3, 7, 10, 13, 17, 20, 23, 27, 30, 33, 37, 40, 43};
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    for (int i = 0; i < count; i++) {
+        Transmission tx;
+        char call[8], grid[5];
+        std::snprintf(call, sizeof(call), "%s%d%c%c%c", prefixes[rng() % 10], (int)(rng() % 10),
+                      'A' + (int)(rng() % 26), 'A' + (int)(rng() % 26), 'A' + (int)(rng() % 26));
+        std::snprintf(grid, sizeof(grid), "%c%c%d%d", 'A' + (int)(rng() % 18), 'A' + (int)(rng() % 18),
+                      (int)(rng() % 10), (int)(rng() % 10));
+        tx.call = call;
+        tx.grid = grid;
+        tx.dbm = powers[rng() % 14];
+        tx.altered = unit(rng) < altered_fraction;
+
+        BandSignal sig;
+        sig.freq = 1400.0 + 200.0 * unit(rng);
+        sig.dt = -1.0 + 3.0 * unit(rng);
+        sig.snr = -28.0 + 28.0 * unit(rng);
+        sig.drift = -2.0 + 4.0 * unit(rng);
+        sig.phase = 2.0 * M_PI * unit(rng);
+        encode(tx, sig);
+        txs.push_back(tx);
+        sigs.push_back(sig);
+    }
+}
+
+// Lines of a LIST file; every tone must stay inside (low_hz, high_hz)
+static bool read_transmissions(const char* path, uint64_t seed, double low_hz, double high_hz,
+                               std::vector<Transmission>& txs, std::vector<BandSignal>& sigs) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot open %s\n", path);
+        return false;
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    char line[256];
+    int lineno = 0;
+    bool ok = true;
+    while (std::fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* hash = std::strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char call[16], grid[16];
+        Transmission tx;
+        BandSignal sig;
+        int altered = 0;
+        sig.drift = 0.0;
+        int n = std::sscanf(line, "%15s %15s %d %lf %lf %lf %lf %d", call, grid, &tx.dbm,
+                            &sig.freq, &sig.dt, &sig.snr, &sig.drift, &altered);
+        if (n <= 0) continue;
+        if (n < 6) {
+            std::fprintf(stderr, "Error: %s:%d: expected CALL GRID DBM FREQ_HZ DT_S SNR_DB [DRIFT_HZ [ALTERED]]\n",
+                         path, lineno);
+            ok = false;
+            break;
+        }
+        if (sig.dt < -1.0 || sig.dt > 8.0) {
+            std::fprintf(stderr, "Error: %s:%d: DT %.2f s does not fit the slot (-1..8 s)\n",
+                         path, lineno, sig.dt);
+            ok = false;
+            break;
+        }
+        if (!wspr_valid_call(call) || !wspr_valid_grid(grid) || !wspr_valid_dbm(tx.dbm)) {
+            std::fprintf(stderr, "Error: %s:%d: '%s %s %d' is not a WSPR message (call, AA00[AA] grid, "
+                                 "dBm -30, -27 ... 57, 60)\n",
+                         path, lineno, call, grid, tx.dbm);
+            ok = false;
+            break;
+        }
+        // Tones 0-3 sit 1.5 spacings either side of the center, and drift
+        // moves them half its total each way
+        double reach = 1.5 * FREQ_SPACING + std::fabs(sig.drift) / 2.0;
+        if (!(sig.freq - reach > low_hz && sig.freq + reach < high_hz)) {
+            std::fprintf(stderr, "Error: %s:%d: tones at %.1f..%.1f Hz fall outside %.1f..%.1f Hz\n",
+                         path, lineno, sig.freq - reach, sig.freq + reach, low_hz, high_hz);
+            ok = false;
+            break;
+        }
+        tx.call = call;
+        tx.grid = grid;
+        tx.altered = altered != 0;
+        sig.phase = 2.0 * M_PI * unit(rng);
+        encode(tx, sig);
+        txs.push_back(tx);
+        sigs.push_back(sig);
+    }
+    std::fclose(f);
+    return ok;
+}
+
+struct QrmOptions {
+    std::vector<std::pair<double, double> > carriers;   // freq, SNR
+    double impulse_rate, impulse_peak, impulse_decay;
+};
+
+static NoiseStage make_noise_stage(double rate, double sigma, uint64_t seed, const QrmOptions& qrm) {
+    NoiseStage stage(rate, sigma, seed);
+    for (size_t k = 0; k < qrm.carriers.size(); k++) {
+        stage.add_carrier(qrm.carriers[k].first, qrm.carriers[k].second);
+    }
+    stage.set_impulses(qrm.impulse_rate, qrm.impulse_peak, qrm.impulse_decay);
+    return stage;
+}
+
+static bool write_manifest(const char* path, const std::vector<Transmission>& txs,
+                           const std::vector<BandSignal>& sigs) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot create %s\n", path);
+        return false;
+    }
+    std::fprintf(f, "index,call,grid,dbm,sync,freq_hz,dt_s,snr_db,drift_hz\n");
+    for (size_t i = 0; i < txs.size(); i++) {
+        std::fprintf(f, "%zu,%s,%s,%d,%s,%.3f,%.3f,%.2f,%.3f\n", i, txs[i].call.c_str(),
+                     txs[i].grid.c_str(), txs[i].dbm, txs[i].altered ? "altered" : "normal",
+                     sigs[i].freq, sigs[i].dt, sigs[i].snr, sigs[i].drift);
+    }
+    return std::fclose(f) == 0;
+}
+
+int main(int argc, char** argv) {
+    int count = 100;
+    double altered_fraction = 0.5;
+    uint64_t seed = 1;
+    int rate = 48000;
+    int threads = default_thread_count();
+    bool noise = true;
+    const char* list = NULL;
+    const char* c2_path = NULL;
+    const char* manifest = NULL;
+    QrmOptions qrm;
+    qrm.impulse_rate = qrm.impulse_peak = qrm.impulse_decay = 0.0;
+    double f, v;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:a:S:r:c:m:j:C:I:N")) != -1) {
+        switch (opt) {
+        case 'n': count = std::atoi(optarg); break;
+        case 'l': list = optarg; break;
+        case 'a': altered_fraction = std::atof(optarg); break;
+        case 'S': seed = std::strtoull(optarg, NULL, 10); break;
+        case 'r': rate = std::atoi(optarg); break;
+        case 'c': c2_path = optarg; break;
+        case 'm': manifest = optarg; break;
+        case 'j': threads = std::atoi(optarg); break;
+        case 'N': noise = false; break;
+        case 'C':
+            if (std::sscanf(optarg, "%lf:%lf", &f, &v) != 2) {
+                std::fprintf(stderr, "Error: -C expects FREQ:SNR, got '%s'\n", optarg);
+                return 1;
+            }
+            qrm.carriers.push_back(std::make_pair(f, v));
+            break;
+        case 'I':
+            if (std::sscanf(optarg, "%lf:%lf:%lf", &qrm.impulse_rate, &qrm.impulse_peak,
+                            &qrm.impulse_decay) != 3 || qrm.impulse_decay <= 0.0) {
+                std::fprintf(stderr, "Error: -I expects RATE:PEAK:DECAY_MS, got '%s'\n", optarg);
+                return 1;
+            }
+            qrm.impulse_decay /= 1000.0;
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind != 1 || count < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (rate < 4000 || (long)rate * 8192 % 12000 != 0) {
+        std::fprintf(stderr, "Error: Sample rate must be at least 4000 and a multiple of 375 Hz\n");
+        return 1;
+    }
+    const char* output = argv[optind];
+    std::string manifest_path;
+    if (manifest) {
+        manifest_path = manifest;
+    } else {
+        manifest_path = output;
+        size_t dot = manifest_path.rfind('.');
+        if (dot != std::string::npos && manifest_path.find('/', dot) == std::string::npos) {
+            manifest_path.erase(dot);
+        }
+        manifest_path += ".csv";
+    }
+
+    std::vector<Transmission> txs;
+    std::vector<BandSignal> sigs;
+    if (list) {
+        double low = 0.0, high = rate / 2.0;
+        if (c2_path) {
+            low = std::max(low, 1500.0 - c2_sample_rate(2) / 2.0);
+            high = std::min(high, 1500.0 + c2_sample_rate(2) / 2.0);
+        }
+        if (!read_transmissions(list, seed, low, high, txs, sigs)) return 2;
+    } else {
+        random_transmissions(count, altered_fraction, seed, txs, sigs);
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    // Audio slot
+    BandMixer mixer(sigs, rate, AUDIO_NOISE_SIGMA);
+    std::vector<float> audio(mixer.slot_samples(), 0.0f);
+    mixer.mix_audio(audio.data(), audio.size(), threads);
+    double t_mix = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (noise) {
+        NoiseStage stage = make_noise_stage(rate, AUDIO_NOISE_SIGMA, seed, qrm);
+        size_t chunks = (audio.size() + NOISE_CHUNK - 1) / NOISE_CHUNK;
+        parallel_for(chunks, threads, [&](size_t c) {
+            size_t begin = c * NOISE_CHUNK;
+            stage.apply(&audio[begin], begin, std::min(NOISE_CHUNK, audio.size() - begin));
+        });
+    }
+    if (!write_wav_file(output, audio.data(), audio.size(), rate)) return 5;
+
+    // Baseband slot at the .c2 rate, centered on 1500 Hz audio
+    if (c2_path) {
+        double c2_rate = c2_sample_rate(2);
+        BandMixer c2_mixer(sigs, c2_rate, 1.0);
+        std::vector<float> i(C2_FRAMES, 0.0f), q(C2_FRAMES, 0.0f);
+        c2_mixer.mix_baseband(i.data(), q.data(), C2_FRAMES, 1500.0, threads);
+        if (noise) {
+            NoiseStage stage = make_noise_stage(c2_rate, 1.0, seed, qrm);
+            stage.set_center(1500.0);
+            stage.apply_iq(i.data(), q.data(), 0, C2_FRAMES);
+        }
+        C2Writer c2;
+        if (!c2.open(c2_path, 2, DIAL_FREQ_MHZ)) return 5;
+        c2.write(i.data(), q.data(), C2_FRAMES);
+        if (!c2.close()) return 5;
+    }
+    if (!write_manifest(manifest_path.c_str(), txs, sigs)) return 5;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    int altered = 0;
+    for (size_t k = 0; k < txs.size(); k++) altered += txs[k].altered;
+    std::printf("%zu transmissions (%d altered) at %d Hz, %d thread(s) → %s, %s%s%s\n",
+                txs.size(), altered, rate, threads, output, manifest_path.c_str(),
+                c2_path ? ", " : "", c2_path ? c2_path : "");
+    std::printf("Mixed in %.2f s, total %.2f s\n", t_mix, elapsed);
+    return 0;
+}
@@ -0,0 +1,309 @@
+// wsprsched.cpp
+//
+// Render long WSPR-2 recordings from a slot schedule, for soak testing.
+//
+// Build:
+//   make wsprsched
+//
+// Usage:
+//   ./wsprsched [-t HOURS] [-s SNR_DB] [-S SEED] [-r RATE] -o OUTPUT.wav SCHEDULE
+//   ./wsprsched [-t HOURS] [-s SNR_DB] [-S SEED] [-r RATE] -p PREFIX SCHEDULE
+//
+// The recording is a sequence of 2 minute slots starting on an even
+// minute. A scheduled transmission starts 1 s into its slot, like
+// DELAY_SAMPLES in wsprsim. Every other sample is silence, or Gaussian
+// noise with -s, calibrated so a 0.5 amplitude transmission has SNR_DB in
+// 2500 Hz.
+//
+// With -o the whole recording goes to one WAV file; with -p every slot is
+// written to PREFIX_NNNNNN.wav. The duration defaults to the end of the
+// last scheduled slot. Memory use does not depend on the duration.
+//
+// Schedule file, one entry per line, '#' starts a comment:
+//   SLOTS  CALL  GRID  DBM  [OFFSET_HZ  [ALTERED]]
+// SLOTS is a slot number N, a range N-M, or a stepped range N-M/STEP.
+// OFFSET_HZ moves the signal from its 1500 Hz center, ALTERED is 1 for
+// the inverted sync variant. Entries may share slots; their signals add.
+//
+// Example:
+//   0        K1ABC  FN42  37
+//   1-359/4  W1AW   FN31  30  -60  1
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "src/JTEncode.h"
+#include "sim/noise.h"
+#include "sim/synth.h"
+#include "sim/wav.h"
+#include "sim/wspr_params.h"
+#include "sim/wspr_sync.h"
+
+const int SLOT_SECONDS = 120;
+
+struct Transmission {
+    long first, last, step;     // slots first, first + step, ... <= last
+    double offset;              // Hz from CENTER_FREQ
+    const uint8_t* symbols;     // shared encoded symbols
+    const ToneCache* cache;     // shared tone blocks for this offset
+};
+
+static void usage(const char* prog) {
+    std::fprintf(stderr, "Usage: %s [-t HOURS] [-s SNR_DB] [-S SEED] [-r RATE] -o OUTPUT.wav SCHEDULE\n", prog);
+    std::fprintf(stderr, "       %s [-t HOURS] [-s SNR_DB] [-S SEED] [-r RATE] -p PREFIX SCHEDULE\n", prog);
+    std::fprintf(stderr, "\nSchedule lines: SLOTS CALL GRID DBM [OFFSET_HZ [ALTERED]]\n");
+    std::fprintf(stderr, "  SLOTS is N, N-M or N-M/STEP (2 minute slots from the start)\n");
+}
+
+// Parse "N", "N-M" or "N-M/STEP"
+static bool parse_slots(const char* text, long& first, long& last, long& step) {
+    char* end;
+    first = std::strtol(text, &end, 10);
+    last = first;
+    step = 1;
+    if (*end == '-') {
+        last = std::strtol(end + 1, &end, 10);
+        if (*end == '/') step = std::strtol(end + 1, &end, 10);
+    }
+    return *end == '\0' && first >= 0 && last >= first && step > 0;
+}
+
+// Encoded symbols and tone caches are shared between all entries with the
+// same message or offset, so a schedule of thousands of slots costs one
+// encode per distinct message and one cache per distinct offset.
+struct Schedule {
+    std::vector<Transmission> entries;
+    std::map<std::string, std::vector<uint8_t> > symbols;
+    std::map<double, ToneCache> caches;
+};
+
+static bool load_schedule(const char* path, int rate, int symbol_length, Schedule& sched) {
+    FILE* f = std::fopen(path, "r");
+    if (!f) {
+        std::fprintf(stderr, "Error: Cannot open %s\n", path);
+        return false;
+    }
+
+    JTEncode encoder;
+    double spacing = (double)rate / symbol_length;
+    char line[256];
+    int lineno = 0;
+    bool ok = true;
+    while (ok && std::fgets(line, sizeof(line), f)) {
+        lineno++;
+        char* hash = std::strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char slots[64], call[16], grid[16];
+        int dbm, altered = 0;
+        double offset = 0.0;
+        int n = std::sscanf(line, "%63s %15s %15s %d %lf %d", slots, call, grid, &dbm, &offset, &altered);
+        if (n <= 0) continue;
+
+        Transmission tx;
+        if (n < 4 || !parse_slots(slots, tx.first, tx.last, tx.step)) {
+            std::fprintf(stderr, "Error: %s:%d: expected SLOTS CALL GRID DBM [OFFSET_HZ [ALTERED]]\n",
+                         path, lineno);
+            ok = false;
+            break;
+        }
+        double low = CENTER_FREQ + offset - 1.5 * spacing;
+        double high = CENTER_FREQ + offset + 1.5 * spacing;
+        if (low <= 0.0 || high >= rate / 2.0) {
+            std::fprintf(stderr, "Error: %s:%d: offset %.1f Hz puts tones outside 0-%d Hz\n",
+                         path, lineno, offset, rate / 2);
+            ok = false;
+            break;
+        }
+        tx.offset = offset;
+
+        char key[64];
+        std::snprintf(key, sizeof(key), "%s %s %d %d", call, grid, dbm, altered ? 1 : 0);
+        std::vector<uint8_t>& syms = sched.symbols[key];
+        if (syms.empty()) {
+            syms.resize(WSPR_SYMBOL_COUNT);
+            encoder.wspr_encode(call, grid, dbm, syms.data());
+            if (altered) {
+                uint8_t normal[WSPR_SYMBOL_COUNT];
+                memcpy(normal, syms.data(), sizeof(normal));
+                make_altered_symbols(normal, syms.data());
+            }
+        }
+        tx.symbols = syms.data();
+
+        std::map<double, ToneCache>::iterator it = sched.caches.find(offset);
+        if (it == sched.caches.end()) {
+            it = sched.caches.insert(std::make_pair(offset,
+                     ToneCache(rate, symbol_length, low, spacing, 4, 0.5))).first;
+        }
+        tx.cache = &it->second;
+        sched.entries.push_back(tx);
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// Slot-by-slot renderer streaming one symbol length at a time
+class SlotRenderer {
+public:
+    SlotRenderer(const Schedule& sched, int rate, int symbol_length, float sigma, uint64_t seed)
+        : sched_(sched), rate_(rate), symbol_length_(symbol_length), sigma_(sigma),
+          noise_(seed), block_(symbol_length), sym_(symbol_length) {}
+
+    // Number of entries transmitting in a slot
+    int active_count(long slot) const {
+        int count = 0;
+        for (size_t i = 0; i < sched_.entries.size(); i++) count += is_active(sched_.entries[i], slot);
+        return count;
+    }
+
+    bool render(long slot, WavWriter& wav) {
+        std::vector<const Transmission*> active;
+        for (size_t i = 0; i < sched_.entries.size(); i++) {
+            if (is_active(sched_.entries[i], slot)) active.push_back(&sched_.entries[i]);
+        }
+
+        size_t slot_samples = (size_t)SLOT_SECONDS * rate_;
+        size_t lead = rate_;
+        size_t signal = (size_t)symbol_length_ * WSPR_SYMBOL_COUNT;
+        if (active.empty()) return fill(wav, slot_samples);
+
+        if (!fill(wav, lead)) return false;
+        std::vector<double> phase(active.size(), 0.0);
+        int slope = (int)(0.02 * rate_);
+        for (int k = 0; k < WSPR_SYMBOL_COUNT; k++) {
+            background(block_.data(), symbol_length_);
+            for (size_t t = 0; t < active.size(); t++) {
+                active[t]->cache->render(&active[t]->symbols[k], 1, sym_.data(), phase[t]);
+                if (k == 0) apply_fade_in(sym_.data(), slope);
+                if (k == WSPR_SYMBOL_COUNT - 1) apply_fade_out(sym_.data(), symbol_length_, slope);
+                for (int i = 0; i < symbol_length_; i++) block_[i] += sym_[i];
+            }
+            if (!wav.write(block_.data(), symbol_length_)) return false;
+        }
+        return fill(wav, slot_samples - lead - signal);
+    }
+
+private:
+    static bool is_active(const Transmission& tx, long slot) {
+        return slot >= tx.first && slot <= tx.last && (slot - tx.first) % tx.step == 0;
+    }
+
+    void background(float* out, size_t n) {
+        if (sigma_ > 0.0f) noise_.fill(out, n, sigma_);
+        else memset(out, 0, n * sizeof(float));
+    }
+
+    bool fill(WavWriter& wav, size_t n) {
+        while (n > 0) {
+            size_t len = n < block_.size() ? n : block_.size();
+            background(block_.data(), len);
+            if (!wav.write(block_.data(), len)) return false;
+            n -= len;
+        }
+        return true;
+    }
+
+    const Schedule& sched_;
+    int rate_;
+    int symbol_length_;
+    float sigma_;
+    GaussianNoise noise_;
+    std::vector<float> block_;
+    std::vector<float> sym_;
+};
+
+int main(int argc, char** argv) {
+    double hours = -1.0;
+    double snr = 0.0;
+    bool noise = false;
+    uint64_t seed = 1;
+    int rate = SAMPLE_RATE;
+    const char* output = NULL;
+    const char* prefix = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:S:r:o:p:")) != -1) {
+        switch (opt) {
+        case 't': hours = std::atof(optarg); break;
+        case 's': snr = std::atof(optarg); noise = true; break;
+        case 'S': seed = std::strtoull(optarg, NULL, 10); break;
+        case 'r': rate = std::atoi(optarg); break;
+        case 'o': output = optarg; break;
+        case 'p': prefix = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (argc - optind != 1 || (output == NULL) == (prefix == NULL)) {
+        usage(argv[0]);
+        return 1;
+    }
+    // WSPR symbols are 8192 samples at 12 kHz; keep them a whole number of samples
+    if (rate < 8000 || (long)rate * 8192 % 12000 != 0) {
+        std::fprintf(stderr, "Error: Sample rate must be at least 8000 and a multiple of 375 Hz\n");
+        return 1;
+    }
+    int symbol_length = (int)((long)rate * 8192 / 12000);
+
+    Schedule sched;
+    if (!load_schedule(argv[optind], rate, symbol_length, sched)) return 2;
+
+    long slots;
+    if (hours >= 0.0) {
+        slots = (long)std::ceil(hours * 3600.0 / SLOT_SECONDS);
+    } else {
+        slots = 0;
+        for (size_t i = 0; i < sched.entries.size(); i++) {
+            const Transmission& tx = sched.entries[i];
+            long end = tx.first + (tx.last - tx.first) / tx.step * tx.step + 1;
+            if (end > slots) slots = end;
+        }
+    }
+    if (slots <= 0) {
+        std::fprintf(stderr, "Error: Nothing to render; give a duration with -t\n");
+        return 1;
+    }
+
+    size_t slot_samples = (size_t)SLOT_SECONDS * rate;
+    if (output && (double)slots * slot_samples * sizeof(int16_t) > 0xFFFFFFFFu - sizeof(WavHeader)) {
+        std::fprintf(stderr, "Error: %ld slots exceed the 4 GiB WAV limit; use -p or a lower rate\n", slots);
+        return 1;
+    }
+
+    float sigma = noise ? (float)awgn_sigma(0.5, snr, rate) : 0.0f;
+    SlotRenderer renderer(sched, rate, symbol_length, sigma, seed);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    WavWriter wav;
+    if (output && !wav.open(output, rate)) return 5;
+
+    long transmissions = 0;
+    for (long slot = 0; slot < slots; slot++) {
+        if (prefix) {
+            char name[1024];
+            std::snprintf(name, sizeof(name), "%s_%06ld.wav", prefix, slot);
+            if (!wav.open(name, rate)) return 5;
+        }
+        transmissions += renderer.active_count(slot);
+        if (!renderer.render(slot, wav)) {
+            wav.close();
+            return 5;
+        }
+        if (prefix && !wav.close()) return 5;
+    }
+    if (output && !wav.close()) return 5;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    double audio = (double)slots * SLOT_SECONDS;
+    std::printf("%ld slots (%.2f h), %ld transmissions, %zu messages, %zu offsets at %d Hz → %s%s\n",
+                slots, audio / 3600.0, transmissions, sched.symbols.size(), sched.caches.size(),
+                rate, output ? output : prefix, output ? "" : "_*.wav");
+    std::printf("Rendered in %.2f s, %.0fx real time\n", elapsed, audio / elapsed);
+    return 0;
+}
@@ -1,17 +1,72 @@
 // wsprsim.cpp
 //
-// Build (assuming JTEncode built into libjtencode.a and JTEncode.h in ../JTEncode/src):
-//   g++ wspr_sim.cpp -I../JTEncode/src -L../JTEncode -ljtencode -o wspr_sim
+// Build (builds libjtencode.a from src/ and libwsprsim.a from sim/):
+//   make wsprsim
 //
 // Usage:
-//   ./wspr_sim KJ6ABC FN31pr 37
+//   ./wsprsim [-m 2|15] [-s SNR] [-S SEED] [-f FADING]
+//             [-t DT] [-d DRIFT] [-q DRIFT2] [-p PPM]
+//             [-T FROM:TO:STEP] [-D FROM:TO:STEP] [-j THREADS] [-R UNITS]
+//             [-o SINK | -x COMMAND] [-a] [-C DIR[:MAX_MB]] KJ6ABC FN31pr 37
+//
+//   -m   WSPR-2 (default) or WSPR-15 timing: 8x symbol length, 1/8 tone
+//        spacing. WSPR-15 audio is streamed, so memory use stays flat.
+//   -s   add white Gaussian noise for this SNR in 2500 Hz, as in WSJT-X
+//        wsprsim; no noise at 40 dB or more (the default). The normal and
+//        altered outputs get the same noise, so they differ only in sync.
+//   -S   noise and fading seed (default 1)
+//   -f   Watterson fading before the noise: a preset (good, moderate,
+//        poor, flutter, or ITU-R F.1487 low-/mid-/high- quiet, moderate,
+//        disturbed) or DELAY_MS:SPREAD_HZ for two equal paths. Both
+//        outputs fade identically. WAV output is delayed 2.6 ms by the
+//        channel's Hilbert filter.
+//   -t   start offset in seconds from the nominal 1 s, any fraction of a
+//        sample (polyphase fractional delay)
+//   -d   linear frequency drift in Hz per minute about mid-transmission
+//   -q   quadratic frequency drift in Hz per minute^2
+//   -p   sample clock error in ppm (positive = sound card runs fast)
+//   -T   render a grid of start offsets instead of the single WAV/.c2
+//        pair, e.g. -T -2:4:0.1 in place of sox trim loops
+//   -D   render a grid of linear drifts, alone or crossed with -T
+//   -j   threads for rendering (default: all cores): the four WAV/.c2
+//        files at once, or the grid points
+//   -R   also write wspr.rfs, a binary schedule (sim/rfsched.h) of the
+//        normal then the altered message's absolute RF frequencies, in
+//        millihz (integer millihertz) or word:REF_HZ[:BITS] DDS tuning
+//        words
+//   -o   write only the normal WAV, to SINK, and no other files: - for
+//        stdout, a named pipe, or any path; a raw: prefix (raw:-) sends
+//        bare 16-bit PCM. Streams carry a WAV header with unknown sizes.
+//   -x   render the normal WAV into memory (a memfd) and run COMMAND on
+//        it, {} standing for its /proc/self/fd/N path, e.g. -x "aplay {}";
+//        no files are written and COMMAND's exit status is returned
+//   -a   with -o or -x, the altered variant instead of the normal one
+//   -C   artifact cache (sim/artifact.h) of at most MAX_MB (default
+//        1024): each .wav and .c2, grid points too, is looked up by a hash
+//        of everything that shapes it and cloned or copied into place
+//        on a hit; misses are rendered and added. Hits and misses are
+//        printed.
+//
+//   With -o or -x progress goes to stderr, so stdout stays clean:
+//     ./wsprsim -o - W1AW FN42 30 | sox -t wav - -r 12000 wspr.wav
+//     ./wsprsim -o raw:- W1AW FN42 30 | aplay -f S16_LE -r 48000
+//     mkfifo tx.wav; ./wsprsim -o tx.wav W1AW FN42 30 & aplay tx.wav
+//
+//   Grid points are written as .c2 files, which wsprd reads directly:
+//   wspr_normal_dt+0.10_drift-1.00.c2, wspr_altered_dt+0.10_drift-1.00.c2, ...
 //
 // Outputs:
 //   wspr_normal.bits    (162 bytes: raw 0/1 symbols)
 //   wspr_normal.rf      (162 frequency values for RF transmission)
+//   wspr_normal.wav     (48 kHz audio centered on 1500 Hz)
+//   wspr_normal.c2      (wsprd baseband file, type 2 or 15)
 //   wspr_altered.bits   (162 bytes: inverted symbols)
 //   wspr_altered.rf     (162 frequency values for altered RF transmission)
+//   wspr_altered.wav
+//   wspr_altered.c2
+//   wspr.rfs            (with -R)
 
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
@@ -19,144 +74,56 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <iomanip>
+#include <functional>
 #include <iostream>
 #include <cctype>
 #include <regex>
+#include <string>
+#include <unistd.h>
 #include "src/JTEncode.h"
+#include "sim/wspr_params.h"
+#include "sim/artifact.h"
+#include "sim/c2file.h"
+#include "sim/fading.h"
+#include "sim/noise.h"
+#include "sim/parallel.h"
+#include "sim/rfsched.h"
+#include "sim/sink.h"
+#include "sim/timing.h"
+#include "sim/wspr_stream.h"
+#include "sim/wspr_message.h"
+#include "sim/wspr_sync.h"
+#include "sim/synth.h"
+#include "sim/wav.h"
 
-// Audio parameters (matching wsprsimwav.c)
-const int    SAMPLE_RATE   = 48000;             // 48kHz sampling rate
-const int    SYMBOL_LENGTH = 32768;             // samples per symbol
-const double CENTER_FREQ   = 1500.0;           // center frequency (Hz)
-const double FREQ_SPACING  = 48000.0 / 32768;  // = 1.46484375 Hz spacing
-const int    DELAY_SAMPLES = 48000;             // 1 second delay
-const int    SIGNAL_LENGTH = SYMBOL_LENGTH * WSPR_SYMBOL_COUNT;  // total samples
-const int    SLOPE_SAMPLES = 0.02 * SAMPLE_RATE;  // 20ms slope
-// Total samples: each symbol plus one-second delays at start/end
-const int    TOTAL_SAMPLES = SIGNAL_LENGTH + 2 * DELAY_SAMPLES;  // =162*32768 + 2*48000 = 5404416 samples
-
-// WAV file header structure
-struct WavHeader {
-    char     riff[4] = {'R', 'I', 'F', 'F'};
-    uint32_t chunk_size;
-    char     wave[4] = {'W', 'A', 'V', 'E'};
-    char     fmt[4] = {'f', 'm', 't', ' '};
-    uint32_t subchunk1_size = 16;
-    uint16_t audio_format = 1;  // PCM
-    uint16_t num_channels = 1;  // mono
-    uint32_t sample_rate = SAMPLE_RATE;
-    uint32_t byte_rate = SAMPLE_RATE * 2;  // 16-bit samples
-    uint16_t block_align = 2;
-    uint16_t bits_per_sample = 16;
-    char     data[4] = {'d', 'a', 't', 'a'};
-    uint32_t subchunk2_size;
-};
-
-// Validate WSPR callsign format
-bool validate_callsign(const char* call) {
-    if (!call || strlen(call) == 0 || strlen(call) > 12) {
-        return false;
-    }
-    
-    // Basic WSPR callsign validation:
-    // - Must contain at least one letter
-    // - Can contain letters, digits, '/', '<', '>'
-    // - Must not be just numbers or symbols
-    
-    bool has_letter = false;
-    bool has_digit = false;
-    int len = strlen(call);
-    
-    for (int i = 0; i < len; i++) {
-        char c = call[i];
-        if (isalpha(c)) {
-            has_letter = true;
-        } else if (isdigit(c)) {
-            has_digit = true;
-        } else if (c != '/' && c != '<' && c != '>') {
-            return false; // Invalid character
-        }
-    }
-    
-    // Must have at least one letter for valid callsign
-    return has_letter;
-}
-
-// Validate WSPR grid locator format
-bool validate_grid(const char* grid) {
-    if (!grid) return false;
-    
-    int len = strlen(grid);
-    if (len != 4 && len != 6) {
-        return false;
-    }
-    
-    // Format: AA00 or AA00AA
-    // First 2: A-R
-    // Next 2: 0-9
-    // Last 2 (if present): A-X
-    //
-    
-    
-    if (len >= 2) {
-        for (int i = 0; i < 2; i++) {
-            char c = toupper(grid[i]);
-            if (c < 'A' || c > 'R') {
-                return false;
-            }
-        }
-    }
-    
-    if (len >= 4) {
-        for (int i = 2; i < 4; i++) {
-            if (!isdigit(grid[i])) {
-                return false;
-            }
-        }
-    }
-    
-    if (len == 6) {
-        for (int i = 4; i < 6; i++) {
-            char c = toupper(grid[i]);
-            if (c < 'A' || c > 'X') {
-                return false;
-            }
-        }
-    }
-    
-    return true;
-}
-
-// Validate WSPR power level
-bool validate_power(int dbm) {
-    const int valid_dbm[] = {
-        -30, -27, -23, -20, -17, -13, -10, -7, -3, 
-        0, 3, 7, 10, 13, 17, 20, 23, 27, 30, 33, 37, 40,
-        43, 47, 50, 53, 57, 60
-    };
-    const int valid_count = sizeof(valid_dbm) / sizeof(valid_dbm[0]);
-    
-    for (int i = 0; i < valid_count; i++) {
-        if (dbm == valid_dbm[i]) {
-            return true;
-        }
-    }
-    return false;
-}
+// Dial frequency recorded in the .rf and .c2 headers
+const double DIAL_FREQ_MHZ = 14.0956;
+// wsprsim convention: no noise at or above this SNR
+const double NO_NOISE_SNR = 40.0;
+// Part of every cache key, with the executable's hash: that alone keeps a
+// rebuild with different code in wsprsim or sim/ from being served older
+// renders. Bump this when the key fields or cached file layout change.
+const char* RENDER_VERSION = "wsprsim-2";
 
-// Write RF frequency file *this writes a text file with one freq per line
-void write_rf(const char *fn, const uint8_t *syms) {
-    std::ofstream rf(fn);
-    rf << "# WSPR RF Frequency File\n";
-    rf << "# Frequency: 14095600\n";
-    rf << "# Each line contains frequency in Hz for one symbol\n";
-    
+// Write RF frequency file: the audio frequency of each symbol, one per
+// line, built in memory and written at once
+void write_rf(const char *fn, const uint8_t *syms, double spacing) {
+    std::string text = "# WSPR RF Frequency File\n# Frequency: ";
+    char line[32];
+    text.append(line, format_scaled(rf_millihertz(DIAL_FREQ_MHZ * 1e6) / 1000, 0, line));
+    text += "\n# Each line contains frequency in Hz for one symbol\n";
     for(int i = 0; i < WSPR_SYMBOL_COUNT; i++) {
         // Convert symbol to frequency: base + (symbol - 1.5) * spacing
-        double freq = CENTER_FREQ + ((double)syms[i] - 1.5) * FREQ_SPACING;
-        rf << std::fixed << std::setprecision(6) << freq << std::endl;
+        double freq = CENTER_FREQ + ((double)syms[i] - 1.5) * spacing;
+        size_t n = format_fixed(freq, 6, line);
+        line[n++] = '\n';
+        text.append(line, n);
     }
+    FILE* rf = std::fopen(fn, "w");
+    if (!rf || std::fwrite(text.data(), 1, text.size(), rf) != text.size()) {
+        std::fprintf(stderr, "Error: Cannot write %s\n", fn);
+    }
+    if (rf) std::fclose(rf);
 }
 
 // Save raw 0/1 bytes
@@ -165,117 +132,221 @@ void write_bits(const char *fn, const uint8_t *syms) {
     b.write(reinterpret_cast<const char*>(syms), WSPR_SYMBOL_COUNT);
 }
 
-// Calculate raised cosine slope for fade in/out
-double raised_cosine(double x) {
-    if (x <= -1.0 || x >= 1.0) return 0.0;
-    return 0.5 * (1.0 + cos(M_PI * x));
+// Write WAV file: WSPR-2 from the tone cache, WSPR-15 streamed
+bool write_wav(const char* filename, const uint8_t* symbols, int type, const ToneCache* cache,
+               float amplitude, const NoiseStage* noise, FadingChannel* fading,
+               const TimingImpairment* timing) {
+    if (type == 15 || timing) {
+        return write_wspr_wav(type, symbols, filename, amplitude, noise, fading, timing);
+    }
+    std::vector<float> signal;
+    render_wspr_signal(*cache, symbols, signal);
+    if (fading) fading->process(signal.data(), signal.size());
+    if (noise) {
+        // The cache renders at 0.5; rescale under the noise
+        float scale = amplitude / 0.5f;
+        for (size_t i = 0; i < signal.size(); i++) signal[i] *= scale;
+        noise->apply(signal.data(), 0, signal.size());
+    }
+    return write_wav_file(filename, signal.data(), signal.size(), SAMPLE_RATE);
 }
 
-// Volume envelope for fade in/out
-double volume_envelope(int sample_pos) {
-    if (sample_pos >= 0 && sample_pos < SLOPE_SAMPLES) {
-        // Fade in
-        return raised_cosine(1.0 - (double)sample_pos / SLOPE_SAMPLES);
+// Cache key of a rendered .wav or .c2: everything that shapes its samples
+ArtifactKey render_key(const char* kind, int type, const uint8_t* symbols, double snr, uint64_t seed,
+                       const std::vector<FadingTap>& taps, const TimingImpairment* timing) {
+    ArtifactKey key(RENDER_VERSION);
+    key.add("build", executable_hash());
+    key.add("kind", std::string(kind));
+    key.add("type", (long long)type);
+    key.add("symbols", symbols, WSPR_SYMBOL_COUNT);
+    if (snr < NO_NOISE_SNR) key.add("snr", snr);
+    if (snr < NO_NOISE_SNR || !taps.empty()) key.add("seed", (long long)seed);
+    for (size_t i = 0; i < taps.size(); i++) {
+        key.add("tap_delay", taps[i].delay);
+        key.add("tap_spread", taps[i].spread);
+        key.add("tap_shift", taps[i].shift);
+        key.add("tap_gain_db", taps[i].gain_db);
     }
-    if (sample_pos >= (SIGNAL_LENGTH - SLOPE_SAMPLES) && sample_pos < SIGNAL_LENGTH) {
-        // Fade out
-        int fade_pos = sample_pos - (SIGNAL_LENGTH - SLOPE_SAMPLES);
-        return raised_cosine((double)fade_pos / SLOPE_SAMPLES);
+    if (timing) {
+        key.add("dt", timing->dt);
+        key.add("drift", timing->drift);
+        key.add("drift2", timing->drift2);
+        key.add("ppm", timing->ppm);
     }
-    if (sample_pos >= 0 && sample_pos < SIGNAL_LENGTH) {
-        // Full volume
-        return 1.0;
-    }
-    // Outside signal range
-    return 0.0;
+    if (std::strcmp(kind, "c2") == 0) key.add("dial_mhz", DIAL_FREQ_MHZ);
+    return key;
 }
 
-// Generate WAV audio signal from WSPR symbols
-void generate_wav_signal(const uint8_t* symbols, std::vector<double>& signal) {
-    signal.resize(TOTAL_SAMPLES, 0.0);
-    
-    double phase = 0.0;
-    double two_pi_dt = 2.0 * M_PI / SAMPLE_RATE;
-    
-    for (int sym = 0; sym < WSPR_SYMBOL_COUNT; sym++) {
-        // Calculate frequency for this symbol
-        double freq = CENTER_FREQ + ((double)symbols[sym] - 1.5) * FREQ_SPACING; //maps 4 audio freqs spaced around the center freq
-        double dphi = two_pi_dt * freq; // uses the freqs to generate the phase since the phase changes wit the freqs
-        
-        // Generate samples for this symbol
-        for (int samp = 0; samp < SYMBOL_LENGTH; samp++) {
-            int total_pos = DELAY_SAMPLES + sym * SYMBOL_LENGTH + samp;//gets the absolute position of the signal vector where the sample should be stored
-            
-            if (total_pos < TOTAL_SAMPLES) {
-                // Use constant amplitude for now to isolate frequency issue
-                // vol envelope
-                int env_idx = total_pos- DELAY_SAMPLES;
-                double env = volume_envelope(env_idx);
-{
-                // apply fade‐in/out envelope
-                int env_idx = total_pos - DELAY_SAMPLES;
-                double env = volume_envelope(env_idx);
-                signal[total_pos] = 0.5 * env * sin(phase); // adds t
-            }
-                phase += dphi;
-            }
-        }
-        
-        // Keep phase continuous but normalize to prevent overflow
-        while (phase > 2.0 * M_PI) {
-            phase -= 2.0 * M_PI;
-        }
-        while (phase < -2.0 * M_PI) {
-            phase += 2.0 * M_PI;
-        }
+// Produce path from the cache, or render it and add it. The old file is
+// removed first: older versions hard linked read-only cache entries.
+bool cached_render(ArtifactCache& artifacts, const ArtifactKey& key, const char* path,
+                   const std::function<bool()>& render, bool& hit) {
+    hit = artifacts.fetch(key, path);
+    if (hit) return true;
+    if (unlink(path) != 0 && errno != ENOENT) {
+        std::fprintf(stderr, "Error: Cannot replace %s: %s\n", path, std::strerror(errno));
+        return false;
     }
+    if (!render()) return false;
+    // A render that could not be cached is still good: store() warns and
+    // counts the failure in the cache statistics
+    if (artifacts.is_open()) artifacts.store(key, path);
+    return true;
 }
 
-// Write WAV file
-void write_wav(const char* filename, const uint8_t* symbols) {
-    std::vector<double> signal;
-    generate_wav_signal(symbols, signal);
-    
-    // Create WAV header
-    WavHeader header;
-    header.subchunk2_size = signal.size() * 2; // 16-bit samples
-    header.chunk_size = 36 + header.subchunk2_size;
-    
-    std::ofstream wav(filename, std::ios::binary);
-    if (!wav) {
-        std::fprintf(stderr, "Error: Cannot create WAV file %s\n", filename);
-        return;
+// Parse FROM:TO:STEP into the list of values; a single number is a list of one
+bool parse_range(const char* text, std::vector<double>& values) {
+    double from, to, step;
+    char tail;
+    values.clear();
+    int n = std::sscanf(text, "%lf:%lf:%lf%c", &from, &to, &step, &tail);
+    if (n == 1) {
+        values.push_back(from);
+        return true;
     }
-    
-    // Write header
-    wav.write(reinterpret_cast<const char*>(&header), sizeof(header));
-    
-    // Write audio data (convert to 16-bit signed integers)
-    for (double sample : signal) {
-        // Clamp to [-1.0, 1.0] and convert to 16-bit
-        sample = std::max(-1.0, std::min(1.0, sample));
-        int16_t sample_16 = static_cast<int16_t>(sample * 32767);
-        wav.write(reinterpret_cast<const char*>(&sample_16), sizeof(sample_16));
+    if (n != 3 || step <= 0.0 || to < from) return false;
+    int count = (int)std::floor((to - from) / step + 1e-9) + 1;
+    // Round off the accumulated step error so 0 is not printed as -0.00
+    for (int i = 0; i < count; i++) values.push_back(std::round((from + i * step) * 1e9) / 1e9);
+    return true;
+}
+
+// Render every (dt, drift) point of a grid for both symbol sets as .c2
+// files, sharing the work between threads. Each file is independent:
+// same noise and fading seed, its own fading channel.
+bool render_grid(int type, const uint8_t* normal_syms, const uint8_t* alt_syms,
+                 const std::vector<double>& dts, const std::vector<double>& drifts,
+                 const TimingImpairment& base, const NoiseStage* noise, double snr,
+                 const std::vector<FadingTap>* taps, uint64_t seed, int threads,
+                 ArtifactCache& artifacts) {
+    size_t points = dts.size() * drifts.size();
+    std::vector<char> ok(2 * points, 0);
+    parallel_for(2 * points, threads, [&](size_t job) {
+        size_t point = job / 2;
+        bool altered = job % 2 != 0;
+        TimingImpairment timing = base;
+        timing.dt = dts[point / drifts.size()];
+        timing.drift = drifts[point % drifts.size()];
+
+        char name[96];
+        std::snprintf(name, sizeof(name), "wspr_%s_dt%+.2f_drift%+.2f.c2",
+                      altered ? "altered" : "normal", timing.dt, timing.drift);
+        const uint8_t* syms = altered ? alt_syms : normal_syms;
+        std::vector<FadingTap> no_taps;
+        bool hit;
+        ok[job] = cached_render(artifacts, render_key("c2", type, syms, snr, seed, taps ? *taps : no_taps, &timing),
+                                name, [&]() {
+            FadingChannel fading(taps ? *taps : no_taps, c2_sample_rate(type), seed);
+            return write_wspr_c2(type, syms, name, DIAL_FREQ_MHZ, 1.0f, noise, taps ? &fading : NULL, &timing);
+        }, hit);
+    });
+
+    bool all = true;
+    for (size_t job = 0; job < ok.size(); job++) {
+        if (!ok[job]) all = false;
     }
-    
-    wav.close();
+    std::printf("→ %zu grid points (%zu DT x %zu drift), %zu .c2 files\n",
+                points, dts.size(), drifts.size(), ok.size());
+    return all;
 }
 
 int main(int argc, char** argv) {
-    if(argc != 4) {
-        std::fprintf(stderr, "Usage: %s CALLSIGN GRID POWER_dBm\n", argv[0]);
+    int type = 2;
+    double snr = NO_NOISE_SNR;
+    uint64_t seed = 1;
+    const char* fading_spec = NULL;
+    std::vector<FadingTap> taps;
+    TimingImpairment timing = NO_TIMING_IMPAIRMENT;
+    bool impaired = false;
+    const char* dt_grid = NULL;
+    const char* drift_grid = NULL;
+    int threads = default_thread_count();
+    const char* rf_units = NULL;
+    RfScheduleFormat rf_format;
+    const char* sink = NULL;
+    const char* command = NULL;
+    bool sink_altered = false;
+    const char* cache_spec = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:s:S:f:t:d:q:p:T:D:j:R:o:x:aC:")) != -1) {
+        switch (opt) {
+        case 'm': type = std::atoi(optarg); break;
+        case 's': snr = std::atof(optarg); break;
+        case 'S': seed = std::strtoull(optarg, NULL, 10); break;
+        case 'f': fading_spec = optarg; break;
+        case 't': timing.dt = std::atof(optarg); impaired = true; break;
+        case 'd': timing.drift = std::atof(optarg); impaired = true; break;
+        case 'q': timing.drift2 = std::atof(optarg); impaired = true; break;
+        case 'p': timing.ppm = std::atof(optarg); impaired = true; break;
+        case 'T': dt_grid = optarg; break;
+        case 'D': drift_grid = optarg; break;
+        case 'j': threads = std::atoi(optarg); break;
+        case 'R': rf_units = optarg; break;
+        case 'o': sink = optarg; break;
+        case 'x': command = optarg; break;
+        case 'a': sink_altered = true; break;
+        case 'C': cache_spec = optarg; break;
+        default: type = 0; break;
+        }
+    }
+    std::vector<double> dts(1, timing.dt), drifts(1, timing.drift);
+    if ((dt_grid && !parse_range(dt_grid, dts)) || (drift_grid && !parse_range(drift_grid, drifts))) {
+        std::fprintf(stderr, "Error: Grid must be FROM:TO:STEP with TO >= FROM and STEP > 0\n");
+        return 1;
+    }
+    if (rf_units && !parse_rf_units(rf_units, rf_format)) {
+        std::fprintf(stderr, "Error: Schedule units must be millihz or word:REF_HZ[:BITS], got '%s'\n", rf_units);
+        return 1;
+    }
+    if ((sink && command) || ((sink || command) && (dt_grid || drift_grid || rf_units || cache_spec))) {
+        std::fprintf(stderr, "Error: -o and -x exclude each other, -R, -C and the -T/-D grids\n");
+        return 1;
+    }
+    if (sink_altered && !sink && !command) {
+        std::fprintf(stderr, "Error: -a selects the variant for -o or -x and needs one of them\n");
+        return 1;
+    }
+    ArtifactCache artifacts;
+    if (cache_spec) {
+        std::string dir;
+        uint64_t max_bytes;
+        if (!parse_cache_spec(cache_spec, dir, max_bytes)) {
+            std::fprintf(stderr, "Error: Cache must be DIR or DIR:MAX_MB, got '%s'\n", cache_spec);
+            return 1;
+        }
+        if (!artifacts.open(dir.c_str(), max_bytes)) return 1;
+    }
+    if (fading_spec && !parse_fading_taps(fading_spec, taps)) {
+        std::fprintf(stderr, "Error: Unknown fading '%s'\n", fading_spec);
+        std::fprintf(stderr, "Use DELAY_MS:SPREAD_HZ or one of: %s\n", fading_profile_names());
+        return 1;
+    }
+    if(argc - optind != 3 || !wspr_mode(type)) {
+        std::fprintf(stderr, "Usage: %s [-m 2|15] [-s SNR] [-S SEED] [-f FADING] [-t DT] [-d DRIFT]\n"
+                             "       [-q DRIFT2] [-p PPM] [-T FROM:TO:STEP] [-D FROM:TO:STEP] [-j THREADS]\n"
+                             "       [-R UNITS] [-o SINK | -x COMMAND] [-a] [-C DIR[:MAX_MB]]\n"
+                             "       CALLSIGN GRID POWER_dBm\n", argv[0]);
         std::fprintf(stderr, "\nExamples:\n");
         std::fprintf(stderr, "  %s VK3ABC FM04 20\n", argv[0]);
         std::fprintf(stderr, "  %s W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -m 15 W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -s -24 W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -s -20 -f poor W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -t 0.37 -d 2 -p 50 W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -s -20 -T -2:4:0.1 -D -4:4:1 W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -o - W1AW FN42 30 | aplay\n", argv[0]);
+        std::fprintf(stderr, "  %s -a -x \"sox {} -r 12000 alt.wav\" W1AW FN42 30\n", argv[0]);
+        std::fprintf(stderr, "  %s -C ~/.cache/wsprsim:2048 -s -20 W1AW FN42 30\n", argv[0]);
         return 1;
     }
     
-    const char* call = argv[1];
-    const char* grid = argv[2];
-    int dbm = std::atoi(argv[3]);
+    const char* call = argv[optind];
+    const char* grid = argv[optind + 1];
+    int dbm = std::atoi(argv[optind + 2]);
     
     // Validate callsign
-    if (!validate_callsign(call)) {
+    if (!wspr_valid_call(call)) {
         std::fprintf(stderr, "Error: Invalid callsign '%s'\n", call);
         std::fprintf(stderr, "Callsign must contain at least one letter and only valid characters (A-Z, 0-9, /, <, >)\n");
         std::fprintf(stderr, "Examples: VK3ABC, W1AW, PJ4/K1ABC, <PJ4/K1ABC>\n");
@@ -283,7 +354,7 @@ int main(int argc, char** argv) {
     }
     
     // Validate grid locator
-    if (!validate_grid(grid)) {
+    if (!wspr_valid_grid(grid)) {
         std::fprintf(stderr, "Error: Invalid grid locator '%s'\n", grid);
         std::fprintf(stderr, "Grid must be 4 or 6 characters in format AA00 or AA00AA\n");
         std::fprintf(stderr, "Examples: FM04, FN42, CN85NM\n");
@@ -291,7 +362,7 @@ int main(int argc, char** argv) {
     }
     
     // Validate power level
-    if (!validate_power(dbm)) {
+    if (!wspr_valid_dbm(dbm)) {
         std::fprintf(stderr, "Error: Invalid power level %d dBm\n", dbm);
         std::fprintf(stderr, "Valid power levels: -30, -27, -23, -20, -17, -13, -10, -7, -3,\n");
         std::fprintf(stderr, "                    0, 3, 7, 10, 13, 17, 20, 23, 27, 30, 33, 37, 40,\n");
@@ -303,50 +374,138 @@ int main(int argc, char** argv) {
     uint8_t normal_syms[WSPR_SYMBOL_COUNT];
     uint8_t alt_syms   [WSPR_SYMBOL_COUNT];
     JTEncode encoder;
+    const MfskMode& mode = *wspr_mode(type);
+    ToneCache* cache = type == 2 ? new ToneCache(make_wspr_tone_cache()) : NULL;
+
+    // Noise at a fixed level with the signal scaled to the SNR, so strong
+    // noise does not clip the 16-bit WAV
+    float wav_amplitude = 0.5f;
+    NoiseStage* wav_noise = NULL;
+    if (snr < NO_NOISE_SNR) {
+        wav_amplitude = (float)snr_amplitude(AUDIO_NOISE_SIGMA, snr, SAMPLE_RATE);
+        wav_noise = new NoiseStage(SAMPLE_RATE, AUDIO_NOISE_SIGMA, seed);
+    }
     encoder.wspr_encode(call,
                     grid,
                     static_cast<int8_t>(dbm),
                     normal_syms);
 
+    // The altered variant shares the encode: the sync bit inverted
+    make_altered_symbols(normal_syms, alt_syms);
 
-    // 2) Dump normal bits + RF + WAV
+    // 1b) Or a single WAV straight to a stream or an in-memory file
+    if (sink || command) {
+        MemFile memory;
+        const char* variant = sink_altered ? "wspr_altered.wav" : "wspr_normal.wav";
+        if (command && !memory.create(variant)) return 5;
+        std::string path = command ? memory.path() : sink;
+        bool ok;
+        {
+            FadingChannel wav_fading(taps, SAMPLE_RATE, seed);
+            ok = write_wav(path.c_str(), sink_altered ? alt_syms : normal_syms, type, cache, wav_amplitude,
+                           wav_noise, fading_spec ? &wav_fading : NULL, impaired ? &timing : NULL);
+        }
+        delete cache;
+        delete wav_noise;
+        if (!ok) return 5;
+        if (!command) return 0;
+        std::fprintf(stderr, "→ %s in memory (%zu bytes) as %s\n", variant, memory.size(), path.c_str());
+        int status = run_with_path(command, path);
+        return status < 0 ? 5 : status;
+    }
+
+    NoiseStage* c2_noise = NULL;
+    if (snr < NO_NOISE_SNR) {
+        c2_noise = new NoiseStage(c2_sample_rate(type), awgn_sigma_iq(1.0, snr, c2_sample_rate(type)), seed);
+    }
+
+    // 2) Dump bits + RF of both variants
     write_bits("wspr_normal.bits", normal_syms);
     std::puts("→ wspr_normal.bits");
-    write_rf("wspr_normal.rf", normal_syms);
+    write_rf("wspr_normal.rf", normal_syms, mode.tone_spacing);
     std::puts("→ wspr_normal.rf");
-    write_wav("wspr_normal.wav", normal_syms);
-    std::puts("→ wspr_normal.wav");
-   //inverting the sync bits for altered 
-    const uint8_t sync_vector[WSPR_SYMBOL_COUNT] = {
-    1, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 0, 0, 1, 0, 0,
-    1, 0, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1, 0, 0,
-    0, 0, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 0, 1,
-    0, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-    1, 1, 0, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1,
-    0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1,
-    1, 1, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-    1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0
-    };
+    write_bits("wspr_altered.bits", alt_syms);
+    std::puts("→ wspr_altered.bits");
+    write_rf("wspr_altered.rf", alt_syms, mode.tone_spacing);
+    std::puts("→ wspr_altered.rf");
 
-    for (int i = 0; i < WSPR_SYMBOL_COUNT; ++i) {
-      uint8_t d = (normal_syms[i] >> 1) & 1;       // extract data bit
-      uint8_t s = sync_vector[i] ^ 1;              // invert sync bit
-      alt_syms[i] = s + 2 * d;                     // rebuild symbol
+    // 3) Render every WAV + C2 at once, one task per file, so the run
+    //    takes as long as the slowest file. Each comes from the artifact
+    //    cache when it has it.
+    bool grid_mode = dt_grid || drift_grid;
+    const TimingImpairment* wav_timing = impaired ? &timing : NULL;
+    bool files_ok = true;
+    if (!grid_mode) {
+        struct Output {
+            const char* path;
+            const uint8_t* syms;
+            bool c2;
+            bool hit;
+            bool ok;
+        };
+        Output outputs[4] = {{"wspr_normal.wav", normal_syms, false, false, false},
+                             {"wspr_normal.c2", normal_syms, true, false, false},
+                             {"wspr_altered.wav", alt_syms, false, false, false},
+                             {"wspr_altered.c2", alt_syms, true, false, false}};
+        parallel_for(4, threads, [&](size_t k) {
+            Output& out = outputs[k];
+            if (out.c2) {
+                out.ok = cached_render(artifacts, render_key("c2", type, out.syms, snr, seed, taps, &timing), out.path, [&]() {
+                    FadingChannel c2_fading(taps, c2_sample_rate(type), seed);
+                    return write_wspr_c2(type, out.syms, out.path, DIAL_FREQ_MHZ, 1.0f, c2_noise,
+                                         fading_spec ? &c2_fading : NULL, &timing);
+                }, out.hit);
+                return;
+            }
+            out.ok = cached_render(artifacts, render_key("wav", type, out.syms, snr, seed, taps, wav_timing), out.path, [&]() {
+                FadingChannel wav_fading(taps, SAMPLE_RATE, seed);
+                return write_wav(out.path, out.syms, type, cache, wav_amplitude, wav_noise,
+                                 fading_spec ? &wav_fading : NULL, wav_timing);
+            }, out.hit);
+        });
+        for (int k = 0; k < 4; k++) {
+            if (outputs[k].ok) {
+                std::printf("→ %s%s\n", outputs[k].path, outputs[k].hit ? " (cached)" : "");
+            } else {
+                std::fprintf(stderr, "Error: Could not write %s\n", outputs[k].path);
+                files_ok = false;
+            }
+        }
     }
 
+    if (rf_units) {
+        RfScheduleWriter schedule;
+        bool ok = schedule.open("wspr.rfs", mode, DIAL_FREQ_MHZ, rf_format) &&
+                  schedule.add(normal_syms, mode.default_base) && schedule.add(alt_syms, mode.default_base);
+        if (!schedule.close() || !ok) return 5;
+        std::puts("→ wspr.rfs");
+    }
 
-
-    // 4) Dump altered bits + RF + WAV
-    write_bits("wspr_altered.bits", alt_syms);
-    std::puts("→ wspr_altered.bits");
-    write_rf("wspr_altered.rf", alt_syms);
-    std::puts("→ wspr_altered.rf");
-    write_wav("wspr_altered.wav", alt_syms);
-    std::puts("→ wspr_altered.wav");
+    bool grid_ok = !grid_mode || render_grid(type, normal_syms, alt_syms, dts, drifts, timing, c2_noise, snr,
+                                             fading_spec ? &taps : NULL, seed, threads, artifacts);
+    delete cache;
+    delete wav_noise;
+    delete c2_noise;
+    if (artifacts.is_open()) {
+        artifacts.trim();
+        artifacts.print_stats(stdout);
+    }
+    if (!grid_ok) {
+        std::fprintf(stderr, "Error: Could not write every grid file\n");
+        return 5;
+    }
+    if (!files_ok) return 5;
 
     std::puts("\nSimulation complete. You now have:");
-    std::puts(" - wspr_normal.bits, wspr_normal.rf, wspr_normal.wav");
-    std::puts(" - wspr_altered.bits, wspr_altered.rf, wspr_altered.wav");
+    if (grid_mode) {
+        std::puts(" - wspr_normal.bits, wspr_normal.rf, wspr_normal_dt*_drift*.c2");
+        std::puts(" - wspr_altered.bits, wspr_altered.rf, wspr_altered_dt*_drift*.c2");
+        if (rf_units) std::puts(" - wspr.rfs");
+        return 0;
+    }
+    std::puts(" - wspr_normal.bits, wspr_normal.rf, wspr_normal.wav, wspr_normal.c2");
+    std::puts(" - wspr_altered.bits, wspr_altered.rf, wspr_altered.wav, wspr_altered.c2");
+    if (rf_units) std::puts(" - wspr.rfs");
     return 0;
 }
 